@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bf.h"
+#include "ht_table.h"
+#include "aggregate.h"
+
+#define RECORDS_NUM 20000 // you can change it if you want
+#define FILE_NAME "data.db"
+#define EXPORT_NAME "export.csv"
+#define MAX_CITIES 100
+
+// Returns the seconds since some fixed point.
+static double now(){
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// HT_ScanCallback that writes the record as a line of a csv file.
+static int exportRecord(const Record* record, void* argument){
+    fprintf(argument, "%d,%s,%s,%s\n", record->id, record->name, record->surname, record->city);
+    return 0;
+}
+
+// The way we counted the people per city before: export every record and
+// read the file back, like a script does. Returns the number of cities.
+static int exportAndCount(HT_info* info){
+    FILE* file = fopen(EXPORT_NAME, "w");
+    HT_Scan(info, NULL, exportRecord, file);
+    fclose(file);
+
+    char cities[MAX_CITIES][20];
+    int counts[MAX_CITIES];
+    int numOfCities = 0;
+    char line[128];
+    file = fopen(EXPORT_NAME, "r");
+    while(fgets(line, sizeof(line), file) != NULL){
+        strtok(line, ",");
+        strtok(NULL, ",");
+        strtok(NULL, ",");
+        char* city = strtok(NULL, "\n");
+        int c = 0;
+        while(c < numOfCities && strcmp(cities[c], city))
+            c++;
+        if(c == numOfCities){
+            strcpy(cities[numOfCities], city);
+            counts[numOfCities++] = 0;
+        }
+        counts[c]++;
+    }
+    fclose(file);
+    remove(EXPORT_NAME);
+    return numOfCities;
+}
+
+// AGG_Callback that only counts the group, so the timed aggregation prints nothing,
+// like exportAndCount.
+static int countGroup(const AGG_Group* group, void* argument){
+    (void)group;
+    (*(int*)argument)++;
+    return 0;
+}
+
+// AGG_Callback that prints the group.
+static int printGroup(const AGG_Group* group, void* argument){
+    (void)argument;
+    AGG_PrintGroup(group, CITY);
+    return 0;
+}
+
+int main() {
+    BF_Init(LRU);
+
+    HT_CreateFile(FILE_NAME, 100);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    srand(12569874);
+    printf("Insert Entries\n");
+    for (int id = 0; id < RECORDS_NUM; ++id)
+        HT_InsertEntry(info, randomRecord());
+
+    printf("RUN AGG_GroupBy city\n");
+    AGG_options options = AGG_DefaultOptions(CITY);
+    int numOfGroups = 0;
+    double start = now();
+    AGG_GroupBy(info, NULL, &options, countGroup, &numOfGroups);
+    double aggregateSeconds = now() - start;
+    AGG_GroupBy(info, NULL, &options, printGroup, NULL);
+
+    start = now();
+    int numOfCities = exportAndCount(info);
+    double exportSeconds = now() - start;
+
+    printf("AGG_GroupBy: %d groups in %f seconds\n", numOfGroups, aggregateSeconds);
+    printf("Export and count: %d groups in %f seconds\n", numOfCities, exportSeconds);
+
+    HT_CloseFile(info);
+    BF_Close();
+}
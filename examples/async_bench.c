@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "bf.h"
+#include "bf_ext.h"
+#include "bf_async.h"
+
+#define BLOCKS_NUM 20000 // you can change it if you want
+#define LOOKUPS_NUM 4000
+#define FILE_NAME "async_bench.db"
+
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// Returns the seconds since some fixed point.
+static double now(){
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// Drops the blocks of the file from the page cache of the OS, so the lookups read the device.
+// Dirty pages are not dropped, so the file is written back first. The file systems that keep
+// everything in memory, e.g. tmpfs, ignore it.
+// Returns the fraction of the pages of the file that are still inside the page cache.
+static double dropPageCache(){
+    int osFileDesc = open(FILE_NAME, O_RDONLY);
+    fsync(osFileDesc);
+    posix_fadvise(osFileDesc, 0, 0, POSIX_FADV_DONTNEED);
+
+    size_t size = (size_t)BLOCKS_NUM * BF_BLOCK_SIZE;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    size_t numOfPages = (size + pageSize - 1) / pageSize;
+    unsigned char* resident = malloc(numOfPages);
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, osFileDesc, 0);
+    size_t numOfResident = 0;
+    if(mapping != MAP_FAILED && mincore(mapping, size, resident) == 0)
+        for(size_t p = 0; p < numOfPages; p++)
+            numOfResident += resident[p] & 1;
+    if(mapping != MAP_FAILED)
+        munmap(mapping, size);
+    free(resident);
+    close(osFileDesc);
+    return (double)numOfResident / numOfPages;
+}
+
+// The handles of the requests that are not in flight, and the number of completed requests.
+typedef struct {
+    BF_Block** freeBlocks;
+    int numOfFree;
+    int numOfCompleted;
+} Lookups;
+
+// BF_AsyncCallback that unpins the block, counts it and frees its handle.
+static void countBlock(BF_ErrorCode code, BF_Block* block, int blockId, void* argument){
+    (void)blockId;
+    Lookups* lookups = argument;
+    if(code != BF_OK){
+        BF_PrintError(code);
+        exit(code);
+    }
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    lookups->numOfCompleted++;
+    lookups->freeBlocks[lookups->numOfFree++] = block;
+}
+
+// Reads the blocks of lookups one after the other with BF_GetBlock, and prints the lookups per second.
+static void measureSync(const int* lookups){
+    double cached = dropPageCache();
+    BF_Init(LRU);
+    int fileDesc;
+    CALL_OR_DIE(BF_OpenFile(FILE_NAME, &fileDesc));
+    BF_Block* block;
+    BF_Block_Init(&block);
+    double start = now();
+    for(int i = 0; i < LOOKUPS_NUM; i++){
+        CALL_OR_DIE(BF_GetBlock(fileDesc, lookups[i], block));
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+    double seconds = now() - start;
+    BF_Block_Destroy(&block);
+    CALL_OR_DIE(BF_CloseFile(fileDesc));
+    BF_Close();
+    printf("%-28s %12.0f lookups/s %8.1f%% cached\n", "BF_GetBlock", LOOKUPS_NUM / seconds, 100 * cached);
+}
+
+// Reads the blocks of lookups with depth requests in flight, and prints the lookups per second.
+static void measureAsync(const int* lookups, BF_AsyncBackend backend, int depth){
+    BF_AsyncQueue* queue = BF_AsyncCreate(depth, backend);
+    if(queue == NULL){
+        printf("%-28s not available\n", backend == BF_ASYNC_IO_URING ? "io_uring" : "threads");
+        return;
+    }
+    double cached = dropPageCache();
+    BF_Init(LRU);
+    int fileDesc;
+    CALL_OR_DIE(BF_OpenFileWithPrefetch(FILE_NAME, &fileDesc));
+    Lookups done;
+    done.freeBlocks = malloc(depth * sizeof(BF_Block*));
+    for(int d = 0; d < depth; d++)
+        BF_Block_Init(&done.freeBlocks[d]);
+    done.numOfFree = depth;
+    done.numOfCompleted = 0;
+
+    // At most depth requests are in flight, every one with a free handle.
+    double start = now();
+    for(int i = 0; i < LOOKUPS_NUM; i++){
+        if(done.numOfFree == 0 && BF_AsyncComplete(queue, 1) < 0){
+            printf("%-28s failed\n", backend == BF_ASYNC_IO_URING ? "io_uring" : "threads");
+            exit(1);
+        }
+        BF_Block* block = done.freeBlocks[--done.numOfFree];
+        CALL_OR_DIE(BF_GetBlockAsync(queue, fileDesc, lookups[i], block, countBlock, &done));
+    }
+    BF_AsyncDestroy(queue);
+    double seconds = now() - start;
+
+    char name[32];
+    sprintf(name, "%s QD%d", backend == BF_ASYNC_IO_URING ? "io_uring" : "threads", depth);
+    printf("%-28s %12.0f lookups/s %8.1f%% cached\n", name, done.numOfCompleted / seconds, 100 * cached);
+    for(int d = 0; d < depth; d++)
+        BF_Block_Destroy(&done.freeBlocks[d]);
+    free(done.freeBlocks);
+    CALL_OR_DIE(BF_CloseFileWithPrefetch(fileDesc));
+    BF_Close();
+}
+
+int main() {
+    BF_Init(LRU);
+    CALL_OR_DIE(BF_CreateFile(FILE_NAME));
+    int fileDesc;
+    CALL_OR_DIE(BF_OpenFile(FILE_NAME, &fileDesc));
+    BF_Block* block;
+    BF_Block_Init(&block);
+    int firstBlock;
+    CALL_OR_DIE(BF_AllocateBlocks(fileDesc, BLOCKS_NUM, block, NULL, &firstBlock));
+    BF_Block_Destroy(&block);
+    CALL_OR_DIE(BF_CloseFile(fileDesc));
+    BF_Close();
+
+    // Random blocks, far more than the buffer of the BF level holds.
+    srand(12569874);
+    int* lookups = malloc(LOOKUPS_NUM * sizeof(int));
+    for(int i = 0; i < LOOKUPS_NUM; i++)
+        lookups[i] = rand() % BLOCKS_NUM;
+
+    printf("%d random lookups of %d blocks\n", LOOKUPS_NUM, BLOCKS_NUM);
+    measureSync(lookups);
+    for(int depth = 1; depth <= 32; depth *= 32){
+        measureAsync(lookups, BF_ASYNC_IO_URING, depth);
+        measureAsync(lookups, BF_ASYNC_THREADS, depth);
+    }
+    free(lookups);
+    return 0;
+}
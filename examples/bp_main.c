@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bf.h"
+#include "bp_table.h"
+
+#define RECORDS_NUM 999 // you can change it if you want
+#define FILE_NAME "tree.db"
+
+int main() {
+    BF_Init(LRU);
+
+    BP_CreateFile(FILE_NAME);
+    BP_info* info = BP_OpenFile(FILE_NAME);
+
+    Record record;
+
+    srand(12569874);
+
+    printf("Insert Entries\n");
+    for (int id = 0; id < RECORDS_NUM; ++id) {
+        record = randomRecord();
+        BP_InsertEntry(info, record);
+    }
+
+    printf("RUN PrintAllEntries\n");
+    int id = rand() % RECORDS_NUM;
+    if(BP_GetAllEntries(info, id) == -1){
+        printf("There is not a record with id = %d\n", id);
+    }
+
+    printf("RUN PrintRangeEntries\n");
+    if(BP_GetRangeEntries(info, id, id + 10) == -1){
+        printf("There is not a record with %d <= id <= %d\n", id, id + 10);
+    }
+
+    printf("RUN PrintNextEntries\n");
+    if(BP_GetNextEntries(info, id, 100) == -1){
+        printf("There is not a record with id > %d\n", id);
+    }
+    BP_CloseFile(info);
+
+    BF_Close();
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bf.h"
+#include "ht_table.h"
+#include "scan_kernel.h"
+
+#define RECORDS_NUM 60000 // you can change it if you want
+#define REPEATS 50
+#define PARALLEL_REPEATS 20
+#define MAX_THREADS 8
+#define FILE_NAME "bench.db"
+#define PAX_FILE_NAME "bench_pax.db"
+
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// Returns the seconds since some fixed point.
+static double now(){
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// The loop of HT_GetAllEntries: copy every record out of the block and check its fields.
+static uint scalarLoop(const char* data, int numOfRecords, const HT_Predicate* predicate){
+    uint passed = 0;
+    Record record;
+    for(int r = 0; r < numOfRecords; r++){
+        memcpy(&record, data + r * sizeof(Record), sizeof(record));
+        if(record.id >= predicate->minId && record.id <= predicate->maxId &&
+           (predicate->city == NULL || !strcmp(record.city, predicate->city)))
+            passed |= 1u << r;
+    }
+    return passed;
+}
+
+// Filters every block REPEATS times and prints the records per second.
+// kernelType 0 is the loop of HT_GetAllEntries, 1 is filterBlockScalar and 2 is filterBlock.
+static void measure(const char* name, char* blocks, int* numOfRecords, int numOfBlocks,
+                    HT_Layout layout, const HT_Predicate* predicate, int kernelType){
+    long totalRecords = 0;
+    long totalPassed = 0;
+    double start = now();
+    for(int repeat = 0; repeat < REPEATS; repeat++)
+        for(int b = 0; b < numOfBlocks; b++){
+            const char* data = blocks + b * BF_BLOCK_SIZE;
+            uint passed;
+            if(kernelType == 0)
+                passed = scalarLoop(data, numOfRecords[b], predicate);
+            else if(kernelType == 1)
+                passed = filterBlockScalar(data, layout, numOfRecords[b], predicate);
+            else
+                passed = filterBlock(data, layout, numOfRecords[b], predicate);
+            totalPassed += __builtin_popcount(passed);
+            totalRecords += numOfRecords[b];
+        }
+    double seconds = now() - start;
+    printf("%-28s %12.0f records/s (%ld passed)\n", name, totalRecords / seconds, totalPassed / REPEATS);
+}
+
+// Creates a hash file with the given layout and copies its blocks into memory,
+// so only the filters are measured. Returns the number of blocks.
+static int loadBlocks(char* fileName, HT_Layout layout, char** blocks, int** numOfRecords){
+    HT_CreateFileWithLayout(fileName, 100, layout);
+    HT_info* info = HT_OpenFile(fileName);
+    srand(12569874);
+    for (int id = 0; id < RECORDS_NUM; ++id)
+        HT_InsertEntry(info, randomRecord_WithSpecificID(id));
+
+    int numOfBlocks;
+    CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, &numOfBlocks));
+    *blocks = aligned_alloc(64, (size_t)numOfBlocks * BF_BLOCK_SIZE);
+    *numOfRecords = malloc(numOfBlocks * sizeof(int));
+    BF_Block* block;
+    BF_Block_Init(&block);
+    for(int b = 0; b < numOfBlocks; b++){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, b, block));
+        char* data = BF_Block_GetData(block);
+        memcpy(*blocks + b * BF_BLOCK_SIZE, data, BF_BLOCK_SIZE);
+        HT_block_info blockInfo;
+        memcpy(&blockInfo, data + BF_BLOCK_SIZE - sizeof(blockInfo), sizeof(blockInfo));
+        // The first two blocks hold the HT_info and the buckets.
+        (*numOfRecords)[b] = b < 2 ? 0 : blockInfo.numOfRecords;
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+    BF_Block_Destroy(&block);
+    HT_CloseFile(info);
+    return numOfBlocks;
+}
+
+// Measures every filter on the blocks of both layouts.
+static void measureAll(char* rowBlocks, int* rowRecords, int numOfRowBlocks,
+                       char* paxBlocks, int* paxRecords, int numOfPaxBlocks, const HT_Predicate* predicate){
+    measure("HT_GetAllEntries loop", rowBlocks, rowRecords, numOfRowBlocks, HT_ROW, predicate, 0);
+    measure("filterBlockScalar HT_ROW", rowBlocks, rowRecords, numOfRowBlocks, HT_ROW, predicate, 1);
+    measure("filterBlock HT_ROW", rowBlocks, rowRecords, numOfRowBlocks, HT_ROW, predicate, 2);
+    measure("filterBlockScalar HT_PAX", paxBlocks, paxRecords, numOfPaxBlocks, HT_PAX, predicate, 1);
+    measure("filterBlock HT_PAX", paxBlocks, paxRecords, numOfPaxBlocks, HT_PAX, predicate, 2);
+}
+
+// HT_ScanCallback that counts the records of its thread.
+static int countRecord(const Record* record, void* argument){
+    (void)record;
+    (*(long*)argument)++;
+    return 0;
+}
+
+// Scans the hash file PARALLEL_REPEATS times with HT_ParallelScan and prints the records per second.
+static void measureParallel(const char* name, HT_info* info, const HT_Predicate* predicate, int numOfThreads){
+    long counts[HT_MAX_SCAN_THREADS];
+    void* arguments[HT_MAX_SCAN_THREADS];
+    for(int t = 0; t < HT_MAX_SCAN_THREADS; t++){
+        counts[t] = 0;
+        arguments[t] = &counts[t];
+    }
+    long totalPassed = 0;
+    double start = now();
+    for(int repeat = 0; repeat < PARALLEL_REPEATS; repeat++)
+        totalPassed += HT_ParallelScan(info, predicate, countRecord, arguments, numOfThreads);
+    double seconds = now() - start;
+    printf("%-20s %d threads %12.0f records/s (%ld passed)\n", name, numOfThreads,
+           (double)RECORDS_NUM * PARALLEL_REPEATS / seconds, totalPassed / PARALLEL_REPEATS);
+}
+
+int main() {
+    BF_Init(LRU);
+
+    char* rowBlocks;
+    int* rowRecords;
+    int numOfRowBlocks = loadBlocks(FILE_NAME, HT_ROW, &rowBlocks, &rowRecords);
+    char* paxBlocks;
+    int* paxRecords;
+    int numOfPaxBlocks = loadBlocks(PAX_FILE_NAME, HT_PAX, &paxBlocks, &paxRecords);
+
+    printf("Kernel: %s\n", filterKernelName());
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = RECORDS_NUM / 4;
+    predicate.maxId = RECORDS_NUM / 2;
+    printf("id BETWEEN %d AND %d\n", predicate.minId, predicate.maxId);
+    measureAll(rowBlocks, rowRecords, numOfRowBlocks, paxBlocks, paxRecords, numOfPaxBlocks, &predicate);
+
+    predicate.city = "Athens";
+    printf("id BETWEEN %d AND %d AND city = Athens\n", predicate.minId, predicate.maxId);
+    measureAll(rowBlocks, rowRecords, numOfRowBlocks, paxBlocks, paxRecords, numOfPaxBlocks, &predicate);
+
+    // The threads of HT_ParallelScan take turns on the BF level, unless the file is read from its mapping.
+    HT_Predicate cityPredicate = HT_AllRecords();
+    cityPredicate.city = "Athens";
+    printf("HT_ParallelScan city = Athens\n");
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    for(int numOfThreads = 1; numOfThreads <= MAX_THREADS; numOfThreads *= 2)
+        measureParallel("HT_OpenFile", info, &cityPredicate, numOfThreads);
+    HT_CloseFile(info);
+    info = HT_OpenFileReadOnly(FILE_NAME);
+    for(int numOfThreads = 1; numOfThreads <= MAX_THREADS; numOfThreads *= 2)
+        measureParallel("HT_OpenFileReadOnly", info, &cityPredicate, numOfThreads);
+    HT_CloseFile(info);
+
+    free(rowBlocks);
+    free(rowRecords);
+    free(paxBlocks);
+    free(paxRecords);
+    BF_Close();
+}
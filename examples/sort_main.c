@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bf.h"
+#include "ht_table.h"
+#include "sort.h"
+
+#define RECORDS_NUM 20000 // you can change it if you want
+#define FILE_NAME "data.db"
+#define TREE_NAME "tree.db"
+#define EXPORT_NAME "sorted.csv"
+#define MEMORY_BUDGET (64 * 1024)
+
+// Returns the seconds since some fixed point.
+static double now(){
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// SORT_Callback that writes the record as a line of a csv file.
+static int exportRecord(const Record* record, void* argument){
+    fprintf(argument, "%d,%s,%s,%s\n", record->id, record->name, record->surname, record->city);
+    return 0;
+}
+
+// SORT_Callback that prints the record and stops after 10 records.
+static int printFirst(const Record* record, void* argument){
+    int* numOfPrinted = argument;
+    printRecord(*record);
+    return ++(*numOfPrinted) == 10;
+}
+
+int main() {
+    BF_Init(LRU);
+
+    HT_CreateFile(FILE_NAME, 100);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    srand(12569874);
+    printf("Insert Entries\n");
+    for (int id = 0; id < RECORDS_NUM; ++id)
+        HT_InsertEntry(info, randomRecord());
+
+    printf("RUN SORT_Records surname, first 10 records\n");
+    SORT_options options = SORT_DefaultOptions(SURNAME);
+    options.memoryBudget = MEMORY_BUDGET;
+    int numOfPrinted = 0;
+    SORT_Records(info, NULL, &options, printFirst, &numOfPrinted);
+
+    printf("RUN SORT_Records city into %s\n", EXPORT_NAME);
+    double start = now();
+    options.sortBy = CITY;
+    FILE* file = fopen(EXPORT_NAME, "w");
+    int numOfRecords = SORT_Records(info, NULL, &options, exportRecord, file);
+    fclose(file);
+    printf("%d records in %f seconds\n", numOfRecords, now() - start);
+
+    printf("RUN SORT_BulkLoad into %s\n", TREE_NAME);
+    start = now();
+    numOfRecords = SORT_BulkLoad(info, TREE_NAME, MEMORY_BUDGET);
+    printf("%d records in %f seconds\n", numOfRecords, now() - start);
+
+    HT_CloseFile(info);
+    BF_Close();
+}
@@ -0,0 +1,49 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+#include "record.h"
+#include "ht_table.h"
+
+// Bytes of the key of a group, the biggest attribute.
+#define AGG_MAX_KEY_SIZE 20
+// Number of temporary files that the spilled groups are partitioned into.
+#define AGG_PARTITIONS 8
+
+// A group of the records with the same value of the group by attribute.
+typedef struct {
+    char key[AGG_MAX_KEY_SIZE];     // The value of the attribute, zero padded. An id is stored as an int.
+    unsigned int hash;              // Hash of the key.
+    ulint count;                    // Number of records of the group.
+    int minId;                      // Smallest id of the records of the group.
+    int maxId;                      // Biggest id of the records of the group.
+} AGG_Group;
+
+// Called by AGG_GroupBy once for every group, with the argument given to AGG_GroupBy.
+// A nonzero return value stops the aggregation.
+typedef int (*AGG_Callback)(const AGG_Group* group, void* argument);
+
+typedef struct {
+    Record_Attribute groupBy;       // The attribute of the records that the groups are made of.
+    int numOfThreads;               // Threads of the scan, <= 0 for one per online CPU.
+    ulint memoryBudget;             // Bytes of the hash table of every thread and of the merge, at least one group.
+} AGG_options;
+
+// Returns the options that group by groupBy with one thread per online CPU and a 1MB budget.
+AGG_options AGG_DefaultOptions(Record_Attribute groupBy);
+
+/* Groups the records of the hash file that pass predicate, which can be NULL
+for all the records, by options->groupBy and finds the count and the smallest and
+biggest id of every group. The file is read with HT_ParallelScan and every thread
+aggregates into its own hash table of memoryBudget bytes, which is kept at most half
+full. When a table is half full, its groups are spilled, partitioned by hash, into
+AGG_PARTITIONS temporary files. At the end the tables of the threads, or every
+partition one after the other, are merged in a table of the same budget, and a
+partition that does not fit is split again by the next bits of the hash. callback
+is called for every group, in no particular order.
+Returns the number of groups that were passed to callback, or -1 for invalid options.*/
+int AGG_GroupBy(HT_info* ht_info, const HT_Predicate* predicate, const AGG_options* options,
+                AGG_Callback callback, void* argument);
+
+// Prints the key of the group like printRecord prints the attribute.
+void AGG_PrintGroup(const AGG_Group* group, Record_Attribute groupBy);
+
+#endif // AGGREGATE_H
@@ -0,0 +1,66 @@
+#ifndef BF_ASYNC_H
+#define BF_ASYNC_H
+#include "bf.h"
+
+// A warm-up of the page cache of the OS for the reads of the BF level, not an asynchronous BF_GetBlock.
+// BF_GetBlock reads a block that is not inside the buffer synchronously, so a lookup
+// waits for every miss and only one read of the device is in flight at once.
+// A BF_AsyncQueue reads up to depth blocks into the page cache of the OS at once,
+// with io_uring or with a pool of threads, into buffers of the queue that are thrown away.
+// A request completes when its block has been read: BF_AsyncComplete pins the block with
+// BF_GetBlock, which reads it a second time, now from the page cache instead of the device,
+// and calls the callback of the request. libbf can not be given the data that was read, so
+// every block is copied twice, and the queue only pays off when the device is slower than the copy.
+// The files must be opened with BF_OpenFileWithPrefetch (bf_ext.h) for the reads to be
+// asynchronous. The blocks of other files are only pinned when their request completes.
+// A queue must be used by one thread only, the one that calls the BF level.
+
+// The biggest depth of a queue.
+#define BF_ASYNC_MAX_DEPTH 256
+
+typedef enum {
+    BF_ASYNC_AUTO,                  // io_uring if the kernel allows it, otherwise the threads.
+    BF_ASYNC_IO_URING,              // The io_uring of Linux, without liburing.
+    BF_ASYNC_THREADS                // A pool of threads that read with pread.
+} BF_AsyncBackend;
+
+typedef struct BF_AsyncQueue BF_AsyncQueue;
+
+// Called by BF_AsyncComplete for every request that completed, with the argument of the request.
+// If code is BF_OK the block is pinned inside block and the callback must unpin it,
+// otherwise code is the error of BF_GetBlock. It can submit new requests.
+typedef void (*BF_AsyncCallback)(BF_ErrorCode code, BF_Block *block, int block_id, void *argument);
+
+// Creates a queue with at most depth requests in flight, 1 <= depth <= BF_ASYNC_MAX_DEPTH.
+// Returns NULL if the depth is invalid or if the backend is BF_ASYNC_IO_URING and the kernel does not allow it.
+BF_AsyncQueue* BF_AsyncCreate(int depth, BF_AsyncBackend backend);
+
+// Returns the backend that the queue uses, never BF_ASYNC_AUTO.
+BF_AsyncBackend BF_AsyncGetBackend(const BF_AsyncQueue *queue);
+
+// Returns the most requests that the queue keeps in flight.
+int BF_AsyncDepth(const BF_AsyncQueue *queue);
+
+// Returns the number of requests that were submitted and did not complete yet.
+int BF_AsyncInFlight(const BF_AsyncQueue *queue);
+
+// Submits the read of the block block_id of the file file_desc, which is pinned inside block
+// when the request completes. If the queue is full, requests complete first.
+// The io_uring backend gives the reads to the kernel together, with one system call of the next
+// BF_AsyncComplete, so BF_AsyncComplete(queue, 0) starts them without waiting.
+// If the file is not open or has no block block_id, nothing is submitted and the error
+// of the BF level is returned, BF_INVALID_BLOCK_NUMBER_ERROR for the block. If the queue failed,
+// see BF_AsyncComplete, it returns BF_ERROR. Otherwise it returns BF_OK.
+BF_ErrorCode BF_GetBlockAsync(BF_AsyncQueue *queue, const int file_desc, const int block_id, BF_Block *block,
+                              BF_AsyncCallback callback, void *argument);
+
+// Waits until at least min_completions requests complete, or all of them if fewer are in flight,
+// and completes every request whose read has finished. Returns the number of completed requests,
+// or -1 if the kernel failed the io_uring with an error that a retry does not fix. Then the queue
+// failed: its requests in flight never complete and it can only be destroyed.
+int BF_AsyncComplete(BF_AsyncQueue *queue, int min_completions);
+
+// Completes every request in flight, unless the queue failed, and frees the queue.
+void BF_AsyncDestroy(BF_AsyncQueue *queue);
+
+#endif // BF_ASYNC_H
@@ -0,0 +1,77 @@
+#ifndef BF_EXT_H
+#define BF_EXT_H
+#include "bf.h"
+
+// Block allocation on top of the BF level, which is only given as a library.
+// BF_AllocateBlock pins the new block but does not return its id, so the callers
+// used to read the block counter and get the same block again, two pins and two
+// buffer lookups for one block. These functions pin every new block once.
+
+// Allocates a new block at the end of the file, filled with zeros and pinned inside block,
+// and stores its id in *block_id. The caller unpins it.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_AllocateBlockId(const int file_desc, BF_Block *block, int *block_id);
+
+// Allocates num_blocks consecutive blocks at the end of the file, e.g. an extent, and
+// stores the id of the first one in *first_block_id. Every block is a copy of the
+// BF_BLOCK_SIZE bytes of data, or filled with zeros if data is NULL, and is unpinned
+// before the next one is allocated, so only one block of the buffer is used at once.
+// block is the handle used for them. It must not be pinned.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_AllocateBlocks(const int file_desc, int num_blocks, BF_Block *block,
+                               const char *data, int *first_block_id);
+
+// The blocks of a file are read by the BF level one at a time, so a chain of blocks
+// costs one device round trip per block. A file opened with BF_OpenFileWithPrefetch is
+// opened a second time for the OS, and BF_PrefetchBlocks and BF_GetBlocks tell the OS
+// which blocks are read next, so it reads them concurrently into its page cache.
+
+// Opens the file like BF_OpenFile, and keeps an OS file descriptor of it for the read-ahead hints.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_OpenFileWithPrefetch(const char *filename, int *file_desc);
+
+// Closes a file that BF_OpenFileWithPrefetch opened, and its OS file descriptor.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_CloseFileWithPrefetch(const int file_desc);
+
+// Returns the OS file descriptor that BF_OpenFileWithPrefetch keeps for the file, or -1 if it has none.
+// The block b of the file is at the offset b * BF_BLOCK_SIZE of it.
+int BF_OSFileDesc(const int file_desc);
+
+// Tells the OS that the num_blocks blocks from first_block on will be read soon.
+// It does not wait for them, and does nothing for a file without an OS file descriptor.
+void BF_PrefetchBlocks(const int file_desc, int first_block, int num_blocks);
+
+// Pins the num_blocks blocks block_ids inside the handles blocks, like BF_GetBlock pins one.
+// The blocks are prefetched first, every run of consecutive ids with one hint, so they
+// are read concurrently. The caller unpins them. If an error occurs, the blocks that
+// were pinned are unpinned and the error of the BF level is returned, otherwise BF_OK.
+BF_ErrorCode BF_GetBlocks(const int file_desc, int num_blocks, const int *block_ids, BF_Block **blocks);
+
+// A file that is never written again, e.g. a frozen table, can be mapped instead.
+// BF_GetBlock copies every block it reads into a frame of the buffer of the BF level.
+// The blocks of a mapped file are read straight from the page cache of the OS, which
+// every process that maps the file shares, and pinning or unpinning them does nothing.
+
+// Opens the file like BF_OpenFileWithPrefetch, and maps all of its blocks read-only and shared.
+// The OS is told that the blocks are read in random order, BF_PrefetchBlocks asks it for them ahead.
+// Nothing may write the file while it is mapped, neither this process nor an other one.
+// BF_CloseFileWithPrefetch closes it and removes the mapping.
+// If the file can not be mapped it is closed and BF_ERROR is returned, otherwise the error of the BF level or BF_OK.
+BF_ErrorCode BF_OpenFileMapped(const char *filename, int *file_desc);
+
+// Stores in *data the data of the block block_id. The block of a mapped file is read from the
+// mapping without pinning it, otherwise it is pinned inside block like BF_GetBlock pins it.
+// The data of a mapped file can not be changed. BF_ReleaseBlock releases the block.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_GetBlockData(const int file_desc, const int block_id, BF_Block *block, const char **data);
+
+// Same as BF_GetBlocks, but the data of every block is stored in datas too, from the mapping of a mapped file.
+BF_ErrorCode BF_GetBlocksData(const int file_desc, int num_blocks, const int *block_ids, BF_Block **blocks,
+                              const char **datas);
+
+// Unpins a block of BF_GetBlockData or BF_GetBlocksData. It does nothing for a mapped file.
+// If executed successfully, it returns BF_OK, otherwise the error of the BF level.
+BF_ErrorCode BF_ReleaseBlock(const int file_desc, BF_Block *block);
+
+#endif // BF_EXT_H
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "record.h"
+#include "ht_table.h"
+#include <stdbool.h>
+
+#ifndef BP_TABLE_H
+#define BP_TABLE_H
+
+typedef struct {
+    bool isBPlusTree;                   // Flag that identifies if a file is a B+-tree file.
+    char* fileName;                     // Name of the file.
+    uint fileDesc;                      // File opening ID number from the block level.
+    int root;                           // Id of the root block.
+    int height;                         // Number of levels of the tree, 1 when the root is a leaf.
+    int firstLeaf;                      // Id of the leaf with the smallest ids.
+} BP_info;
+
+typedef struct {
+    int blockIndex;                 // Index of the block.
+    int next;                       // Id of the next leaf, -1 for the last leaf and the internal nodes.
+    bool isLeaf;                    // Leaves hold Records, internal nodes hold keys and children.
+    ulint numOfRecords;             // Number of records of a leaf, or number of keys of an internal node.
+} BP_block_info;
+
+// Streams sorted records into a new B+-tree file, see BP_BulkLoadBegin.
+typedef struct BP_loader BP_loader;
+
+// The BP_CreateFile function is used to create and initialize an empty B+-tree file named fileName.
+// The tree is built on the id of the records. Its root is an empty leaf.
+// If executed successfully, it returns 0, otherwise -1.
+int BP_CreateFile(char *fileName);
+
+// The BP_OpenFile function opens the file named filename and reads from the first block the information about the B+-tree file.
+// If any error occurs, or the file is not a B+-tree file, a NULL value is returned.
+BP_info* BP_OpenFile(char *fileName);
+
+// The BP_CloseFile function closes the file specified in the header_info structure.
+// If executed successfully, it returns 0, otherwise -1.
+// The function is also responsible for freeing the memory occupied by the structure that was passed as a parameter.
+int BP_CloseFile(BP_info* header_info);
+
+// The BP_InsertEntry function is used to insert a record into the B+-tree file, in id order.
+// Records with the same id are kept in insertion order.
+// If executed successfully, it returns the number of the leaf block in which the insertion was made (blockId), otherwise -1.
+// Later inserts can split the leaf and move the record into another block.
+int BP_InsertEntry(BP_info* header_info, Record record);
+
+// Prints every record of the file with id equal to value.
+// It returns the number of blocks that were read, from the root down to the last leaf that was needed,
+// or -1 if there is no record with this id.
+int BP_GetAllEntries(BP_info* header_info, int value);
+
+// Prints, in id order, every record of the file with low <= id <= high.
+// The leaves are read one after the other through their next links and the scan
+// stops at the first id after high.
+// It returns the number of blocks that were read, or -1 if there is no record inside the range.
+int BP_GetRangeEntries(BP_info* header_info, int low, int high);
+
+// Prints, in id order, the first count records of the file with id bigger than value.
+// It returns the number of blocks that were read, or -1 if there is no record after value.
+int BP_GetNextEntries(BP_info* header_info, int value, int count);
+
+// The BP_BulkLoadBegin function creates the B+-tree file fileName and returns a loader
+// that fills it with records given in id order by BP_BulkLoadAdd.
+// Every leaf and internal node is filled up before the next one starts, so the file has the fewest blocks possible.
+// The loader keeps only one node of every level in memory. If any error occurs, a NULL value is returned.
+BP_loader* BP_BulkLoadBegin(char *fileName);
+
+// Adds the next record to the file of the loader.
+// Returns 0, or -1 if the id of the record is smaller than the id of the previous one.
+int BP_BulkLoadAdd(BP_loader* loader, Record record);
+
+// Writes the last leaf and the internal nodes of the tree, closes the file and frees the loader.
+// If executed successfully, it returns 0, otherwise -1.
+int BP_BulkLoadEnd(BP_loader* loader);
+
+#endif // BP_TABLE_H
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "record.h"
+#include "bf.h"
 #include <stdbool.h>
 
 #ifndef HT_TABLE_H
@@ -9,31 +10,115 @@
 typedef unsigned int uint;
 typedef unsigned long ulint;
 
+// How the records are stored inside the blocks of a hash file.
+// HT_ROW stores every Record one after the other.
+// HT_PAX stores the ids of all the records of the block one after the other,
+// then their names, their surnames, their cities and their Record.record fields,
+// so a predicate on one attribute reads contiguous bytes.
+// Both keep the HT_block_info at the end of the block.
+typedef enum {
+    HT_ROW,
+    HT_PAX
+} HT_Layout;
+
 typedef struct {
     bool isHashTable;                   // Flag that identifies if a file is a HT file.
     char* fileName;                     // Name of the file.
     uint fileDesc;                      // File opening ID number from the block level.
     ulint numOfBuckets;                 // The number of "buckets" in the file hash file.
+    uint zoneMapDesc;                   // File opening ID number of the zone map file of the hash file.
+    bool hasZoneMap;                    // False for a hash file whose zone map file was deleted. Its zones are not
+                                        // kept and its range scans read every block. A file older than the zone
+                                        // maps is older than the extents too, so it must be made again.
+    HT_Layout layout;                   // How the records are stored inside the blocks.
+    BF_Block* block;                    // Handle of the insert and lookup paths, made once by HT_OpenFile.
+    BF_Block* newBlock;                 // Handle of a block that is allocated while block is pinned.
+    bool readOnly;                      // True if HT_OpenFileReadOnly opened the file, which is read from its mapping.
 } HT_info;
 
 typedef struct {
-    int blockIndex;                 // Index of the block.             
+    int blockIndex;                 // Index of the block, -1 for a block reserved for a chain but not used yet.
     int next;                       // Id of the next block.
     ulint numOfRecords;             // Number of records inside the block.
+    int extentEnd;                  // Id after the last block of the extent of the block.
 } HT_block_info;
+// extentEnd made the HT_block_info 24 bytes instead of 16, so it starts 8 bytes earlier inside
+// every block, while a block still holds 6 records. This is a change of the format on disk:
+// a hash file made before the extents is read wrongly and must be made again.
+
+// The overflow blocks of a bucket are allocated in extents of consecutive blocks,
+// which only the chain of the bucket uses, so a chain walk reads consecutive blocks.
+// An extent has as many blocks as the chain already has, at least HT_MIN_EXTENT and
+// at most HT_MAX_EXTENT. The first block of a bucket is allocated alone.
+#define HT_MIN_EXTENT 8
+#define HT_MAX_EXTENT 64
+
+// The zone of a block: the smallest and the biggest id of its records.
+// The zone map file of a hash file fileName is fileName.zm. It holds the zone of
+// every block of the hash file, ZONES_PER_BLOCK zones per block, so the zone of
+// block b is the zone b % ZONES_PER_BLOCK of the block b / ZONES_PER_BLOCK.
+// A block without records has minId = INT_MAX and maxId = INT_MIN.
+typedef struct {
+    int minId;                      // Smallest id inside the block.
+    int maxId;                      // Biggest id inside the block.
+} HT_zone;
+
+// A filter of HT_Scan. A record passes if minId <= id <= maxId and every
+// string that is not NULL is equal to the attribute of the record.
+typedef struct {
+    int minId;                      // Smallest id, INT_MIN for no lower bound.
+    int maxId;                      // Biggest id, INT_MAX for no upper bound.
+    char* name;                     // The name of the records, or NULL for any name.
+    char* surname;                  // The surname of the records, or NULL for any surname.
+    char* city;                     // The city of the records, or NULL for any city.
+} HT_Predicate;
+
+// Called by HT_Scan for every record that passes the predicate, with the argument given to HT_Scan.
+// The record is valid only during the call. With the HT_ROW layout it points inside the pinned block.
+// A nonzero return value stops the scan.
+typedef int (*HT_ScanCallback)(const Record* record, void* argument);
+
+// The most threads of HT_ParallelScan and HT_GetStatistics. Every thread pins one block at a time.
+#define HT_MAX_SCAN_THREADS 32
+
+// The statistics of a hash file, as HT_GetStatistics finds them.
+typedef struct {
+    int numOfBlocks;                // Number of blocks inside the file, without the reserved blocks of the extents.
+    int numOfBucketBlocks;          // Number of blocks inside the chains of the buckets.
+    int numOfRecords;               // Number of records inside all the buckets.
+    int minRecords;                 // Minimum number of records of a bucket.
+    int minRecordsBucket;           // Smallest id of a bucket with minRecords records.
+    int maxRecords;                 // Maximum number of records of a bucket.
+    int maxRecordsBucket;           // Smallest id of a bucket with maxRecords records.
+    int numOfBucketsOverflowed;     // Number of buckets with more records than one block holds.
+    int minId;                      // Smallest id of the records, INT_MAX if there are none.
+    int maxId;                      // Biggest id of the records, INT_MIN if there are none.
+} HT_statistics;
 
 // The HT_CreateFile function is used to create and initialize an empty hash file named fileName.
 // It takes as parameters the name of the file where the heap will be built and the number of hash function buckets.
+// It also creates the empty zone map file of the hash file.
 // If executed successfully, it returns 0, otherwise -1.
 int HT_CreateFile(char *fileName, int buckets);
 
+// Same as HT_CreateFile, but the records of the file are stored with the given layout.
+int HT_CreateFileWithLayout(char *fileName, int buckets, HT_Layout layout);
+
 // The HT_OpenFile function opens the file named filename and reads from the first block the information about the hash file.
 // Then, a structure that holds as much information as necessary for this file is updated so that you can process its records later.
 // After the file information structure is properly updated, it is returned.
 // If any error occurs, a NULL value is returned.
 // If the file given for opening is not a hash file, this is also considered an error.
+// A hash file without a zone map file is opened without one, see HT_info.hasZoneMap.
 HT_info* HT_OpenFile(char *fileName);
 
+// Same as HT_OpenFile, but for a hash file that is not written anymore, e.g. a frozen table served by many processes.
+// The file is opened with BF_OpenFileMapped (bf_ext.h), so the lookups and the scans read its blocks straight from
+// a shared mapping of the file, without copying them into the buffer of the BF level or pinning them, and the threads
+// of HT_ParallelScan and HT_GetStatistics read them without serializing on the BF level.
+// HT_InsertEntry returns -1 for it. If the file can not be mapped, a NULL value is returned.
+HT_info* HT_OpenFileReadOnly(char *fileName);
+
 // The HT_CloseFile function closes the file specified in the header_info structure.
 // If executed successfully, it returns 0, otherwise -1.
 // The function is also responsible for freeing the memory occupied by the structure that was passed as a parameter, if the closure was successful.
@@ -42,6 +127,7 @@ int HT_CloseFile(HT_info* header_info);
 // The HT_InsertEntry function is used to insert a record into the hash file.
 // The information about the file is in the header_info structure, while the record to be inserted is specified by the record structure.
 // If executed successfully, you return the number of the block in which the insertion was made (blockId), otherwise -1.
+// A file opened with HT_OpenFileReadOnly can not be changed, its inserts return -1.
 int HT_InsertEntry(HT_info* header_info, Record record);
 
 // This function is used to print all records in the hash file that have a value in the key field equal to value.
@@ -51,12 +137,62 @@ int HT_InsertEntry(HT_info* header_info, Record record);
 // In case of success, it returns the number of blocks that were read, while in case of error it returns -1.
 int HT_GetAllEntries(HT_info* header_info, int value);
 
+// Prints every record of the hash file with low <= id <= high.
+// The zone map is read first and only the blocks whose zone overlaps the range are read.
+// Without a zone map the buckets are read chain by chain.
+// It returns the number of blocks of the hash file that were read, or -1 if there is no record inside the range.
+int HT_GetRangeEntries(HT_info* header_info, int low, int high);
+
+// Returns the offset inside a block of the attribute of the record r, for the given layout.
+ulint HT_FieldOffset(HT_Layout layout, Record_Attribute attribute, int r);
+
+// Copies the record r of the data of a block with the given layout into record.
+void HT_ReadRecord(HT_Layout layout, const char* data, int r, Record* record);
+
+// Stores record as the record r of the data of a block with the given layout.
+void HT_WriteRecord(HT_Layout layout, char* data, int r, const Record* record);
+
+// Returns the predicate that every record passes.
+HT_Predicate HT_AllRecords(void);
+
+// Calls callback for every record of the hash file that passes predicate, which can be NULL for all the records.
+// The predicate is evaluated on the records inside the pinned blocks, without copying them.
+// Without id bounds the buckets are read chain by chain. With id bounds the zone map is read
+// instead and only the blocks whose zone overlaps the bounds are read.
+// It returns the number of records that were passed to callback.
+int HT_Scan(HT_info* header_info, const HT_Predicate* predicate, HT_ScanCallback callback, void* argument);
+
+// Same as HT_Scan without id bounds, but the buckets are split into morsels of
+// consecutive buckets that numOfThreads threads take one after the other until none is left.
+// Every thread t calls callback with arguments[t], its own partial result, which the caller merges afterwards.
+// The callbacks of different threads run at the same time. A nonzero return value stops every thread.
+// numOfThreads <= 0 uses one thread per online CPU, and never more than HT_MAX_SCAN_THREADS.
+// The BF level is not thread safe, so for a file opened with HT_OpenFile every BF_GetBlock and BF_UnpinBlock
+// of the threads takes one mutex. The block reads are then serialized and only the records are checked in
+// parallel, so more threads help only when the callbacks cost more than the reads. The threads read a file
+// opened with HT_OpenFileReadOnly from its mapping, without the mutex. make bench measures both.
+// It returns the number of records that were passed to callback.
+int HT_ParallelScan(HT_info* header_info, const HT_Predicate* predicate, HT_ScanCallback callback,
+                    void** arguments, int numOfThreads);
+
+// The callbacks of HT_ParallelScan that call the BF level themselves, e.g. to spill to a temporary
+// file, must do it between HT_LockBlockLevel and HT_UnlockBlockLevel, like the threads of the scan do.
+void HT_LockBlockLevel(void);
+void HT_UnlockBlockLevel(void);
+
+// Finds the statistics of the hash file with numOfThreads threads, like HT_ParallelScan,
+// so its block reads are serialized too unless the file was opened with HT_OpenFileReadOnly.
+// If bucketRecords is not NULL, bucketRecords[i] gets the number of records of bucket i.
+// If executed successfully, it returns 0, otherwise -1.
+int HT_GetStatistics(HT_info* header_info, int numOfThreads, HT_statistics* statistics, int* bucketRecords);
+
 // Prints the statistical data of a hash table file with the given file name.
 // The statistics are as follows:
 // 1. How many blocks a file has,
 // 2. The average number of blocks each bucket has
 // 3. The minimum, average, and maximum number of records each bucket of a file has,
 // 4. The number of buckets that have overflow blocks, and how many blocks are these for each bucket.
+// The buckets are read in parallel with HT_GetStatistics.
 int HashStatistics(char *fileName);
 
 #endif // HT_FILE_H
@@ -0,0 +1,34 @@
+#ifndef JOIN_H
+#define JOIN_H
+#include "record.h"
+#include "ht_table.h"
+
+// Number of temporary files that every side of a grace hash join is partitioned into.
+#define JOIN_GRACE_PARTITIONS 16
+
+// Called by the joins for every pair of records with the same id, with the argument given to the join.
+// The records are valid only during the call. A nonzero return value stops the join.
+typedef int (*JOIN_Callback)(const Record* left, const Record* right, void* argument);
+
+/* Joins the records of the hash files left and right on id and calls callback
+for every pair with the same id.
+If both files have the same number of buckets, the record with an id can only be
+inside the same bucket of both files, so the buckets are joined one after the other:
+the records of bucket i of left are put in a hash table and the records of bucket i
+of right look for their id inside it. No table bigger than one bucket is built.
+Otherwise both files are partitioned by id into JOIN_GRACE_PARTITIONS temporary
+files and the partitions are joined one after the other in the same way, within a
+memory budget of 1MB, see JOIN_HashJoinWithBudget.
+Returns the number of pairs that were passed to callback.*/
+int JOIN_HashJoin(HT_info* left, HT_info* right, JOIN_Callback callback, void* argument);
+
+/* Same as JOIN_HashJoin, but a left partition of the grace hash join is put in a table
+only if its records take at most memoryBudget bytes. A bigger partition is split, together
+with the right partition, by the next bits of the hash of the id into JOIN_GRACE_PARTITIONS
+partitions, which are joined one after the other, until they fit. The records of a partition
+that can not be split anymore have the same id, and are joined even if they do not fit.
+Returns the number of pairs that were passed to callback, or -1 if memoryBudget is smaller than a Record.*/
+int JOIN_HashJoinWithBudget(HT_info* left, HT_info* right, ulint memoryBudget,
+                            JOIN_Callback callback, void* argument);
+
+#endif // JOIN_H
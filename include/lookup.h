@@ -0,0 +1,30 @@
+#ifndef LOOKUP_H
+#define LOOKUP_H
+#include "record.h"
+#include "ht_table.h"
+#include "bf_async.h"
+
+// Called by LOOKUP_GetAllEntries for every id, in the order the lookups finish, with the argument
+// given to LOOKUP_GetAllEntries. index is the position of the id inside ids. record is the first
+// record with the id, like HT_GetAllEntries finds it, or NULL if there is none, and blocksRead
+// the number of blocks of the chain that were read. The record is valid only during the call.
+// A nonzero return value stops the lookups that did not finish yet.
+typedef int (*LOOKUP_Callback)(int index, const Record* record, int blocksRead, void* argument);
+
+/* Looks up every id of ids inside the hash file, like HT_GetAllEntries does without printing,
+and calls callback for every one of them.
+The lookups are interleaved on the calling thread. Every lookup is a small state machine
+that walks the chain of its bucket: it submits the read of its current block with
+BF_GetBlockAsync and continues in the callback of the read, with the next block of the
+chain or with the next id. As many lookups as the depth of the queue are in flight at once,
+so their reads are submitted together and overlap instead of waiting for each other.
+Requests that are in flight inside the queue complete first.
+The hash file should be opened with HT_OpenFile, which keeps an OS file descriptor of it,
+otherwise every read waits for the device inside BF_GetBlock.
+Returns the number of ids that were found, or -1 if the read of a block failed, e.g. of a block
+after the end of the file, or the queue failed (see BF_AsyncComplete). Then the error is printed, the lookups stop like a callback stops them,
+and the lookup of that block is not reported.*/
+int LOOKUP_GetAllEntries(HT_info* ht_info, const int* ids, int numOfIds, BF_AsyncQueue* queue,
+                         LOOKUP_Callback callback, void* argument);
+
+#endif // LOOKUP_H
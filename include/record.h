@@ -11,6 +11,10 @@ typedef enum Record_Attribute {
   CITY
 } Record_Attribute;
 
+// Bit of an attribute inside a set of attributes, e.g. a projection.
+#define ATTRIBUTE_BIT(attribute) (1 << (attribute))
+#define ALL_ATTRIBUTES (ATTRIBUTE_BIT(ID) | ATTRIBUTE_BIT(NAME) | ATTRIBUTE_BIT(SURNAME) | ATTRIBUTE_BIT(CITY))
+
 typedef struct Record {
     char record[15];
 	int id;
@@ -22,11 +26,22 @@ typedef struct Record {
 typedef struct SHT_Record {
     char name[15];      // Key of the SHT, aka name field of the record struct. 
 	int blockId;        // The block Id inside the primitive HT where this name is stored. 
+	unsigned int hash;  // hash_string(name), compared before the names so most entries never need a strcmp.
 } SHT_Record;
 
+typedef struct SHT_Key {
+    char name[15];          // Key of a postings SHT, stored once per distinct name.
+	int firstPostingBlock;  // The first block of the sorted blockIds of this name.
+	unsigned int hash;      // hash_string(name).
+	int numOfPostings;      // Number of distinct blockIds of this name.
+} SHT_Key;
+
 Record randomRecord();
 Record randomRecord_WithSpecificID(int id);
 Record randomRecord_WithSpecificName(char* name);
 void printRecord(Record record);
+void printProjectedRecord(Record record, int attributes);
+unsigned long attributeOffset(Record_Attribute attribute);
+unsigned long attributeSize(Record_Attribute attribute);
 
 #endif
@@ -0,0 +1,99 @@
+#ifndef SBP_TABLE_H
+#define SBP_TABLE_H
+#include "record.h"
+#include "ht_table.h"
+
+// Bytes of the key of an entry, the biggest string attribute.
+#define SBP_MAX_KEY_SIZE 20
+
+typedef struct {
+    bool isSecondaryBPlusTree;          // Flag that identifies if a file is a SBP file.
+    char* fileName;                     // Name of the file.
+    uint fileDesc;                      // File opening ID number from the block level.
+    int root;                           // Id of the root block.
+    int height;                         // Number of levels of the tree, 1 when the root is a leaf.
+    int firstLeaf;                      // Id of the leaf with the smallest keys.
+    Record_Attribute keyAttribute;      // The string attribute of the records that the index is built on.
+    ulint keySize;                      // Bytes of the key attribute.
+} SBP_info;
+
+typedef struct {
+    int blockIndex;                 // Index of the block.
+    int next;                       // Id of the next leaf, -1 for the last leaf and the internal nodes.
+    bool isLeaf;                    // Leaves hold SBP_Entries, internal nodes hold keys and children.
+    ulint numOfEntries;             // Number of entries of a leaf, or number of keys of an internal node.
+} SBP_block_info;
+
+// A posting of the index. The entries are sorted by key and then by blockId,
+// and every (key, blockId) pair is stored once.
+typedef struct {
+    char key[SBP_MAX_KEY_SIZE];     // The key attribute of the records, zero padded.
+    int blockId;                    // A block of the primary HT file that holds records with this key.
+} SBP_Entry;
+
+/* The function SBP_CreateSecondaryIndex creates and initializes an empty
+secondary B+-tree file with name sfileName for the primary hash file fileName.
+The index is built on keyAttribute, which must be the name, the surname or the
+city. In case it is executed successfully, it returns 0, otherwise it returns -1.*/
+int SBP_CreateSecondaryIndex(
+    char *sfileName, /* secondary index file name */
+    char* fileName, /* primary index file name */
+    Record_Attribute keyAttribute /* the string attribute of the index */);
+
+/* The function SBP_OpenSecondaryIndex opens the file with name sfileName
+and reads from the first block the information regarding the secondary
+B+-tree index. If the file is not a SBP file it returns NULL.*/
+SBP_info* SBP_OpenSecondaryIndex(
+    char *sfileName /* secondary index file name */);
+
+/* The function SBP_CloseSecondaryIndex closes the file and frees the
+memory of header_info. In case it is executed successfully, it returns 0,
+otherwise it returns -1.*/
+int SBP_CloseSecondaryIndex( SBP_info* header_info );
+
+/* The function SBP_SecondaryInsertEntry adds the block block_id of the primary
+index to the postings of the key of record. A block is stored once for every
+key, even when it holds many records with it. In case it is executed
+successfully, it returns 0, otherwise it returns -1.*/
+int SBP_SecondaryInsertEntry(
+    SBP_info* header_info, /* header of the secondary index */
+    Record record, /* the record for which we have insertion in the secondary index */
+    int block_id /* the block of the hash file where the insertion was made */);
+
+/* Prints every record of the primary file whose key is equal to value.
+Returns the number of blocks of the secondary index that were read, or -1
+if there is no such record.*/
+int SBP_SecondaryGetAllEntries(
+    HT_info* ht_info, /* header of the primary index file */
+    SBP_info* header_info, /* header of the secondary index file */
+    char* value /* the key on which the search is performed */);
+
+/* Prints, in key order, every record of the primary file with low <= key <= high,
+compared like strcmp does. The leaves are read one after the other and the
+scan stops at the first key after high. Returns the number of blocks of the
+secondary index that were read, or -1 if there is no record inside the range.*/
+int SBP_SecondaryGetRangeEntries(
+    HT_info* ht_info, /* header of the primary index file */
+    SBP_info* header_info, /* header of the secondary index file */
+    char* low, /* the smallest key of the range */
+    char* high /* the biggest key of the range */);
+
+/* Prints, in key order, every record of the primary file whose key starts with
+prefix. The scan stops at the first key after the keys with the prefix.
+Returns the number of blocks of the secondary index that were read, or -1 if
+there is no such record.*/
+int SBP_SecondaryGetPrefixEntries(
+    HT_info* ht_info, /* header of the primary index file */
+    SBP_info* header_info, /* header of the secondary index file */
+    char* prefix /* the prefix of the keys */);
+
+/* Finds the blocks of the primary index that hold records with low <= key <= high.
+They are returned sorted and without duplicates inside a malloced array in
+*blockIds, which the caller must free. Returns the number of blockIds.*/
+int SBP_SecondaryGetBlockIds(
+    SBP_info* header_info, /* header of the secondary index file */
+    char* low, /* the smallest key of the range */
+    char* high, /* the biggest key of the range */
+    int** blockIds /* the blockIds that were found */);
+
+#endif // SBP_TABLE_H
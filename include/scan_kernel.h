@@ -0,0 +1,30 @@
+#ifndef SCAN_KERNEL_H
+#define SCAN_KERNEL_H
+#include "record.h"
+#include "ht_table.h"
+
+// The most records that one call of the filters can check.
+#define MAX_FILTERED_RECORDS 32
+
+// Returns the set of the numOfRecords records (bit r for records[r]) that pass the predicate.
+// The records are read where they are, e.g. inside a pinned block, and are never copied.
+// The fields are compared like strncmp compares them, bytes after the '\0' of a field are ignored.
+// The kernel is chosen the first time it is called: with AVX2 the ids of 8 records are
+// gathered and compared at once and the strings are compared 16 bytes at a time,
+// otherwise filterRecordsScalar is used.
+uint filterRecords(const Record* records, int numOfRecords, const HT_Predicate* predicate);
+
+// Same as filterRecords, one record and one field after the other.
+uint filterRecordsScalar(const Record* records, int numOfRecords, const HT_Predicate* predicate);
+
+// Same as filterRecords for the numOfRecords records of the data of a block with the given layout.
+// With the HT_PAX layout the ids are loaded contiguously instead of gathered.
+uint filterBlock(const char* data, HT_Layout layout, int numOfRecords, const HT_Predicate* predicate);
+
+// Same as filterBlock, one record and one field after the other.
+uint filterBlockScalar(const char* data, HT_Layout layout, int numOfRecords, const HT_Predicate* predicate);
+
+// Returns the name of the kernel that filterRecords uses, "avx2" or "scalar".
+const char* filterKernelName(void);
+
+#endif // SCAN_KERNEL_H
@@ -3,19 +3,79 @@
 #include "record.h"
 #include "ht_table.h"
 
+// Number of outer records that SHT_IndexJoin joins at once.
+#define SHT_JOIN_BATCH 256
+
+// Number of blocks of the primary file that a lookup pins at once with BF_GetBlocks.
+#define SHT_FETCH_BATCH 16
+
+// Number of sorted runs that SHT_BuildFromPrimary merges at once. Every run keeps one block pinned.
+#define SHT_BUILD_FAN_IN 32
+
+// A key is a tuple of at most all the attributes of a Record.
+#define SHT_MAX_KEY_ATTRIBUTES 4
+// Bytes of the biggest key, the id, the name, the surname and the city.
+#define SHT_MAX_KEY_SIZE 60
+
+typedef enum SHT_Format {
+    SHT_ENTRIES,                        // The buckets hold one SHT_Record for every inserted record.
+    SHT_POSTINGS                        // The buckets hold one SHT_Key for every distinct key,
+                                        // which points to a chain of blocks with its sorted blockIds.
+} SHT_Format;
 
 typedef struct {
     bool isSecondaryHashTable;          // Flag that identifies if a file is a HT file.
     char* fileName;                     // Name of the file.
     uint fileDesc;                      // File opening ID number from the block level.
     ulint numOfBuckets;                 // The number of "buckets" in the file hash file
+    SHT_Format format;                  // The format of the blocks of the buckets.
+    int includedColumns;                // ATTRIBUTE_BITs of the Record attributes stored inside every entry.
+    ulint entrySize;                    // Bytes of an entry of a SHT_ENTRIES file.
+    Record_Attribute keyAttributes[SHT_MAX_KEY_ATTRIBUTES]; // The attributes of the records that the index is built on.
+    int numOfKeyAttributes;             // The number of key attributes.
+    ulint keySize;                      // Bytes of the key attributes.
+    BF_Block* block;                    // Handle of the bucket chains, made once by SHT_OpenSecondaryIndex.
+    BF_Block* postingsBlock;            // Handle of a postings chain while block is pinned.
+    BF_Block* newBlock;                 // Handle of a block that is allocated while the others are pinned.
+    int* blockIds;                      // The blockIds that a lookup collects, reused by the next lookups.
+    int capacityOfBlockIds;             // Room of blockIds.
+    BF_Block* fetchBlocks[SHT_FETCH_BATCH]; // Handles of the primary blocks that a lookup pins at once.
+    bool readOnly;                      // True if SHT_OpenSecondaryIndexReadOnly opened the file, which is read from its mapping.
 } SHT_info;
 
+typedef struct {
+    SHT_Format format;                  // The format of the blocks of the buckets.
+    int includedColumns;                // ATTRIBUTE_BITs of ID, SURNAME and CITY to store inside the
+                                        // entries of a SHT_ENTRIES file, so lookups that only need
+                                        // them never read the primary file.
+    Record_Attribute keyAttributes[SHT_MAX_KEY_ATTRIBUTES]; // The ordered tuple of attributes that the
+                                        // index is built on, hashed as one key.
+    int numOfKeyAttributes;             // The number of key attributes.
+    ulint buildMemoryBudget;            // Bytes of the (key, blockId) pairs that SHT_BuildFromPrimary
+                                        // sorts in memory at once, the size of a run.
+} SHT_options;
+
 typedef struct {
     int blockIndex;                 // Index of the block.             
     int next;                       // Id of the next block.
     ulint numOfSHTRecords;          // Number of records inside the block
 } SHT_block_info;
+// The hash inside every entry made a SHT_Record 24 bytes instead of 20, so a block holds 20 of
+// them instead of 24. This is a change of the format on disk: a secondary index made before the
+// hashes is read wrongly and must be made again from its primary file.
+
+// Stored at the start of every postings block of a SHT_POSTINGS file.
+// It is followed by the blockIds of the block, sorted, deduplicated and delta-encoded
+// as varints. The blocks of a key's chain do not overlap, so the whole chain is sorted.
+typedef struct {
+    int firstBlockId;               // Smallest blockId inside the block.
+    int lastBlockId;                // Biggest blockId inside the block.
+    int numOfBytes;                 // Bytes of encoded blockIds after this struct.
+} SHT_postings_info;
+
+/* Returns the options of SHT_CreateSecondaryIndex: a SHT_ENTRIES index
+on the name without included columns, built with a 1MB budget.*/
+SHT_options SHT_DefaultOptions(void);
 
 /* The function SHT_CreateSecondaryIndex is used for the creation
 and proper initialization of a secondary hash file with
@@ -27,12 +87,57 @@ int SHT_CreateSecondaryIndex(
     int buckets, /* number of hash buckets */
     char* fileName /* primary index file name */);
 
+/* Same as SHT_CreateSecondaryIndex, but the format of the index is chosen
+by options, start from SHT_DefaultOptions. Every entry of a SHT_ENTRIES index
+holds the key attributes one after the other, padded to a multiple of an int,
+the blockId, the hash of the key and then the included attributes in
+Record_Attribute order. For the name this is the layout of SHT_Record.
+A SHT_POSTINGS index can not have included columns, and a key can not repeat
+an attribute, both return -1.*/
+int SHT_CreateSecondaryIndexWithOptions(
+    char *sfileName, /* secondary index file name */
+    int buckets, /* number of hash buckets */
+    char* fileName, /* primary index file name */
+    SHT_options options /* format of the index */);
+
+/* The function SHT_BuildFromPrimary creates the secondary hash file sfileName
+and fills it with every record that already exists inside the primary hash
+file fileName. The primary file is read once, bucket chain by bucket chain.
+The (key, blockId) pairs are sorted by bucket and key like SORT_Records sorts
+records: every buildMemoryBudget bytes of pairs are sorted in memory and written
+as a run into a temporary file, and the runs are merged, at most SHT_BUILD_FAN_IN
+at once. Every bucket of the secondary index is written as one chain of full blocks
+while the pairs come out of the merge, so only the keys of one bucket are kept.
+A pair keeps only the included columns of its record, and a budget smaller
+than one pair sorts the pairs one at a time.
+In case it is executed successfully, it returns 0, otherwise it returns -1.*/
+int SHT_BuildFromPrimary(
+    char *sfileName, /* secondary index file name */
+    int buckets, /* number of hash buckets */
+    char* fileName /* primary index file name */);
+
+/* Same as SHT_BuildFromPrimary, but the format of the index is chosen by options.*/
+int SHT_BuildFromPrimaryWithOptions(
+    char *sfileName, /* secondary index file name */
+    int buckets, /* number of hash buckets */
+    char* fileName, /* primary index file name */
+    SHT_options options /* format of the index */);
+
 /* The function SHT_OpenSecondaryIndex opens the file with name sfileName
 and reads from the first block the information regarding the secondary
 hash index.*/
 SHT_info* SHT_OpenSecondaryIndex(
     char *sfileName /* secondary index file name */);
 
+/* Same as SHT_OpenSecondaryIndex, but for an index that is not written anymore,
+like HT_OpenFileReadOnly. The lookups and SHT_IndexJoin read the blocks of the
+index from a shared mapping of the file, without pinning them, and the blocks of
+a primary file opened with HT_OpenFileReadOnly from its mapping too.
+SHT_SecondaryInsertEntry returns -1 for it. If the file can not be mapped,
+NULL is returned.*/
+SHT_info* SHT_OpenSecondaryIndexReadOnly(
+    char *sfileName /* secondary index file name */);
+
 /* The function SHT_CloseSecondaryIndex closes the file specified
 inside the header_info structure. In case it is executed successfully, it returns
 0, otherwise it returns -1. The function is also responsible for the
@@ -45,7 +150,7 @@ record in the hash file. The information regarding the file
 is located in the header_info structure, while the record to be inserted is specified
 by the record structure and the block of the primary index where the record
 to be inserted exists. In case it is executed successfully, it returns 0, otherwise
-it returns -1.*/
+it returns -1, also for an index opened with SHT_OpenSecondaryIndexReadOnly.*/
 int SHT_SecondaryInsertEntry(
     SHT_info* header_info, /* header of the secondary index */
     Record record, /* the record for which we have insertion in the secondary index */
@@ -53,18 +158,73 @@ int SHT_SecondaryInsertEntry(
 
 /* This function is used for the printing of all the records that
 exist in the hash file which have a value in the key-field
-of the secondary index equal to name. The first structure contains information
+of the secondary index equal to value. The value is a string when the key
+attribute is the name, the surname or the city, and a pointer to an int when
+it is the id. For a composite key it is a pointer to a Record whose key
+attributes hold the tuple, the rest of the Record is ignored. The first structure contains information
 about the hash file, as they were returned during its opening.
 The second structure contains information about the secondary index as
 they were returned by SHT_OpenIndex. For each record that exists
-in the file and has a name equal to value, its contents are printed
-(including the key-field). It also returns the
-number of blocks that were read until all the records were found. In
-case of error it returns -1.*/
+in the file and has a key equal to value, its contents are printed
+(including the key-field). The blocks of the primary index are collected,
+sorted and deduplicated first, so every HT block is read at most once and
+every matching record inside it is printed. It also returns the
+number of blocks of the secondary index that were read until all the records
+were found. In case of error it returns -1.*/
 int SHT_SecondaryGetAllEntries(
     HT_info* ht_info, /* header of the primary index file */
     SHT_info* header_info, /* header of the secondary index file */
-    char* name /* the name on which the search is performed */);
+    void* value /* the key on which the search is performed */);
+
+/* Same as SHT_SecondaryGetAllEntries but for numOfValues keys at once.
+The HT blocks of all the keys share one sorted block schedule, so a block
+that holds records of several of the keys is still read only once.
+Returns the number of blocks of the secondary index that were read, or -1
+if none of the keys was found.*/
+int SHT_SecondaryGetAllEntriesMulti(
+    HT_info* ht_info, /* header of the primary index file */
+    SHT_info* header_info, /* header of the secondary index file */
+    void** values, /* the keys on which the search is performed */
+    int numOfValues /* number of keys */);
+
+/* Same as SHT_SecondaryGetAllEntries, but only the attributes in the set
+projection (ATTRIBUTE_BITs) of every record are printed. If the index includes
+all of them the records are printed straight from the index and the primary
+file is never read, ht_info can then be NULL. Otherwise the records are read
+from the primary file like SHT_SecondaryGetAllEntries does. Returns the number
+of blocks of the secondary index that were read, or -1 if the key was not found.*/
+int SHT_SecondaryGetAllEntriesProjected(
+    HT_info* ht_info, /* header of the primary index file */
+    SHT_info* header_info, /* header of the secondary index file */
+    void* value, /* the key on which the search is performed */
+    int projection /* the attributes to print */);
+
+/* Finds the blocks of the primary index that hold records with key equal to
+value. They are returned sorted and without duplicates inside a malloced array
+in *blockIds, which the caller must free. Returns the number of blockIds.*/
+int SHT_SecondaryGetBlockIds(
+    SHT_info* header_info, /* header of the secondary index file */
+    void* value, /* the key on which the search is performed */
+    int** blockIds /* the blockIds that were found */);
+
+// Called by SHT_IndexJoin for every outer record and record of the primary file with the same key,
+// with the argument given to SHT_IndexJoin. The records are valid only during the call.
+// A nonzero return value stops the join.
+typedef int (*SHT_JoinCallback)(const Record* outer, const Record* inner, void* argument);
+
+/* Joins the numOfOuter outer records with the records of the primary file that have
+the same key attributes, using the secondary index, and calls callback for every pair.
+The outer records are joined in batches of SHT_JOIN_BATCH. The keys of a batch are
+sorted by bucket, so the chain of every bucket is read once for all its keys, and the
+primary blocks of all the keys are sorted, so every one is fetched once for the batch.
+Returns the number of pairs that were passed to callback.*/
+int SHT_IndexJoin(
+    HT_info* ht_info, /* header of the primary index file */
+    SHT_info* header_info, /* header of the secondary index file */
+    const Record* outer, /* the outer records */
+    int numOfOuter, /* number of outer records */
+    SHT_JoinCallback callback, /* called for every pair */
+    void* argument /* passed to callback */);
 
 uint hash_string(void*);
 #endif // SHT_FILE_H
@@ -0,0 +1,37 @@
+#ifndef SORT_H
+#define SORT_H
+#include "record.h"
+#include "ht_table.h"
+
+// Number of runs that one pass of the merge reads at once. Every run keeps one block pinned.
+#define SORT_MAX_FAN_IN 32
+
+// Called by SORT_Records for every record in order, with the argument given to SORT_Records.
+// The record is valid only during the call. A nonzero return value stops the sort.
+typedef int (*SORT_Callback)(const Record* record, void* argument);
+
+typedef struct {
+    Record_Attribute sortBy;        // The attribute of the records that they are sorted by.
+    ulint memoryBudget;             // Bytes of the records that are sorted in memory at once, the size of a run.
+} SORT_options;
+
+// Returns the options that sort by sortBy with a 1MB budget.
+SORT_options SORT_DefaultOptions(Record_Attribute sortBy);
+
+/* Calls callback for every record of the hash file that passes predicate, which can
+be NULL for all the records, in ascending order of options->sortBy. Records with the
+same value come in id order, and strings are compared like strncmp compares them.
+The file is read once with HT_Scan. Every memoryBudget bytes of records are sorted in
+memory and written as a run into a temporary file. The runs are merged with a loser
+tree, at most SORT_MAX_FAN_IN at once, so more runs take more passes, each of them
+writing fewer and longer runs. If all the records fit inside the budget, none is written.
+Returns the number of records that were passed to callback, or -1 for invalid options.*/
+int SORT_Records(HT_info* ht_info, const HT_Predicate* predicate, const SORT_options* options,
+                 SORT_Callback callback, void* argument);
+
+/* Creates the B+-tree file fileName with every record of the hash file, sorting them
+by id with SORT_Records and memoryBudget bytes, and building the tree with BP_BulkLoadAdd.
+Returns the number of records of the tree, or -1 in case of error.*/
+int SORT_BulkLoad(HT_info* ht_info, char* fileName, ulint memoryBudget);
+
+#endif // SORT_H
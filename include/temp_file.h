@@ -0,0 +1,53 @@
+#ifndef TEMP_FILE_H
+#define TEMP_FILE_H
+#include <stdbool.h>
+#include "bf.h"
+
+typedef unsigned long ulint;
+
+// A temporary BF file of fixed size entries, e.g. the spilled groups of an
+// aggregation or the runs of a sort. The entries are stored one after the
+// other, BF_BLOCK_SIZE / entrySize entries per block, without any header.
+// The file exists only between TMP_Create and TMP_Destroy.
+// Every TMP_file keeps at most one block pinned, the last one it used, so
+// appending or reading the entries in order pins every block once.
+// A closed TMP_file keeps its entries without using one of the BF_MAX_OPEN_FILES.
+typedef struct {
+    char* fileName;                 // Name of the file, unique inside the process.
+    int fileDesc;                   // File opening ID number from the block level, -1 while it is closed.
+    ulint entrySize;                // Bytes of every entry.
+    ulint entriesPerBlock;          // Number of entries inside every block.
+    ulint numOfEntries;             // Number of entries inside the file.
+    BF_Block* block;                // The block that is pinned.
+    int pinnedBlock;                // Id of the pinned block, -1 if there is none.
+} TMP_file;
+
+// Creates and opens an empty temporary file for entries of entrySize bytes,
+// at most BF_BLOCK_SIZE. Returns NULL in case of error.
+TMP_file* TMP_Create(ulint entrySize);
+
+// Adds a copy of entry after the last entry of the file.
+// If executed successfully, it returns the index of the entry, otherwise -1.
+long TMP_Append(TMP_file* file, const void* entry);
+
+// Copies the entry with the given index into entry.
+// If executed successfully, it returns 0, otherwise -1.
+int TMP_Get(TMP_file* file, ulint index, void* entry);
+
+// Unpins the block that the file keeps pinned, e.g. before many other files are used.
+// The next TMP_Append or TMP_Get pins it again.
+void TMP_Unpin(TMP_file* file);
+
+// Closes the BF file of the temporary file, but keeps the file and its entries, e.g. for
+// the runs of a sort that are more than the files that can be open at once.
+// The next TMP_Append or TMP_Get opens it again.
+void TMP_Close(TMP_file* file);
+
+// Removes every entry of the file. Its blocks are reused by the next appends.
+void TMP_Clear(TMP_file* file);
+
+// Closes and deletes the file and frees the memory of the struct.
+// If executed successfully, it returns 0, otherwise -1.
+int TMP_Destroy(TMP_file* file);
+
+#endif // TEMP_FILE_H
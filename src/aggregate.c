@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "bf.h"
+#include "ht_table.h"
+#include "record.h"
+#include "temp_file.h"
+#include "aggregate.h"
+
+#define DEFAULT_MEMORY_BUDGET (1 << 20)
+#define PARTITION_BITS 3            // Bits of the hash that choose a partition, AGG_PARTITIONS <= 1 << PARTITION_BITS.
+#define MAX_LEVEL 8                 // The last level of partitions, whose bits end at the lowest bit of the hash.
+
+// An open addressing hash table of groups. The empty slots have count == 0.
+typedef struct {
+    AGG_Group* groups;              // The slots of the table.
+    ulint capacity;                 // Number of slots, a power of 2.
+    ulint numOfGroups;              // Number of slots that are used.
+    ulint maxGroups;                // Groups before the table is spilled or repartitioned.
+} GroupTable;
+
+// The state of an aggregation that every thread shares.
+typedef struct {
+    Record_Attribute groupBy;
+    ulint memoryBudget;                         // Bytes of the table of every thread and of the merge.
+    TMP_file* partitions[AGG_PARTITIONS];       // The spilled groups, NULL before the first spill.
+    bool spilled;                               // If any thread has spilled its groups.
+} Aggregation;
+
+// The state of a thread of an aggregation, the argument of its scan callback.
+typedef struct {
+    Aggregation* aggregation;
+    GroupTable table;               // Allocated by the first record of the thread.
+} AggregationThread;
+
+// Allocates an empty table with the most slots, a power of 2 and at least 2, that fit inside memoryBudget bytes.
+static void tableInit(GroupTable* table, ulint memoryBudget){
+    table->capacity = 2;
+    while(2 * table->capacity * sizeof(AGG_Group) <= memoryBudget)
+        table->capacity *= 2;
+    // Keep the table at most half full, so the probes stay short.
+    table->maxGroups = table->capacity / 2;
+    table->groups = calloc(table->capacity, sizeof(AGG_Group));
+    table->numOfGroups = 0;
+}
+
+// Returns the slot of the group with the key, or the empty slot where it belongs.
+static AGG_Group* tableFind(GroupTable* table, const char* key, uint hash){
+    ulint slot = hash & (table->capacity - 1);
+    while(table->groups[slot].count != 0){
+        AGG_Group* group = &table->groups[slot];
+        if(group->hash == hash && !memcmp(group->key, key, AGG_MAX_KEY_SIZE))
+            return group;
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    return &table->groups[slot];
+}
+
+// Returns true if the group is new to the table and the table already holds maxGroups groups.
+static bool tableIsFullFor(GroupTable* table, const AGG_Group* group){
+    return table->numOfGroups == table->maxGroups &&
+           tableFind(table, group->key, group->hash)->count == 0;
+}
+
+static void tableAdd(GroupTable* table, const AGG_Group* group);
+
+// Moves the groups of a table into twice the slots. The table keeps its maxGroups.
+static void tableGrow(GroupTable* table){
+    GroupTable bigger;
+    bigger.capacity = table->capacity * 2;
+    bigger.groups = calloc(bigger.capacity, sizeof(AGG_Group));
+    bigger.numOfGroups = 0;
+    bigger.maxGroups = table->maxGroups;
+    for(ulint i = 0; i < table->capacity; i++)
+        if(table->groups[i].count != 0)
+            tableAdd(&bigger, &table->groups[i]);
+    free(table->groups);
+    *table = bigger;
+}
+
+// Adds a group, merging it with the group of the table with the same key.
+// A table doubles when it becomes more than half full, which only the last level of mergePartition lets happen.
+static void tableAdd(GroupTable* table, const AGG_Group* group){
+    AGG_Group* slot = tableFind(table, group->key, group->hash);
+    if(slot->count == 0){
+        *slot = *group;
+        table->numOfGroups++;
+        if(2 * table->numOfGroups > table->capacity)
+            tableGrow(table);
+        return;
+    }
+    slot->count += group->count;
+    if(group->minId < slot->minId)
+        slot->minId = group->minId;
+    if(group->maxId > slot->maxId)
+        slot->maxId = group->maxId;
+}
+
+// Removes every group of the table.
+static void tableClear(GroupTable* table){
+    memset(table->groups, 0, table->capacity * sizeof(AGG_Group));
+    table->numOfGroups = 0;
+}
+
+// Copies the attribute of the record into key, zero padded.
+// Like strncmp, the bytes after the '\0' of a string do not change the key.
+static void makeKey(const Record* record, Record_Attribute groupBy, char* key){
+    memset(key, 0, AGG_MAX_KEY_SIZE);
+    const char* field = (const char*)record + attributeOffset(groupBy);
+    if(groupBy == ID)
+        memcpy(key, field, sizeof(int));
+    else
+        strncpy(key, field, attributeSize(groupBy));
+}
+
+// djb2 over the key. An id is mixed with a multiplication, so consecutive ids spread over the table.
+static uint hashKey(const char* key, Record_Attribute groupBy){
+    if(groupBy == ID){
+        uint id;
+        memcpy(&id, key, sizeof(int));
+        return id * 2654435761u;
+    }
+    uint hash = 5381;
+    for(int i = 0; i < AGG_MAX_KEY_SIZE && key[i] != '\0'; i++)
+        hash = ((hash << 5) + hash) + (unsigned char)key[i];
+    return hash;
+}
+
+// Returns the partition of a spilled group at a level of partitioning. Level 0 uses the high
+// bits of the hash, as the low ones choose the slot of the table, and every level the next
+// PARTITION_BITS bits below them, so a partition that is split again spreads its groups.
+static int partitionOf(uint hash, int level){
+    return (hash >> (MAX_LEVEL - level) * PARTITION_BITS) % AGG_PARTITIONS;
+}
+
+// Appends the group to its partition of the level, creating the partition if it is NULL.
+static void spillGroup(TMP_file** partitions, const AGG_Group* group, int level){
+    int partition = partitionOf(group->hash, level);
+    if(partitions[partition] == NULL)
+        partitions[partition] = TMP_Create(sizeof(AGG_Group));
+    TMP_Append(partitions[partition], group);
+}
+
+// Appends every group of the table to its partition of the level and empties the table.
+// The caller holds the block level lock if other threads may use the BF level.
+static void spillTable(GroupTable* table, TMP_file** partitions, int level){
+    for(ulint i = 0; i < table->capacity; i++)
+        if(table->groups[i].count != 0)
+            spillGroup(partitions, &table->groups[i], level);
+    tableClear(table);
+}
+
+// HT_ScanCallback that adds the record to the table of the thread.
+static int aggregateRecord(const Record* record, void* argument){
+    AggregationThread* thread = argument;
+    Aggregation* aggregation = thread->aggregation;
+    if(thread->table.groups == NULL)
+        tableInit(&thread->table, aggregation->memoryBudget);
+
+    char key[AGG_MAX_KEY_SIZE];
+    makeKey(record, aggregation->groupBy, key);
+    uint hash = hashKey(key, aggregation->groupBy);
+    AGG_Group* group = tableFind(&thread->table, key, hash);
+    if(group->count == 0){
+        // A new group that does not fit inside the budget: spill the others first.
+        if(thread->table.numOfGroups == thread->table.maxGroups){
+            HT_LockBlockLevel();
+            spillTable(&thread->table, aggregation->partitions, 0);
+            aggregation->spilled = true;
+            HT_UnlockBlockLevel();
+            group = tableFind(&thread->table, key, hash);
+        }
+        memcpy(group->key, key, AGG_MAX_KEY_SIZE);
+        group->hash = hash;
+        group->minId = record->id;
+        group->maxId = record->id;
+        thread->table.numOfGroups++;
+    }
+    group->count++;
+    if(record->id < group->minId)
+        group->minId = record->id;
+    if(record->id > group->maxId)
+        group->maxId = record->id;
+    return 0;
+}
+
+// Calls callback for every group of the table, until it returns nonzero.
+// *numOfGroups counts the groups that were passed to callback. Returns true if callback asked to stop.
+static bool emitTable(GroupTable* table, AGG_Callback callback, void* argument, int* numOfGroups){
+    for(ulint i = 0; i < table->capacity; i++){
+        if(table->groups[i].count == 0)
+            continue;
+        (*numOfGroups)++;
+        if(callback(&table->groups[i], argument))
+            return true;
+    }
+    return false;
+}
+
+// Merges the groups of the partition of the level in table, which is empty, and calls callback
+// for every group, until it returns nonzero. When the groups of the partition do not fit
+// inside the table, the groups of the table and the rest of the partition are split by the
+// next bits of their hash into AGG_PARTITIONS partitions of the next level, merged one after
+// the other in the same table. The groups of a partition of MAX_LEVEL share every bit that
+// partitionOf uses, so they are merged even if the table grows past its budget.
+// The partition is destroyed. *numOfGroups counts the groups that were passed to callback.
+// Returns true if callback asked to stop.
+static bool mergePartition(GroupTable* table, TMP_file* partition, int level,
+                           AGG_Callback callback, void* argument, int* numOfGroups){
+    AGG_Group group;
+    ulint i = 0;
+    for(; i < partition->numOfEntries; i++){
+        TMP_Get(partition, i, &group);
+        if(level < MAX_LEVEL && tableIsFullFor(table, &group))
+            break;
+        tableAdd(table, &group);
+    }
+    if(i == partition->numOfEntries){
+        TMP_Destroy(partition);
+        bool stop = emitTable(table, callback, argument, numOfGroups);
+        tableClear(table);
+        return stop;
+    }
+
+    // Repartition the groups by the next bits of their hash.
+    TMP_file* partitions[AGG_PARTITIONS] = { NULL };
+    spillTable(table, partitions, level + 1);
+    for(; i < partition->numOfEntries; i++){
+        TMP_Get(partition, i, &group);
+        spillGroup(partitions, &group, level + 1);
+    }
+    TMP_Destroy(partition);
+    // Only the partition that is merged is open.
+    for(int p = 0; p < AGG_PARTITIONS; p++)
+        if(partitions[p] != NULL)
+            TMP_Close(partitions[p]);
+
+    bool stop = false;
+    for(int p = 0; p < AGG_PARTITIONS; p++){
+        if(partitions[p] == NULL)
+            continue;
+        if(stop)
+            TMP_Destroy(partitions[p]);
+        else
+            stop = mergePartition(table, partitions[p], level + 1, callback, argument, numOfGroups);
+    }
+    return stop;
+}
+
+AGG_options AGG_DefaultOptions(Record_Attribute groupBy){
+    AGG_options options;
+    options.groupBy = groupBy;
+    options.numOfThreads = 0;
+    options.memoryBudget = DEFAULT_MEMORY_BUDGET;
+    return options;
+}
+
+int AGG_GroupBy(HT_info* ht_info, const HT_Predicate* predicate, const AGG_options* options,
+                AGG_Callback callback, void* argument){
+    if(options->groupBy < ID || options->groupBy > CITY || options->memoryBudget < sizeof(AGG_Group))
+        return -1;
+
+    Aggregation aggregation;
+    aggregation.groupBy = options->groupBy;
+    aggregation.memoryBudget = options->memoryBudget;
+    aggregation.spilled = false;
+    for(int p = 0; p < AGG_PARTITIONS; p++)
+        aggregation.partitions[p] = NULL;
+
+    // Every thread of the scan aggregates into its own table.
+    AggregationThread threads[HT_MAX_SCAN_THREADS];
+    void* arguments[HT_MAX_SCAN_THREADS];
+    for(int t = 0; t < HT_MAX_SCAN_THREADS; t++){
+        threads[t].aggregation = &aggregation;
+        threads[t].table.groups = NULL;
+        arguments[t] = &threads[t];
+    }
+    HT_ParallelScan(ht_info, predicate, aggregateRecord, arguments, options->numOfThreads);
+
+    // Merge the tables of the threads inside the budget. If some groups were spilled, or the groups
+    // of the threads do not fit inside the budget together, the rest are spilled too and the
+    // partitions are merged one after the other, so only the groups of one partition are in memory.
+    GroupTable merged;
+    tableInit(&merged, aggregation.memoryBudget);
+    for(int t = 0; t < HT_MAX_SCAN_THREADS; t++){
+        GroupTable* table = &threads[t].table;
+        if(table->groups == NULL)
+            continue;
+        for(ulint i = 0; i < table->capacity; i++){
+            AGG_Group* group = &table->groups[i];
+            if(group->count == 0)
+                continue;
+            if(!aggregation.spilled && tableIsFullFor(&merged, group)){
+                spillTable(&merged, aggregation.partitions, 0);
+                aggregation.spilled = true;
+            }
+            if(aggregation.spilled)
+                spillGroup(aggregation.partitions, group, 0);
+            else
+                tableAdd(&merged, group);
+        }
+        free(table->groups);
+    }
+
+    int numOfGroups = 0;
+    if(!aggregation.spilled){
+        emitTable(&merged, callback, argument, &numOfGroups);
+    }
+    else{
+        for(int p = 0; p < AGG_PARTITIONS; p++)
+            if(aggregation.partitions[p] != NULL)
+                TMP_Close(aggregation.partitions[p]);
+        bool stop = false;
+        for(int p = 0; p < AGG_PARTITIONS; p++){
+            TMP_file* partition = aggregation.partitions[p];
+            if(partition == NULL)
+                continue;
+            if(stop)
+                TMP_Destroy(partition);
+            else
+                stop = mergePartition(&merged, partition, 0, callback, argument, &numOfGroups);
+        }
+    }
+    free(merged.groups);
+    return numOfGroups;
+}
+
+void AGG_PrintGroup(const AGG_Group* group, Record_Attribute groupBy){
+    if(groupBy == ID){
+        int id;
+        memcpy(&id, group->key, sizeof(int));
+        printf("(%d", id);
+    }
+    else{
+        // A key that fills the whole attribute has no '\0'.
+        printf("(%.*s", AGG_MAX_KEY_SIZE, group->key);
+    }
+    printf(",count=%lu,minId=%d,maxId=%d)\n", group->count, group->minId, group->maxId);
+}
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "bf.h"
+#include "bf_ext.h"
+#include "bf_async.h"
+
+#define MAX_THREADS 32
+
+// A request that was submitted, in a slot of the queue.
+typedef struct {
+    int fileDesc;
+    int blockId;
+    BF_Block* block;
+    BF_AsyncCallback callback;
+    void* argument;
+    int osFileDesc;                 // -1 if the file has no OS file descriptor, then nothing is read.
+    char* data;                     // BF_BLOCK_SIZE bytes that the OS reads the block into.
+} Request;
+
+// The rings of an io_uring, mapped from the kernel.
+typedef struct {
+    int ringDesc;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_cqe* cqes;
+    unsigned numOfUnsubmitted;      // Requests inside the submission ring that the kernel was not told about.
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;                   // The same as sqRing if the kernel maps them together.
+    size_t cqRingSize;
+    size_t sqesSize;
+} Ring;
+
+struct BF_AsyncQueue {
+    BF_AsyncBackend backend;
+    int depth;
+    Request* requests;              // depth slots.
+    char* buffers;                  // The data of every slot.
+    int* freeSlots;
+    int numOfFree;
+    Ring ring;                      // BF_ASYNC_IO_URING only.
+    bool failed;                    // True after the kernel failed the io_uring, then nothing completes anymore.
+
+    // BF_ASYNC_THREADS only. The slots wait inside pending until a thread reads them,
+    // then inside done until BF_AsyncComplete takes them.
+    pthread_mutex_t mutex;
+    pthread_cond_t submitted;
+    pthread_cond_t read;
+    int* pending;                   // A circular buffer of depth slots.
+    int firstPending;
+    int numOfPending;
+    int* done;
+    int numOfDone;
+    pthread_t threads[MAX_THREADS];
+    int numOfThreads;
+    bool stop;
+};
+
+static int ringSetup(unsigned entries, struct io_uring_params* params){
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ringEnter(int ringDesc, unsigned toSubmit, unsigned minComplete, unsigned flags){
+    return syscall(__NR_io_uring_enter, ringDesc, toSubmit, minComplete, flags, NULL, 0);
+}
+
+// Creates the io_uring of the queue. Returns false if the kernel does not allow it.
+static bool ringCreate(BF_AsyncQueue* queue){
+    Ring* ring = &queue->ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->ringDesc = ringSetup(queue->depth, &params);
+    if(ring->ringDesc < 0)
+        return false;
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMap){
+        if(ring->cqRingSize > ring->sqRingSize)
+            ring->sqRingSize = ring->cqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->ringDesc, IORING_OFF_SQ_RING);
+    ring->cqRing = singleMap ? ring->sqRing : mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_POPULATE, ring->ringDesc, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->ringDesc, IORING_OFF_SQES);
+    if(ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED){
+        if(ring->sqRing != MAP_FAILED)
+            munmap(ring->sqRing, ring->sqRingSize);
+        if(!singleMap && ring->cqRing != MAP_FAILED)
+            munmap(ring->cqRing, ring->cqRingSize);
+        if(ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqesSize);
+        close(ring->ringDesc);
+        return false;
+    }
+
+    char* sq = ring->sqRing;
+    char* cq = ring->cqRing;
+    ring->sqTail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+    ring->cqHead = (unsigned*)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->numOfUnsubmitted = 0;
+    return true;
+}
+
+static void ringDestroy(Ring* ring){
+    munmap(ring->sqes, ring->sqesSize);
+    if(ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->ringDesc);
+}
+
+// Puts the read of the slot, or a request that does nothing if the file has no OS file descriptor,
+// inside the submission ring. The kernel is told about all of them at once by ringReap.
+// There is always room inside the ring, it has at least depth entries.
+static void ringSubmit(BF_AsyncQueue* queue, int slot){
+    Ring* ring = &queue->ring;
+    Request* request = &queue->requests[slot];
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if(request->osFileDesc >= 0){
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = request->osFileDesc;
+        sqe->addr = (unsigned long)request->data;
+        sqe->len = BF_BLOCK_SIZE;
+        sqe->off = (size_t)request->blockId * BF_BLOCK_SIZE;
+    }
+    else
+        sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = slot;
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->numOfUnsubmitted++;
+}
+
+// Submits the requests of the submission ring with one system call, and takes the slots of the
+// reads that finished into slots, after waiting for one if wait is true. Returns the number of slots,
+// or -1 if the system call failed with an error that a retry does not fix.
+static int ringReap(BF_AsyncQueue* queue, bool wait, int* slots){
+    Ring* ring = &queue->ring;
+    if(wait || ring->numOfUnsubmitted > 0){
+        int submitted = ringEnter(ring->ringDesc, ring->numOfUnsubmitted, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+        if(submitted > 0)
+            ring->numOfUnsubmitted -= submitted;
+        else if(submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return -1;
+    }
+    int numOfSlots = 0;
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    for(; head != tail; head++)
+        slots[numOfSlots++] = ring->cqes[head & *ring->cqMask].user_data;
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    return numOfSlots;
+}
+
+// A thread of the pool: reads the pending slots one after the other until the queue stops.
+static void* readPending(void* argument){
+    BF_AsyncQueue* queue = argument;
+    pthread_mutex_lock(&queue->mutex);
+    while(true){
+        while(!queue->stop && queue->numOfPending == 0)
+            pthread_cond_wait(&queue->submitted, &queue->mutex);
+        if(queue->numOfPending == 0)
+            break;
+        int slot = queue->pending[queue->firstPending];
+        queue->firstPending = (queue->firstPending + 1) % queue->depth;
+        queue->numOfPending--;
+        pthread_mutex_unlock(&queue->mutex);
+
+        // A read that fails is only a miss of the page cache, BF_GetBlock finds the error again.
+        Request* request = &queue->requests[slot];
+        if(request->osFileDesc >= 0)
+            (void)!pread(request->osFileDesc, request->data, BF_BLOCK_SIZE, (off_t)request->blockId * BF_BLOCK_SIZE);
+
+        pthread_mutex_lock(&queue->mutex);
+        queue->done[queue->numOfDone++] = slot;
+        pthread_cond_signal(&queue->read);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return NULL;
+}
+
+// Takes the slots of the reads that finished into slots, after waiting for one if wait is true.
+// Returns the number of slots.
+static int poolReap(BF_AsyncQueue* queue, bool wait, int* slots){
+    pthread_mutex_lock(&queue->mutex);
+    while(wait && queue->numOfDone == 0)
+        pthread_cond_wait(&queue->read, &queue->mutex);
+    int numOfSlots = queue->numOfDone;
+    memcpy(slots, queue->done, numOfSlots * sizeof(int));
+    queue->numOfDone = 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return numOfSlots;
+}
+
+// Pins the block of a request whose read finished, frees its slot and calls its callback.
+static void finish(BF_AsyncQueue* queue, int slot){
+    // The callback can submit a request into the same slot.
+    Request request = queue->requests[slot];
+    queue->freeSlots[queue->numOfFree++] = slot;
+    BF_ErrorCode code = BF_GetBlock(request.fileDesc, request.blockId, request.block);
+    request.callback(code, request.block, request.blockId, request.argument);
+}
+
+BF_AsyncQueue* BF_AsyncCreate(int depth, BF_AsyncBackend backend){
+    if(depth < 1 || depth > BF_ASYNC_MAX_DEPTH)
+        return NULL;
+    BF_AsyncQueue* queue = malloc(sizeof(*queue));
+    queue->depth = depth;
+    queue->backend = backend == BF_ASYNC_THREADS ? BF_ASYNC_THREADS : BF_ASYNC_IO_URING;
+    if(queue->backend == BF_ASYNC_IO_URING && !ringCreate(queue)){
+        if(backend == BF_ASYNC_IO_URING){
+            free(queue);
+            return NULL;
+        }
+        queue->backend = BF_ASYNC_THREADS;
+    }
+
+    queue->requests = malloc(depth * sizeof(Request));
+    queue->buffers = aligned_alloc(BF_BLOCK_SIZE, (size_t)depth * BF_BLOCK_SIZE);
+    queue->freeSlots = malloc(depth * sizeof(int));
+    for(int slot = 0; slot < depth; slot++){
+        queue->requests[slot].data = queue->buffers + (size_t)slot * BF_BLOCK_SIZE;
+        queue->freeSlots[slot] = depth - 1 - slot;
+    }
+    queue->numOfFree = depth;
+    queue->failed = false;
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->submitted, NULL);
+    pthread_cond_init(&queue->read, NULL);
+    queue->pending = malloc(depth * sizeof(int));
+    queue->firstPending = 0;
+    queue->numOfPending = 0;
+    queue->done = malloc(depth * sizeof(int));
+    queue->numOfDone = 0;
+    queue->stop = false;
+    // Every thread keeps one read in flight.
+    queue->numOfThreads = 0;
+    if(queue->backend == BF_ASYNC_THREADS){
+        queue->numOfThreads = depth < MAX_THREADS ? depth : MAX_THREADS;
+        for(int t = 0; t < queue->numOfThreads; t++)
+            pthread_create(&queue->threads[t], NULL, readPending, queue);
+    }
+    return queue;
+}
+
+BF_AsyncBackend BF_AsyncGetBackend(const BF_AsyncQueue *queue){
+    return queue->backend;
+}
+
+int BF_AsyncDepth(const BF_AsyncQueue *queue){
+    return queue->depth;
+}
+
+int BF_AsyncInFlight(const BF_AsyncQueue *queue){
+    return queue->depth - queue->numOfFree;
+}
+
+BF_ErrorCode BF_GetBlockAsync(BF_AsyncQueue *queue, const int file_desc, const int block_id, BF_Block *block,
+                              BF_AsyncCallback callback, void *argument){
+    if(queue->failed)
+        return BF_ERROR;
+    // A block that does not exist would only be read to fail inside BF_GetBlock.
+    int numOfBlocks;
+    BF_ErrorCode code = BF_GetBlockCounter(file_desc, &numOfBlocks);
+    if(code != BF_OK)
+        return code;
+    if(block_id < 0 || block_id >= numOfBlocks)
+        return BF_INVALID_BLOCK_NUMBER_ERROR;
+
+    if(queue->numOfFree == 0 && BF_AsyncComplete(queue, 1) < 0)
+        return BF_ERROR;
+
+    int slot = queue->freeSlots[--queue->numOfFree];
+    Request* request = &queue->requests[slot];
+    request->fileDesc = file_desc;
+    request->blockId = block_id;
+    request->block = block;
+    request->callback = callback;
+    request->argument = argument;
+    request->osFileDesc = BF_OSFileDesc(file_desc);
+
+    if(queue->backend == BF_ASYNC_IO_URING){
+        ringSubmit(queue, slot);
+        return BF_OK;
+    }
+    pthread_mutex_lock(&queue->mutex);
+    queue->pending[(queue->firstPending + queue->numOfPending) % queue->depth] = slot;
+    queue->numOfPending++;
+    pthread_cond_signal(&queue->submitted);
+    pthread_mutex_unlock(&queue->mutex);
+    return BF_OK;
+}
+
+int BF_AsyncComplete(BF_AsyncQueue *queue, int min_completions){
+    if(queue->failed)
+        return -1;
+    int inFlight = BF_AsyncInFlight(queue);
+    if(min_completions > inFlight)
+        min_completions = inFlight;
+
+    // The callbacks can complete other requests, so every call keeps its own slots.
+    int slots[BF_ASYNC_MAX_DEPTH];
+    int numOfCompleted = 0;
+    do{
+        bool wait = numOfCompleted < min_completions;
+        int numOfSlots = queue->backend == BF_ASYNC_IO_URING ? ringReap(queue, wait, slots)
+                                                             : poolReap(queue, wait, slots);
+        if(numOfSlots < 0){
+            queue->failed = true;
+            return -1;
+        }
+        for(int s = 0; s < numOfSlots; s++)
+            finish(queue, slots[s]);
+        numOfCompleted += numOfSlots;
+    } while(numOfCompleted < min_completions);
+    return numOfCompleted;
+}
+
+void BF_AsyncDestroy(BF_AsyncQueue *queue){
+    while(BF_AsyncInFlight(queue) > 0 && BF_AsyncComplete(queue, BF_AsyncInFlight(queue)) >= 0)
+        ;
+
+    // Closing the io_uring waits for the reads that the kernel still has, which write into the buffers.
+    if(queue->backend == BF_ASYNC_IO_URING)
+        ringDestroy(&queue->ring);
+    pthread_mutex_lock(&queue->mutex);
+    queue->stop = true;
+    pthread_cond_broadcast(&queue->submitted);
+    pthread_mutex_unlock(&queue->mutex);
+    for(int t = 0; t < queue->numOfThreads; t++)
+        pthread_join(queue->threads[t], NULL);
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->submitted);
+    pthread_cond_destroy(&queue->read);
+
+    free(queue->requests);
+    free(queue->buffers);
+    free(queue->freeSlots);
+    free(queue->pending);
+    free(queue->done);
+    free(queue);
+}
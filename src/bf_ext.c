@@ -0,0 +1,205 @@
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bf.h"
+#include "bf_ext.h"
+
+// The OS file descriptor of every file of the BF level that BF_OpenFileWithPrefetch opened,
+// and the mapping of the ones that BF_OpenFileMapped opened.
+typedef struct {
+    bool open;
+    int osFileDesc;
+    const char *mapping;            // All the blocks of the file, or NULL if it is not mapped.
+    int numOfBlocks;                // Number of blocks inside the mapping.
+} PrefetchFile;
+
+static PrefetchFile prefetchFiles[BF_MAX_OPEN_FILES];
+
+BF_ErrorCode BF_AllocateBlockId(const int file_desc, BF_Block *block, int *block_id){
+    // The new block goes after the last one, so its id is the number of blocks before it.
+    int blocks_num;
+    BF_ErrorCode code = BF_GetBlockCounter(file_desc, &blocks_num);
+    if(code != BF_OK)
+        return code;
+    code = BF_AllocateBlock(file_desc, block);
+    if(code != BF_OK)
+        return code;
+    memset(BF_Block_GetData(block), 0, BF_BLOCK_SIZE);
+    BF_Block_SetDirty(block);
+    *block_id = blocks_num;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_AllocateBlocks(const int file_desc, int num_blocks, BF_Block *block,
+                               const char *data, int *first_block_id){
+    BF_ErrorCode code = BF_GetBlockCounter(file_desc, first_block_id);
+    if(code != BF_OK)
+        return code;
+    for(int i = 0; i < num_blocks; i++){
+        code = BF_AllocateBlock(file_desc, block);
+        if(code != BF_OK)
+            return code;
+        if(data == NULL)
+            memset(BF_Block_GetData(block), 0, BF_BLOCK_SIZE);
+        else
+            memcpy(BF_Block_GetData(block), data, BF_BLOCK_SIZE);
+        BF_Block_SetDirty(block);
+        code = BF_UnpinBlock(block);
+        if(code != BF_OK)
+            return code;
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_OpenFileWithPrefetch(const char *filename, int *file_desc){
+    BF_ErrorCode code = BF_OpenFile(filename, file_desc);
+    if(code != BF_OK)
+        return code;
+    // Without an OS file descriptor the file is only read without hints.
+    int osFileDesc = open(filename, O_RDONLY);
+    if(*file_desc >= 0 && *file_desc < BF_MAX_OPEN_FILES && osFileDesc >= 0){
+        prefetchFiles[*file_desc].open = true;
+        prefetchFiles[*file_desc].osFileDesc = osFileDesc;
+        prefetchFiles[*file_desc].mapping = NULL;
+        prefetchFiles[*file_desc].numOfBlocks = 0;
+    }
+    else if(osFileDesc >= 0)
+        close(osFileDesc);
+    return BF_OK;
+}
+
+BF_ErrorCode BF_CloseFileWithPrefetch(const int file_desc){
+    if(file_desc >= 0 && file_desc < BF_MAX_OPEN_FILES && prefetchFiles[file_desc].open){
+        if(prefetchFiles[file_desc].mapping != NULL)
+            munmap((void *)prefetchFiles[file_desc].mapping, (size_t)prefetchFiles[file_desc].numOfBlocks * BF_BLOCK_SIZE);
+        prefetchFiles[file_desc].mapping = NULL;
+        close(prefetchFiles[file_desc].osFileDesc);
+        prefetchFiles[file_desc].open = false;
+    }
+    return BF_CloseFile(file_desc);
+}
+
+int BF_OSFileDesc(const int file_desc){
+    if(file_desc < 0 || file_desc >= BF_MAX_OPEN_FILES || !prefetchFiles[file_desc].open)
+        return -1;
+    return prefetchFiles[file_desc].osFileDesc;
+}
+
+// Returns the mapping of the file, or NULL if BF_OpenFileMapped did not open it.
+static const PrefetchFile *mappedFile(const int file_desc){
+    if(file_desc < 0 || file_desc >= BF_MAX_OPEN_FILES || !prefetchFiles[file_desc].open ||
+       prefetchFiles[file_desc].mapping == NULL)
+        return NULL;
+    return &prefetchFiles[file_desc];
+}
+
+void BF_PrefetchBlocks(const int file_desc, int first_block, int num_blocks){
+    int osFileDesc = BF_OSFileDesc(file_desc);
+    if(osFileDesc < 0 || num_blocks <= 0)
+        return;
+    const PrefetchFile *file = mappedFile(file_desc);
+    if(file != NULL){
+        if(first_block < 0 || first_block + num_blocks > file->numOfBlocks)
+            return;
+        // madvise takes whole pages, so the range starts at the page of the first block.
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t start = (size_t)first_block * BF_BLOCK_SIZE;
+        size_t end = (size_t)(first_block + num_blocks) * BF_BLOCK_SIZE;
+        start -= start % pageSize;
+        madvise((void *)(file->mapping + start), end - start, MADV_WILLNEED);
+        return;
+    }
+    // The BF level stores block b at the offset b * BF_BLOCK_SIZE of the file.
+    posix_fadvise(osFileDesc, (off_t)first_block * BF_BLOCK_SIZE,
+                  (off_t)num_blocks * BF_BLOCK_SIZE, POSIX_FADV_WILLNEED);
+}
+
+// Prefetches the blocks block_ids, with one hint for every run of consecutive ids.
+static void prefetchRuns(const int file_desc, int num_blocks, const int *block_ids){
+    for(int first = 0, last = 0; first < num_blocks; first = last){
+        for(last = first + 1; last < num_blocks && block_ids[last] == block_ids[last - 1] + 1; last++);
+        BF_PrefetchBlocks(file_desc, block_ids[first], last - first);
+    }
+}
+
+BF_ErrorCode BF_GetBlocks(const int file_desc, int num_blocks, const int *block_ids, BF_Block **blocks){
+    prefetchRuns(file_desc, num_blocks, block_ids);
+    for(int i = 0; i < num_blocks; i++){
+        BF_ErrorCode code = BF_GetBlock(file_desc, block_ids[i], blocks[i]);
+        if(code != BF_OK){
+            while(i-- > 0)
+                BF_UnpinBlock(blocks[i]);
+            return code;
+        }
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_OpenFileMapped(const char *filename, int *file_desc){
+    BF_ErrorCode code = BF_OpenFileWithPrefetch(filename, file_desc);
+    if(code != BF_OK)
+        return code;
+    int osFileDesc = BF_OSFileDesc(*file_desc);
+    int numOfBlocks;
+    code = BF_GetBlockCounter(*file_desc, &numOfBlocks);
+    struct stat status;
+    // The mapping holds block b at the offset b * BF_BLOCK_SIZE, so the file must hold exactly its blocks.
+    if(code != BF_OK || osFileDesc < 0 || numOfBlocks <= 0 || fstat(osFileDesc, &status) ||
+       status.st_size != (off_t)numOfBlocks * BF_BLOCK_SIZE){
+        BF_CloseFileWithPrefetch(*file_desc);
+        return code != BF_OK ? code : BF_ERROR;
+    }
+    void *mapping = mmap(NULL, (size_t)numOfBlocks * BF_BLOCK_SIZE, PROT_READ, MAP_SHARED, osFileDesc, 0);
+    if(mapping == MAP_FAILED){
+        BF_CloseFileWithPrefetch(*file_desc);
+        return BF_ERROR;
+    }
+    // A lookup reads a few blocks of a chain, so reading ahead around every fault is wasted.
+    madvise(mapping, (size_t)numOfBlocks * BF_BLOCK_SIZE, MADV_RANDOM);
+    prefetchFiles[*file_desc].mapping = mapping;
+    prefetchFiles[*file_desc].numOfBlocks = numOfBlocks;
+    return BF_OK;
+}
+
+BF_ErrorCode BF_GetBlockData(const int file_desc, const int block_id, BF_Block *block, const char **data){
+    const PrefetchFile *file = mappedFile(file_desc);
+    if(file != NULL){
+        if(block_id < 0 || block_id >= file->numOfBlocks)
+            return BF_INVALID_BLOCK_NUMBER_ERROR;
+        *data = file->mapping + (size_t)block_id * BF_BLOCK_SIZE;
+        return BF_OK;
+    }
+    BF_ErrorCode code = BF_GetBlock(file_desc, block_id, block);
+    if(code == BF_OK)
+        *data = BF_Block_GetData(block);
+    return code;
+}
+
+BF_ErrorCode BF_GetBlocksData(const int file_desc, int num_blocks, const int *block_ids, BF_Block **blocks,
+                              const char **datas){
+    if(mappedFile(file_desc) == NULL){
+        BF_ErrorCode code = BF_GetBlocks(file_desc, num_blocks, block_ids, blocks);
+        if(code != BF_OK)
+            return code;
+        for(int i = 0; i < num_blocks; i++)
+            datas[i] = BF_Block_GetData(blocks[i]);
+        return BF_OK;
+    }
+    prefetchRuns(file_desc, num_blocks, block_ids);
+    for(int i = 0; i < num_blocks; i++){
+        BF_ErrorCode code = BF_GetBlockData(file_desc, block_ids[i], blocks[i], &datas[i]);
+        if(code != BF_OK)
+            return code;
+    }
+    return BF_OK;
+}
+
+BF_ErrorCode BF_ReleaseBlock(const int file_desc, BF_Block *block){
+    if(mappedFile(file_desc) != NULL)
+        return BF_OK;
+    return BF_UnpinBlock(block);
+}
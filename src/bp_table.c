@@ -0,0 +1,532 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "bf.h"
+#include "bp_table.h"
+#include "record.h"
+
+#define UNITIALLIZED -1
+#define BLOCK_INFO_OFFSET (BF_BLOCK_SIZE - sizeof(BP_block_info))
+#define MAX_RECORDS_PER_LEAF (BLOCK_INFO_OFFSET / sizeof(Record))
+// An internal node with n keys has n + 1 children.
+#define MAX_KEYS_PER_NODE ((BLOCK_INFO_OFFSET - sizeof(int)) / (2 * sizeof(int)))
+// Internal levels that the bulk loader can fill. Every level multiplies the
+// leaves by MAX_KEYS_PER_NODE + 1, so no file of the BF level comes close.
+#define MAX_LEVELS 16
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// An internal node as it is stored at the start of its block.
+// keys[i] is the first id of the subtree of children[i + 1], so every id of
+// children[i] is <= keys[i] and every id of children[i + 1] is >= keys[i].
+typedef struct {
+    int children[MAX_KEYS_PER_NODE + 1];
+    int keys[MAX_KEYS_PER_NODE];
+} Node;
+
+struct BP_loader {
+    BP_info* info;                          // The file that is loaded.
+    int leafBlock;                          // The block of the leaf that is filled.
+    Record records[MAX_RECORDS_PER_LEAF];   // The records of the leaf that is filled.
+    int numOfRecords;                       // Number of records inside records.
+    int lastId;                             // Id of the previous record, to check the order.
+    int numOfLevels;                        // Number of internal levels so far.
+    Node nodes[MAX_LEVELS];                 // The node that is filled at every internal level.
+    int numOfChildren[MAX_LEVELS];          // Number of children of every node that is filled.
+    int firstKeys[MAX_LEVELS];              // The first id under every node that is filled.
+    int nodesWritten[MAX_LEVELS];           // Number of nodes of every level that are already written.
+};
+
+// Allocates a new, empty leaf or internal node and returns its ID.
+static int allocateNode(BP_info* info, bool isLeaf){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    // Allocate a new block, it is the last block of the file.
+    CALL_OR_DIE(BF_AllocateBlock(info->fileDesc, block));
+    int blocksNum;
+    CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, &blocksNum));
+
+    BP_block_info blockInfo;
+    blockInfo.blockIndex = blocksNum - 1;
+    blockInfo.next = UNITIALLIZED;
+    blockInfo.isLeaf = isLeaf;
+    blockInfo.numOfRecords = 0;
+    memcpy(BF_Block_GetData(block) + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+    return blockInfo.blockIndex;
+}
+
+// Stores the BP_info into the first block of the file.
+static void writeBP_info(BP_info* info){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 0, block));
+    memcpy(BF_Block_GetData(block), info, sizeof(*info));
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+}
+
+// Copies the keys and the children of an internal node out of its data.
+static void readNode(char* data, Node* node){
+    memcpy(node, data, sizeof(*node));
+}
+
+// Writes the node, numOfKeys and the next leaf into the block blockId.
+// For an internal node records is a Node, for a leaf it is an array of Records.
+static void writeNode(BP_info* info, int blockId, const void* records, ulint size, ulint numOfRecords, int next){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    memcpy(data, records, size);
+
+    BP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+    blockInfo.numOfRecords = numOfRecords;
+    blockInfo.next = next;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+}
+
+// Returns the child of an internal node with numOfKeys keys where the first record with id could be.
+// That is the first child whose key is >= id, the records with the same id continue into the next leaves.
+static int childIndex(const Node* node, int numOfKeys, int id){
+    int low = 0;
+    int high = numOfKeys;
+    while(low < high){
+        int middle = (low + high) / 2;
+        if(node->keys[middle] < id)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// Returns the child of an internal node with numOfKeys keys where a new record with id goes.
+// That is the first child whose key is > id, so the record goes after the records with the same id
+// inside the last leaf that holds them, and they stay in insertion order.
+static int insertChildIndex(const Node* node, int numOfKeys, int id){
+    int low = 0;
+    int high = numOfKeys;
+    while(low < high){
+        int middle = (low + high) / 2;
+        if(node->keys[middle] <= id)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// Walks from the root to the leaf where the first record with id could be.
+// *blocksRead is increased by the number of internal nodes that were read.
+static int findLeaf(BP_info* info, int id, int* blocksRead){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int currentBlock = info->root;
+    for(int level = info->height - 1; level > 0; level--){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        BP_block_info blockInfo;
+        memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+        Node node;
+        readNode(data, &node);
+        currentBlock = node.children[childIndex(&node, blockInfo.numOfRecords, id)];
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        (*blocksRead)++;
+    }
+
+    BF_Block_Destroy(&block);
+    return currentBlock;
+}
+
+// Inserts the record into the leaf blockId. If the leaf is full it is split and
+// *newBlock gets the new leaf after it, and *separator its first id.
+// Returns the leaf where the record was stored.
+static int insertIntoLeaf(BP_info* info, int blockId, const Record* record, int* separator, int* newBlock){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    BP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+
+    // The records are sorted by id, the new one goes after the ones with the same id.
+    Record records[MAX_RECORDS_PER_LEAF + 1];
+    int numOfRecords = blockInfo.numOfRecords;
+    memcpy(records, data, numOfRecords * sizeof(Record));
+    int position = numOfRecords;
+    while(position > 0 && records[position - 1].id > record->id)
+        position--;
+    memmove(records + position + 1, records + position, (numOfRecords - position) * sizeof(Record));
+    records[position] = *record;
+    numOfRecords++;
+
+    *newBlock = UNITIALLIZED;
+    if(numOfRecords <= MAX_RECORDS_PER_LEAF){
+        memcpy(data, records, numOfRecords * sizeof(Record));
+        blockInfo.numOfRecords = numOfRecords;
+        memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+        BF_Block_SetDirty(block);
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        BF_Block_Destroy(&block);
+        return blockId;
+    }
+
+    // Split the leaf in half. When the ids arrive in increasing order every record
+    // goes to the end of the last leaf, so that leaf stays full and only the new record moves.
+    int leftRecords = numOfRecords / 2;
+    if(position == numOfRecords - 1 && blockInfo.next == UNITIALLIZED)
+        leftRecords = numOfRecords - 1;
+
+    *newBlock = allocateNode(info, true);
+    *separator = records[leftRecords].id;
+    writeNode(info, *newBlock, records + leftRecords, (numOfRecords - leftRecords) * sizeof(Record),
+              numOfRecords - leftRecords, blockInfo.next);
+
+    memcpy(data, records, leftRecords * sizeof(Record));
+    blockInfo.numOfRecords = leftRecords;
+    blockInfo.next = *newBlock;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    return position < leftRecords ? blockId : *newBlock;
+}
+
+// Inserts the record into the subtree of blockId, which is level levels above the leaves.
+// If the root of the subtree is split, *newBlock gets the new node after it and
+// *separator the first id under the new node. Otherwise *newBlock is UNITIALLIZED.
+// Returns the leaf where the record was stored.
+static int insertIntoSubtree(BP_info* info, int blockId, int level, const Record* record, int* separator, int* newBlock){
+    if(level == 0)
+        return insertIntoLeaf(info, blockId, record, separator, newBlock);
+
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    BP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+    Node node;
+    readNode(data, &node);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+
+    int numOfKeys = blockInfo.numOfRecords;
+    int child = insertChildIndex(&node, numOfKeys, record->id);
+    int childSeparator;
+    int childBlock;
+    int leaf = insertIntoSubtree(info, node.children[child], level - 1, record, &childSeparator, &childBlock);
+
+    *newBlock = UNITIALLIZED;
+    if(childBlock == UNITIALLIZED){
+        BF_Block_Destroy(&block);
+        return leaf;
+    }
+
+    // The child was split, its new sibling goes right after it.
+    int keys[MAX_KEYS_PER_NODE + 1];
+    int children[MAX_KEYS_PER_NODE + 2];
+    memcpy(keys, node.keys, child * sizeof(int));
+    keys[child] = childSeparator;
+    memcpy(keys + child + 1, node.keys + child, (numOfKeys - child) * sizeof(int));
+    memcpy(children, node.children, (child + 1) * sizeof(int));
+    children[child + 1] = childBlock;
+    memcpy(children + child + 2, node.children + child + 1, (numOfKeys - child) * sizeof(int));
+    numOfKeys++;
+
+    if(numOfKeys <= MAX_KEYS_PER_NODE){
+        memcpy(node.keys, keys, numOfKeys * sizeof(int));
+        memcpy(node.children, children, (numOfKeys + 1) * sizeof(int));
+        writeNode(info, blockId, &node, sizeof(node), numOfKeys, UNITIALLIZED);
+        BF_Block_Destroy(&block);
+        return leaf;
+    }
+
+    // Split the node, its middle key moves up to the parent.
+    int middle = numOfKeys / 2;
+    Node right;
+    memcpy(right.keys, keys + middle + 1, (numOfKeys - middle - 1) * sizeof(int));
+    memcpy(right.children, children + middle + 1, (numOfKeys - middle) * sizeof(int));
+    memcpy(node.keys, keys, middle * sizeof(int));
+    memcpy(node.children, children, (middle + 1) * sizeof(int));
+    *newBlock = allocateNode(info, false);
+    *separator = keys[middle];
+    writeNode(info, *newBlock, &right, sizeof(right), numOfKeys - middle - 1, UNITIALLIZED);
+    writeNode(info, blockId, &node, sizeof(node), middle, UNITIALLIZED);
+
+    BF_Block_Destroy(&block);
+    return leaf;
+}
+
+// Prints, in id order, the records with low <= id <= high, at most limit of them.
+// The leaves are read through their next links until an id after high is found.
+// *blocksRead is increased by the number of blocks that were read.
+// Returns the number of records that were printed.
+static int printRange(BP_info* info, int low, int high, int limit, int* blocksRead){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int currentBlock = findLeaf(info, low, blocksRead);
+    int recordsPrinted = 0;
+    bool done = false;
+    while(currentBlock != UNITIALLIZED && !done){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        BP_block_info blockInfo;
+        memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+        (*blocksRead)++;
+
+        Record record;
+        for(int i = 0; i < blockInfo.numOfRecords && !done; i++){
+            memcpy(&record, data + i * sizeof(Record), sizeof(record));
+            if(record.id < low)
+                continue;
+            if(record.id > high){
+                done = true;
+                break;
+            }
+            printRecord(record);
+            recordsPrinted++;
+            if(recordsPrinted == limit)
+                done = true;
+        }
+
+        currentBlock = blockInfo.next;
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+
+    BF_Block_Destroy(&block);
+    return recordsPrinted;
+}
+
+int BP_CreateFile(char *fileName){
+    BF_Block* block;
+
+    BF_Block_Init(&block); // Initiallize the struct BF_Block.
+    CALL_OR_DIE(BF_CreateFile(fileName)); // Create a file which consists of blocks.
+
+    int fileDescriptor; // The file descriptor of the file we are going to open.
+    CALL_OR_DIE(BF_OpenFile(fileName, &fileDescriptor)); // Open the file
+
+    CALL_OR_DIE(BF_AllocateBlock(fileDescriptor, block));
+    char* data = BF_Block_GetData(block);
+
+    // The root is the empty leaf of block 1.
+    BP_info info;
+    memset(&info, 0, sizeof(info));
+    info.isBPlusTree = true;
+    info.fileDesc = fileDescriptor;
+    info.root = 1;
+    info.height = 1;
+    info.firstLeaf = 1;
+    memcpy(data, &info, sizeof(info));
+
+    BP_block_info blockInfo;
+    blockInfo.blockIndex = 0;
+    blockInfo.next = UNITIALLIZED;
+    blockInfo.isLeaf = false;
+    blockInfo.numOfRecords = 0;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    allocateNode(&info, true);
+
+    CALL_OR_DIE(BF_CloseFile(fileDescriptor));
+    return 0;
+}
+
+BP_info* BP_OpenFile(char *fileName){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int fileDescriptor;
+    CALL_OR_DIE(BF_OpenFile(fileName, &fileDescriptor));
+    CALL_OR_DIE(BF_GetBlock(fileDescriptor, 0, block));
+
+    BP_info* info = malloc(sizeof(*info));
+    memcpy(info, BF_Block_GetData(block), sizeof(*info));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    // Check if the file is a B+-tree file
+    if(!info->isBPlusTree){
+        free(info);
+        CALL_OR_DIE(BF_CloseFile(fileDescriptor));
+        return NULL;
+    }
+
+    // We allocate the fileName here so we can free the pointer.
+    info->fileName = malloc(strlen(fileName) + 1);
+    strcpy(info->fileName, fileName);
+    // The fileDesc stored inside the file is the one it had when it was created.
+    info->fileDesc = fileDescriptor;
+    return info;
+}
+
+int BP_CloseFile(BP_info* info){
+    CALL_OR_DIE(BF_CloseFile(info->fileDesc));
+
+    // memory managment
+    free(info->fileName);
+    free(info);
+    return 0;
+}
+
+int BP_InsertEntry(BP_info* info, Record record){
+    int separator;
+    int newBlock;
+    int leaf = insertIntoSubtree(info, info->root, info->height - 1, &record, &separator, &newBlock);
+    if(newBlock == UNITIALLIZED)
+        return leaf;
+
+    // The root was split, the tree grows by one level.
+    Node root;
+    root.children[0] = info->root;
+    root.children[1] = newBlock;
+    root.keys[0] = separator;
+    int rootBlock = allocateNode(info, false);
+    writeNode(info, rootBlock, &root, sizeof(root), 1, UNITIALLIZED);
+    info->root = rootBlock;
+    info->height++;
+    writeBP_info(info);
+    return leaf;
+}
+
+int BP_GetAllEntries(BP_info* info, int value){
+    int blocksRead = 0;
+    if(printRange(info, value, value, INT_MAX, &blocksRead) == 0)
+        return -1;
+    return blocksRead;
+}
+
+int BP_GetRangeEntries(BP_info* info, int low, int high){
+    int blocksRead = 0;
+    if(low > high || printRange(info, low, high, INT_MAX, &blocksRead) == 0)
+        return -1;
+    return blocksRead;
+}
+
+int BP_GetNextEntries(BP_info* info, int value, int count){
+    int blocksRead = 0;
+    if(value == INT_MAX || count <= 0 || printRange(info, value + 1, INT_MAX, count, &blocksRead) == 0)
+        return -1;
+    return blocksRead;
+}
+
+// Adds a child to the node that is filled at level. A full node is written first
+// and becomes a child of the level above it.
+static void addChild(BP_loader* loader, int level, int firstKey, int blockId){
+    if(level == loader->numOfLevels){
+        loader->numOfLevels++;
+        loader->numOfChildren[level] = 0;
+        loader->nodesWritten[level] = 0;
+    }
+
+    if(loader->numOfChildren[level] == MAX_KEYS_PER_NODE + 1){
+        int nodeBlock = allocateNode(loader->info, false);
+        writeNode(loader->info, nodeBlock, &loader->nodes[level], sizeof(Node), MAX_KEYS_PER_NODE, UNITIALLIZED);
+        loader->nodesWritten[level]++;
+        addChild(loader, level + 1, loader->firstKeys[level], nodeBlock);
+        loader->numOfChildren[level] = 0;
+    }
+
+    Node* node = &loader->nodes[level];
+    int numOfChildren = loader->numOfChildren[level];
+    if(numOfChildren == 0)
+        loader->firstKeys[level] = firstKey;
+    else
+        node->keys[numOfChildren - 1] = firstKey;
+    node->children[numOfChildren] = blockId;
+    loader->numOfChildren[level]++;
+}
+
+BP_loader* BP_BulkLoadBegin(char *fileName){
+    if(BP_CreateFile(fileName) == -1)
+        return NULL;
+    BP_info* info = BP_OpenFile(fileName);
+    if(info == NULL)
+        return NULL;
+
+    BP_loader* loader = malloc(sizeof(*loader));
+    loader->info = info;
+    // The empty root of the new file is the first leaf.
+    loader->leafBlock = info->firstLeaf;
+    loader->numOfRecords = 0;
+    loader->lastId = INT_MIN;
+    loader->numOfLevels = 0;
+    return loader;
+}
+
+int BP_BulkLoadAdd(BP_loader* loader, Record record){
+    if(record.id < loader->lastId)
+        return -1;
+    loader->lastId = record.id;
+
+    if(loader->numOfRecords == MAX_RECORDS_PER_LEAF){
+        // The leaf is full, write it and continue into the next one.
+        int nextLeaf = allocateNode(loader->info, true);
+        writeNode(loader->info, loader->leafBlock, loader->records, loader->numOfRecords * sizeof(Record),
+                  loader->numOfRecords, nextLeaf);
+        addChild(loader, 0, loader->records[0].id, loader->leafBlock);
+        loader->leafBlock = nextLeaf;
+        loader->numOfRecords = 0;
+    }
+
+    loader->records[loader->numOfRecords++] = record;
+    return 0;
+}
+
+int BP_BulkLoadEnd(BP_loader* loader){
+    BP_info* info = loader->info;
+    writeNode(info, loader->leafBlock, loader->records, loader->numOfRecords * sizeof(Record),
+              loader->numOfRecords, UNITIALLIZED);
+
+    if(loader->numOfLevels == 0){
+        // Everything fits into the first leaf.
+        info->root = loader->leafBlock;
+        info->height = 1;
+    }
+    else{
+        addChild(loader, 0, loader->records[0].id, loader->leafBlock);
+        // Write the last node of every level. The only node of the top level is the root.
+        for(int level = 0; level < loader->numOfLevels; level++){
+            int nodeBlock = allocateNode(info, false);
+            writeNode(info, nodeBlock, &loader->nodes[level], sizeof(Node),
+                      loader->numOfChildren[level] - 1, UNITIALLIZED);
+            if(loader->nodesWritten[level] == 0 && level == loader->numOfLevels - 1){
+                info->root = nodeBlock;
+                info->height = level + 2;
+            }
+            else
+                addChild(loader, level + 1, loader->firstKeys[level], nodeBlock);
+        }
+    }
+
+    writeBP_info(info);
+    BP_CloseFile(info);
+    free(loader);
+    return 0;
+}
@@ -2,15 +2,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "bf.h"
+#include "bf_ext.h"
 #include "ht_table.h"
 #include "record.h"
+#include "scan_kernel.h"
 
 #define UNITIALLIZED -1
 #define MAX_RECORDS_PER_BLOCK (BF_BLOCK_SIZE - sizeof(HT_block_info)) / (sizeof(Record))
 #define BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int) + sizeof(int)
 #define BYTES_UNTIL_NEXT BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int)
+#define BYTES_UNTIL_EXTENT_END BF_BLOCK_SIZE - sizeof(HT_block_info) + offsetof(HT_block_info, extentEnd)
+#define ZONES_PER_BLOCK (BF_BLOCK_SIZE / sizeof(HT_zone))
+#define ZONE_MAP_SUFFIX ".zm"
+#define MORSEL_BUCKETS 4
+#define PAX_RECORD_COLUMN 4
 #define CALL_OR_DIE(call)     \
   {                           \
     BF_ErrorCode code = call; \
@@ -30,6 +40,12 @@ HT_info* createHT_info(int fileDescriptor, int numOfBuckets){
     info->isHashTable = true;
     info->fileDesc = fileDescriptor;
     info->numOfBuckets = numOfBuckets;
+    info->zoneMapDesc = 0;              // Set by HT_OpenFile.
+    info->hasZoneMap = false;
+    info->layout = HT_ROW;
+    info->block = NULL;                 // Made by HT_OpenFile.
+    info->newBlock = NULL;
+    info->readOnly = false;             // Set by HT_OpenFileReadOnly.
 
     return info;
 }
@@ -42,52 +58,63 @@ HT_block_info* createHT_block_info(int index, int next){
     blockInfo->blockIndex = index;
     blockInfo->next = next;
     blockInfo->numOfRecords = 0;
+    blockInfo->extentEnd = index + 1;
 
     return blockInfo;
 }
 
 // Allocated a new block and returns its ID.
+// The block stays pinned inside the handle info->newBlock, so the caller can fill it
+// without getting it again, and must unpin it. info->block can stay pinned meanwhile.
 int createBlock(HT_info* info){
-    BF_Block* block;
-	BF_Block_Init(&block);
-		
-    // Allocate a new block
-	CALL_OR_DIE(BF_AllocateBlock(info->fileDesc, block));
-
-    // Malloc a pointer where we will write the total blocks number
-    int *blocksNum = malloc(sizeof(int)); 
-
-    // Get the total numbers of the blocks
-	CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, blocksNum));
+    // Allocate a new block, pinned once
+    int index;
+	CALL_OR_DIE(BF_AllocateBlockId(info->fileDesc, info->newBlock, &index));
 
-    // Get the index of the last block we just allocated
-	int index = *blocksNum - 1;
-    // Get the block with this specific index
-	CALL_OR_DIE(BF_GetBlock(info->fileDesc, index, block));
-
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Allocate the HT_block_info struct and initiallize it.
-    HT_block_info* blockInfo = createHT_block_info(index, -1);
+    // The HT_block_info of an empty block without a next block, alone in its extent.
+    HT_block_info blockInfo = { index, UNITIALLIZED, 0, index + 1 };
 
     // Move to the end of the block to store the struct BlockInfo
-    data += BF_BLOCK_SIZE - sizeof(*blockInfo);
+	char *data = BF_Block_GetData(info->newBlock) + BF_BLOCK_SIZE - sizeof(blockInfo);
+	memcpy(data, &blockInfo, sizeof(blockInfo));
 
-	memcpy(data, blockInfo, sizeof(*blockInfo));
-
-	BF_Block_SetDirty(block);
-    CALL_OR_DIE(BF_UnpinBlock(block));
-	BF_Block_Destroy(&block);
-
-    // Store the blockId so we can return it
-	int blockId = blockInfo->blockIndex;
+    return index;
+}
 
-    // Memory managment
-	free(blockInfo);
-	free(blocksNum);
+// Returns the block after currentBlock, the last block of a chain with chainLength blocks,
+// whose extent ends before extentEnd.
+// While the extent of currentBlock has blocks left the next one is used. Otherwise a new
+// extent is allocated, whose blocks start empty, reserved and with the end of the extent.
+// The block stays pinned inside info->newBlock like createBlock leaves it, and the caller must unpin it.
+static int nextChainBlock(HT_info* info, int currentBlock, int extentEnd, int chainLength){
+    int newBlock = currentBlock + 1;
+    if(newBlock >= extentEnd){
+        int extentSize = chainLength < HT_MIN_EXTENT ? HT_MIN_EXTENT : chainLength;
+        if(extentSize > HT_MAX_EXTENT)
+            extentSize = HT_MAX_EXTENT;
+        // The first block of the extent is used at once, so it is allocated pinned inside
+        // info->newBlock, and only the rest of the extent goes through another handle.
+        CALL_OR_DIE(BF_AllocateBlockId(info->fileDesc, info->newBlock, &newBlock));
+        HT_block_info blockInfo = { newBlock, UNITIALLIZED, 0, newBlock + extentSize };
+        char* data = BF_Block_GetData(info->newBlock) + BF_BLOCK_SIZE - sizeof(blockInfo);
+        memcpy(data, &blockInfo, sizeof(blockInfo));
+
+        char reserved[BF_BLOCK_SIZE];
+        memset(reserved, 0, sizeof(reserved));
+        blockInfo.blockIndex = UNITIALLIZED;
+        memcpy(reserved + BF_BLOCK_SIZE - sizeof(blockInfo), &blockInfo, sizeof(blockInfo));
+        BF_Block* block;
+        BF_Block_Init(&block);
+        int firstReserved;
+        CALL_OR_DIE(BF_AllocateBlocks(info->fileDesc, extentSize - 1, block, reserved, &firstReserved));
+        BF_Block_Destroy(&block);
+        return newBlock;
+    }
 
-    return blockId;
+    // The block is not reserved anymore.
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, newBlock, info->newBlock));
+    memcpy(BF_Block_GetData(info->newBlock) + BF_BLOCK_SIZE - sizeof(HT_block_info), &newBlock, sizeof(int));
+    return newBlock;
 }
 
 // Creates the buckets of the hashTable
@@ -123,34 +150,37 @@ void createBuckets(HT_info* info){
     BF_Block_Destroy(&block);
 }
 
-// Check if a specific bucket is unitiallized.
-// If it is allocate a new block and let bucket point to that block.
-// If it is NOT just return and do nothing.
-void checkBucket(HT_info* info, int* buckets, int hashedId){
-    // If the bucket is initiallized return
-    if(buckets[hashedId] != UNITIALLIZED)
-        return;
-
-    BF_Block* block;
-    BF_Block_Init(&block); // Initiallize the struct BF_Block.
-    // If it isn't:
-    // Add the new block inside the bucket at the position of the hashed id.
-    buckets[hashedId] = createBlock(info);
+// Returns the first block of the bucket hashedId.
+// Only this bucket is read from the block of the buckets, not the whole array.
+static int readBucket(HT_info* info, int hashedId){
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(info->fileDesc, 1, info->block, &data));
+    int bucket;
+    memcpy(&bucket, data + hashedId * sizeof(int), sizeof(int));
+    CALL_OR_DIE(BF_ReleaseBlock(info->fileDesc, info->block));
+    return bucket;
+}
 
+// Returns the first block of the bucket hashedId.
+// If the bucket is unitiallized allocate a new block and let bucket point to that block.
+int checkBucket(HT_info* info, int hashedId){
     // Get the block that holds all the buckets
-    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, block));
-    // Get the data of this block
-	char* data = BF_Block_GetData(block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, info->block));
     // Go to the right data's position
-    data += hashedId * sizeof(int); 
-    // Store the block into the bucket position
-    memcpy(data, &buckets[hashedId], sizeof(int));
-
-    // Write the block back to the disk.
-    BF_Block_SetDirty(block);
-    CALL_OR_DIE(BF_UnpinBlock(block));
-    // Memory managment
-    BF_Block_Destroy(&block);
+	char* data = BF_Block_GetData(info->block) + hashedId * sizeof(int);
+    int bucket;
+    memcpy(&bucket, data, sizeof(int));
+
+    if(bucket == UNITIALLIZED){
+        // Add the new block inside the bucket at the position of the hashed id.
+        bucket = createBlock(info);
+        CALL_OR_DIE(BF_UnpinBlock(info->newBlock));
+        memcpy(data, &bucket, sizeof(int));
+        // Write the block back to the disk.
+        BF_Block_SetDirty(info->block);
+    }
+    CALL_OR_DIE(BF_UnpinBlock(info->block));
+    return bucket;
 }
 
 // Frees the memory of the structs HT_info, HT_block_info.
@@ -159,14 +189,116 @@ void infoDestroy(HT_info* info, HT_block_info* block_info){
     free(block_info);
 }
 
-// Checks if a specific file is a hashTable file
-bool isHashTable(HT_info* info){
-    if(info->isHashTable)
-        return false;
-    return true;
+// Returns the name of the zone map file of the hash file fileName.
+// The caller must free it.
+static char* zoneMapName(const char* fileName){
+    char* name = malloc(strlen(fileName) + strlen(ZONE_MAP_SUFFIX) + 1);
+    strcpy(name, fileName);
+    strcat(name, ZONE_MAP_SUFFIX);
+    return name;
+}
+
+// Widens the zone of the block blockId so it holds id.
+// The blocks of the zone map file are allocated when the hash file reaches them.
+// It uses the handle info->block, which must not be pinned. A file without a zone map has no zones.
+static void updateZone(HT_info* info, int blockId, int id){
+    BF_Block* block = info->block;
+    if(!info->hasZoneMap)
+        return;
+
+    int zoneBlock = blockId / ZONES_PER_BLOCK;
+    int numOfZoneBlocks;
+    CALL_OR_DIE(BF_GetBlockCounter(info->zoneMapDesc, &numOfZoneBlocks));
+    if(numOfZoneBlocks <= zoneBlock){
+        // The new blocks of the zone map start with empty zones.
+        HT_zone zones[BF_BLOCK_SIZE / sizeof(HT_zone)];
+        memset(zones, 0, sizeof(zones));
+        for(int i = 0; i < ZONES_PER_BLOCK; i++){
+            zones[i].minId = INT_MAX;
+            zones[i].maxId = INT_MIN;
+        }
+        int firstZoneBlock;
+        CALL_OR_DIE(BF_AllocateBlocks(info->zoneMapDesc, zoneBlock + 1 - numOfZoneBlocks, block, (char*)zones, &firstZoneBlock));
+    }
+
+    CALL_OR_DIE(BF_GetBlock(info->zoneMapDesc, zoneBlock, block));
+    HT_zone* zone = (HT_zone*)BF_Block_GetData(block) + blockId % ZONES_PER_BLOCK;
+    if(id < zone->minId || id > zone->maxId){
+        if(id < zone->minId)
+            zone->minId = id;
+        if(id > zone->maxId)
+            zone->maxId = id;
+        BF_Block_SetDirty(block);
+    }
+    CALL_OR_DIE(BF_UnpinBlock(block));
+}
+
+// Returns the bytes of a column of the HT_PAX layout.
+// The columns 0 .. PAX_RECORD_COLUMN - 1 are the attributes, in the order of Record_Attribute.
+static ulint paxColumnSize(int column){
+    if(column == PAX_RECORD_COLUMN)
+        return sizeof(((Record*)0)->record);
+    return attributeSize(column);
+}
+
+// Returns the offset of a column inside a Record.
+static ulint recordColumnOffset(int column){
+    if(column == PAX_RECORD_COLUMN)
+        return offsetof(Record, record);
+    return attributeOffset(column);
+}
+
+// Returns the offset inside a block of the first value of a column of the HT_PAX layout.
+// Every column holds room for MAX_RECORDS_PER_BLOCK values.
+static ulint paxColumnOffset(int column){
+    ulint recordsPerBlock = MAX_RECORDS_PER_BLOCK;
+    ulint offset = 0;
+    for(int c = 0; c < column; c++)
+        offset += recordsPerBlock * paxColumnSize(c);
+    return offset;
+}
+
+ulint HT_FieldOffset(HT_Layout layout, Record_Attribute attribute, int r){
+    if(layout == HT_PAX)
+        return paxColumnOffset(attribute) + r * attributeSize(attribute);
+    return r * sizeof(Record) + attributeOffset(attribute);
+}
+
+void HT_ReadRecord(HT_Layout layout, const char* data, int r, Record* record){
+    if(layout == HT_ROW){
+        memcpy(record, data + r * sizeof(Record), sizeof(Record));
+        return;
+    }
+    for(int c = 0; c <= PAX_RECORD_COLUMN; c++)
+        memcpy((char*)record + recordColumnOffset(c), data + paxColumnOffset(c) + r * paxColumnSize(c), paxColumnSize(c));
+}
+
+void HT_WriteRecord(HT_Layout layout, char* data, int r, const Record* record){
+    if(layout == HT_ROW){
+        memcpy(data + r * sizeof(Record), record, sizeof(Record));
+        return;
+    }
+    for(int c = 0; c <= PAX_RECORD_COLUMN; c++)
+        memcpy(data + paxColumnOffset(c) + r * paxColumnSize(c), (const char*)record + recordColumnOffset(c), paxColumnSize(c));
+}
+
+// Calls callback for the record r of the data of a block.
+// With the HT_ROW layout the record is passed where it is, otherwise it is copied first.
+static int callRecord(HT_Layout layout, const char* data, int r, HT_ScanCallback callback, void* argument){
+    if(layout == HT_ROW)
+        return callback((const Record*)(data + r * sizeof(Record)), argument);
+    Record record;
+    HT_ReadRecord(layout, data, r, &record);
+    return callback(&record, argument);
 }
 
 int HT_CreateFile(char *fileName, int buckets){
+    return HT_CreateFileWithLayout(fileName, buckets, HT_ROW);
+}
+
+int HT_CreateFileWithLayout(char *fileName, int buckets, HT_Layout layout){
+    if(layout != HT_ROW && layout != HT_PAX)
+        return -1;
     BF_Block* block;
 
     BF_Block_Init(&block); // Initiallize the struct BF_Block.
@@ -175,12 +307,14 @@ int HT_CreateFile(char *fileName, int buckets){
     int fileDescriptor; // The file descriptor of the file we are going to open.
 	CALL_OR_DIE(BF_OpenFile(fileName, &fileDescriptor)); // Open the file
 
-	CALL_OR_DIE(BF_AllocateBlock(fileDescriptor, block));
+    int blockId;
+	CALL_OR_DIE(BF_AllocateBlockId(fileDescriptor, block, &blockId));
 
     char* data = BF_Block_GetData(block);
 
     // Create struct HT_info
 	HT_info* info = createHT_info(fileDescriptor, buckets); 
+    info->layout = layout;
 	// Store the info
     memcpy(data, info, sizeof(*info));
 
@@ -204,88 +338,127 @@ int HT_CreateFile(char *fileName, int buckets){
     // Close the file
     CALL_OR_DIE(BF_CloseFile(fileDescriptor));
 
+    // Create the empty zone map file.
+    char* zoneMapFileName = zoneMapName(fileName);
+    CALL_OR_DIE(BF_CreateFile(zoneMapFileName));
+
     // Memory managment
+    free(zoneMapFileName);
     BF_Block_Destroy(&block);
     infoDestroy(info, blockInfo);
 
     return 0;
 }
 
-HT_info* HT_OpenFile(char *fileName){
+// Opens the hash file for HT_OpenFile, or for HT_OpenFileReadOnly if readOnly is true.
+static HT_info* openFile(char *fileName, bool readOnly){
+    int fileDescriptor;                     // FileDescriptor
+
+    if(readOnly){
+        // Map the file, a file that can not be mapped is not opened.
+        if(BF_OpenFileMapped(fileName, &fileDescriptor) != BF_OK)
+            return NULL;
+    }
+    else
+        CALL_OR_DIE(BF_OpenFileWithPrefetch(fileName, &fileDescriptor));    // Open the file, with read-ahead hints for the chain walks
+
     BF_Block* block;                        // block
     BF_Block_Init(&block);                  // Initiallize the BF_Block.
 
     HT_info* info = malloc(sizeof(*info));  // Allocate the struct with the metadata
 
-    int fileDescriptor;                     // FileDescriptor
-
-    CALL_OR_DIE(BF_OpenFile(fileName, &fileDescriptor));    // Open the file
     CALL_OR_DIE(BF_GetBlock(fileDescriptor, 0, block));     // Get the first block
     char* data = BF_Block_GetData(block);                   // Get the data of the first block
 
     // Copy the HT_info of file
     memcpy(info, data, sizeof(*info));
+
+    // Check if the file is a HT file, before anything else is allocated or opened for it.
+    if(!info->isHashTable){
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        CALL_OR_DIE(BF_CloseFileWithPrefetch(fileDescriptor));
+        BF_Block_Destroy(&block);
+        free(info);
+        return NULL;
+    }
+
     // Update fileName
     // We allocate it inside openFile so we can free the pointer.
     info->fileName = malloc(strlen(fileName) + 1);
     strcpy(info->fileName, fileName);
+    // The fileDesc stored inside the file is the one it had when it was created.
+    info->fileDesc = fileDescriptor;
+    // Open the zone map file too, if the file has one.
+    char* zoneMapFileName = zoneMapName(fileName);
+    info->hasZoneMap = access(zoneMapFileName, F_OK) == 0;
+    if(info->hasZoneMap){
+        int zoneMapDescriptor;
+        CALL_OR_DIE(BF_OpenFile(zoneMapFileName, &zoneMapDescriptor));
+        info->zoneMapDesc = zoneMapDescriptor;
+    }
+    free(zoneMapFileName);
+    info->readOnly = readOnly;
 
-    // Copy the HT_info of file
-    memcpy(data, info, sizeof(*info));
-
-    // Check if the file is a HT file
-    if(isHashTable(info))
-        return NULL;
+    // Copy the HT_info of file, a read-only file is left as it is.
+    if(!readOnly)
+        memcpy(data, info, sizeof(*info));
 
     // Unpin the block
     CALL_OR_DIE(BF_UnpinBlock(block));
 
     BF_Block_Destroy(&block);
 
+    // The handles of the insert and lookup paths are made once for every open file.
+    BF_Block_Init(&info->block);
+    BF_Block_Init(&info->newBlock);
+
     return info;
 }
 
+HT_info* HT_OpenFile(char *fileName){
+    return openFile(fileName, false);
+}
+
+HT_info* HT_OpenFileReadOnly(char *fileName){
+    return openFile(fileName, true);
+}
+
 
 int HT_CloseFile(HT_info* HT_info){
-    // Close the file
-    CALL_OR_DIE(BF_CloseFile(HT_info->fileDesc));
+    // Close the file and its zone map
+    CALL_OR_DIE(BF_CloseFileWithPrefetch(HT_info->fileDesc));
+    if(HT_info->hasZoneMap)
+        CALL_OR_DIE(BF_CloseFile(HT_info->zoneMapDesc));
 
     // memory managment
+    BF_Block_Destroy(&HT_info->block);
+    BF_Block_Destroy(&HT_info->newBlock);
     free(HT_info->fileName);
     free(HT_info);
     return 0;
 }
 
 int HT_InsertEntry(HT_info* ht_info, Record record){
-    BF_Block *block;
-	BF_Block_Init(&block);
-
-    // Get the block where we have stored the buckets
-    CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, 1, block));
+    // The mapping of a read-only file can not be written.
+    if(ht_info->readOnly)
+        return -1;
 
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Malloc an array to hold the buckets 
-    int *arrayOfBuckets = malloc(ht_info->numOfBuckets * sizeof(int));
-    // Copy data of buckets into the array
-    memcpy(arrayOfBuckets, data, ht_info->numOfBuckets * sizeof(int));
-
-    // Unpin the block with the buckets we dont need it anymore
-    CALL_OR_DIE(BF_UnpinBlock(block));
+    // The handle of the file, so an insert does not allocate any memory.
+    BF_Block *block = ht_info->block;
+    char* data;
 
     // hash the id because we need to store the hashed_id into the buckets.
     int hashedId = record.id % ht_info->numOfBuckets;
 
-    // Check if a specific bucket is unitiallized.
-    // If it is allocate a new block and let bucket point to that block.
-    // If it is NOT just return and do nothing.
-    checkBucket(ht_info, arrayOfBuckets, hashedId);
+    // Get the first block of the bucket.
+    // If the bucket is unitiallized a new block is allocated for it.
+    int currentBlock = checkBucket(ht_info, hashedId);
 
     // Find the last block inside the bucket that is empty.
-    int currentBlock = arrayOfBuckets[hashedId];
     int nextBlock = currentBlock;
+    int chainLength = 0;
     while(nextBlock != UNITIALLIZED){
+        chainLength++;
         // Get the block of the nextBlockId
         CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, nextBlock, block));
         // Get the data of this block
@@ -312,16 +485,20 @@ int HT_InsertEntry(HT_info* ht_info, Record record){
     // if the numOfRecords == MAX_RECORDS_PER_BLOCK allocate a new block and update 
     // the currentBlock so its next block will be the block we just allocated
     if(numOfRecords == MAX_RECORDS_PER_BLOCK){ 
-        int newBlock = createBlock(ht_info);  // create a new block
+        // The next block of the extent of the currentBlock, or the first one of a new extent,
+        // pinned inside ht_info->newBlock
+        int extentEnd;
+        memcpy(&extentEnd, BF_Block_GetData(block) + BYTES_UNTIL_EXTENT_END, sizeof(int));
+        int newBlock = nextChainBlock(ht_info, currentBlock, extentEnd, chainLength);
         data -= sizeof(int);                  // Go to the next field of the ht_block_info struct of the currentBlock  
         memcpy(data, &newBlock, sizeof(int)); // Pass the updated next into the next field of the ht_block_info struct of the currentBlock  
         // Write changes to block
         BF_Block_SetDirty(block);   
         CALL_OR_DIE(BF_UnpinBlock(block));
-        // Get the new block and its data
-        CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, newBlock, block));
+        // The new block is still pinned, fill it.
+        block = ht_info->newBlock;
         char* data = BF_Block_GetData(block); 
-        memcpy(data, &record, sizeof(record)); // Insert the record into the new block
+        HT_WriteRecord(ht_info->layout, data, 0, &record); // Insert the record into the new block
         data += BYTES_UNTIL_NUM_OF_RECORDS; // Go to the HT_block_info.numOfRecords location 
         // Update the numOfRecords of ht_block_info of the newBlock
         // and write it back to the data.
@@ -331,204 +508,545 @@ int HT_InsertEntry(HT_info* ht_info, Record record){
         // Write changes to block
         BF_Block_SetDirty(block);
         CALL_OR_DIE(BF_UnpinBlock(block));
-
-        // Memory Managment
-        BF_Block_Destroy(&block);
-        free(arrayOfBuckets);
+        updateZone(ht_info, newBlock, record.id);
         return newBlock;
     }
     // If we have enough space for one more block:
     // Go back to the start of the data of the currentBlock
     data -= BYTES_UNTIL_NUM_OF_RECORDS;
 
-    // Calculate the position that the record should be inserted.
-    data += numOfRecords * sizeof(record);    
-    // Insert the record   
-    memcpy(data, &record, sizeof(record)); 
+    // Insert the record after the last one, where the layout places it.
+    HT_WriteRecord(ht_info->layout, data, numOfRecords, &record);
     // Update numOfRecords
     numOfRecords++; 
     // Go to the HT_block_info.numOfRecords location
-    data += BYTES_UNTIL_NUM_OF_RECORDS - ((numOfRecords - 1) * sizeof(Record));
+    data += BYTES_UNTIL_NUM_OF_RECORDS;
     memcpy(data, &numOfRecords, sizeof(ulint));
 
     // Write changes to block
     BF_Block_SetDirty(block);
     CALL_OR_DIE(BF_UnpinBlock(block));
-    BF_Block_Destroy(&block);
-    free(arrayOfBuckets);
+    updateZone(ht_info, currentBlock, record.id);
     return currentBlock;
 }
 
 int HT_GetAllEntries(HT_info* ht_info, int value){
-    BF_Block *block;
-	BF_Block_Init(&block);
-
-    // Get the block where we have store the buckets
-    CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, 1, block));
-
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Malloc an array to hold the buckets 
-    int *arrayOfBuckets = malloc(ht_info->numOfBuckets * sizeof(int));
-    // Copy data of buckets into the array
-    memcpy(arrayOfBuckets, data, ht_info->numOfBuckets * sizeof(int));
-
-    // Unpin the block we dont need it anymore.
-    CALL_OR_DIE(BF_UnpinBlock(block));
+    // The handle of the file, so a lookup does not allocate any memory.
+    BF_Block *block = ht_info->block;
 
     // Find the hased id of the records.
     // The records we want are going to have this specific hashedId
     int hashedId = value % ht_info->numOfBuckets;
 
-    int currentBlock = arrayOfBuckets[hashedId];
+    // The ids of the records of a block are compared by the scan kernel.
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = value;
+    predicate.maxId = value;
+
+    int currentBlock = readBucket(ht_info, hashedId);
     int blocksRead = 1;
+    int prefetchedUntil = 0;     // The blocks of the chain before it were prefetched.
     // Iterate into all the blocks with this hashedId
     while(currentBlock != UNITIALLIZED){
 
-        // Get the block with id = currentBlock
-        CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, currentBlock, block));
-        // Get the data of this block
-        char* data = BF_Block_GetData(block);
+        // Get the data of the block with id = currentBlock
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(ht_info->fileDesc, currentBlock, block, &data));
+        const char* blockData = data;
         // Get the numOfRecords of the block
         data += BYTES_UNTIL_NUM_OF_RECORDS;
         ulint numOfRecords;
         memcpy(&numOfRecords, data, sizeof(ulint)); 
-        Record record;
         // Go back to the start of the currentBlock data
         data -= BYTES_UNTIL_NUM_OF_RECORDS;
-        for(int i = 0; i < numOfRecords; i++){
-            // Get the record
-            memcpy(&record, data, sizeof(record));
-            // Check if the record.id has the correct value
-            if (record.id == value){
-                printRecord(record);
-                
-                // Memory Managment
-                free(arrayOfBuckets);
-                CALL_OR_DIE(BF_UnpinBlock(block));
-				BF_Block_Destroy(&block);
-                return blocksRead;
-            }
-            // Go to the next Record
-			data += sizeof(Record);
+        // Check which records have the correct id
+        uint passed = filterBlock(data, ht_info->layout, numOfRecords, &predicate);
+        if(passed){
+            Record record;
+            HT_ReadRecord(ht_info->layout, data, __builtin_ctz(passed), &record);
+            printRecord(record);
+
+            CALL_OR_DIE(BF_ReleaseBlock(ht_info->fileDesc, block));
+            return blocksRead;
         }
         // There isnt any record with id == value inside this block.
         // Go to the next block.
         // Reset data.
-        data = BF_Block_GetData(block);
-        data += BYTES_UNTIL_NEXT;
-        memcpy(&currentBlock, data, sizeof(int));
-        CALL_OR_DIE(BF_UnpinBlock(block));
+        data = blockData;
+        int previousBlock = currentBlock;
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        // The chain goes on inside the extent, so the rest of the extent is read next.
+        // Ask for all of it at once, instead of one block after the other.
+        int extentEnd;
+        memcpy(&extentEnd, data + BYTES_UNTIL_EXTENT_END, sizeof(int));
+        if(currentBlock == previousBlock + 1 && extentEnd > prefetchedUntil){
+            BF_PrefetchBlocks(ht_info->fileDesc, currentBlock, extentEnd - currentBlock);
+            prefetchedUntil = extentEnd;
+        }
+        CALL_OR_DIE(BF_ReleaseBlock(ht_info->fileDesc, block));
         blocksRead++;
     }
 
-    // Memory Managment
+    // We didnt found any record with Id == value.
+    return -1;
+}
+
+// Pins the block blockId and calls callback for its records that pass the predicate.
+// *stop becomes true if the callback asks to stop.
+// Returns the next block of the chain of the block.
+static int scanBlock(HT_info* info, BF_Block* block, int blockId, const HT_Predicate* predicate,
+                     HT_ScanCallback callback, void* argument, int* recordsPassed, bool* stop){
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(info->fileDesc, blockId, block, &data));
+    ulint numOfRecords;
+    memcpy(&numOfRecords, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+    int next;
+    memcpy(&next, data + BYTES_UNTIL_NEXT, sizeof(int));
+
+    // The records are checked inside the pinned block.
+    uint passed = filterBlock(data, info->layout, numOfRecords, predicate);
+    while(passed && !*stop){
+        int r = __builtin_ctz(passed);
+        passed &= passed - 1;
+        (*recordsPassed)++;
+        if(callRecord(info->layout, data, r, callback, argument))
+            *stop = true;
+    }
+
+    CALL_OR_DIE(BF_ReleaseBlock(info->fileDesc, block));
+    return next;
+}
+
+// Scans the bucket chains one after the other.
+// *blocksRead gets the number of blocks that were read. Returns the number of records that passed.
+static int scanBuckets(HT_info* info, const HT_Predicate* predicate, HT_ScanCallback callback, void* argument, int* blocksRead){
+    BF_Block *block;
+	BF_Block_Init(&block);
+
+    // Get the block where we have store the buckets and copy them.
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(info->fileDesc, 1, block, &data));
+    int *arrayOfBuckets = malloc(info->numOfBuckets * sizeof(int));
+    memcpy(arrayOfBuckets, data, info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_ReleaseBlock(info->fileDesc, block));
+
+    *blocksRead = 0;
+    int recordsPassed = 0;
+    bool stop = false;
+    for(int i = 0; i < info->numOfBuckets && !stop; i++){
+        int currentBlock = arrayOfBuckets[i];
+        while(currentBlock != UNITIALLIZED && !stop){
+            currentBlock = scanBlock(info, block, currentBlock, predicate, callback, argument, &recordsPassed, &stop);
+            (*blocksRead)++;
+        }
+    }
+
     free(arrayOfBuckets);
     BF_Block_Destroy(&block);
+    return recordsPassed;
+}
 
-    // We didnt found any record with Id == value.
+// Scans, in block order, only the blocks whose zone overlaps the id bounds of the predicate.
+// *blocksRead gets the number of blocks that were read. Returns the number of records that passed.
+static int scanZones(HT_info* info, const HT_Predicate* predicate, HT_ScanCallback callback, void* argument, int* blocksRead){
+    BF_Block *block;
+	BF_Block_Init(&block);
+
+    int numOfBlocks;
+    CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, &numOfBlocks));
+    int numOfZoneBlocks;
+    CALL_OR_DIE(BF_GetBlockCounter(info->zoneMapDesc, &numOfZoneBlocks));
+
+    *blocksRead = 0;
+    int recordsPassed = 0;
+    bool stop = false;
+    HT_zone zones[ZONES_PER_BLOCK];
+    for(int zoneBlock = 0; zoneBlock < numOfZoneBlocks && !stop; zoneBlock++){
+        // Copy the zones of the next ZONES_PER_BLOCK blocks.
+        CALL_OR_DIE(BF_GetBlock(info->zoneMapDesc, zoneBlock, block));
+        memcpy(zones, BF_Block_GetData(block), sizeof(zones));
+        CALL_OR_DIE(BF_UnpinBlock(block));
+
+        for(int i = 0; i < ZONES_PER_BLOCK && !stop; i++){
+            int blockId = zoneBlock * ZONES_PER_BLOCK + i;
+            if(blockId >= numOfBlocks)
+                break;
+            // Skip the blocks whose ids are all outside the range, without reading them.
+            // The empty blocks and the first two blocks of the file always have an empty zone.
+            if(zones[i].maxId < predicate->minId || zones[i].minId > predicate->maxId)
+                continue;
+            scanBlock(info, block, blockId, predicate, callback, argument, &recordsPassed, &stop);
+            (*blocksRead)++;
+        }
+    }
+
+    BF_Block_Destroy(&block);
+    return recordsPassed;
+}
+
+// HT_ScanCallback that prints the record.
+static int printCallback(const Record* record, void* argument){
+    (void)argument;
+    printRecord(*record);
+    return 0;
+}
+
+HT_Predicate HT_AllRecords(void){
+    HT_Predicate predicate;
+    predicate.minId = INT_MIN;
+    predicate.maxId = INT_MAX;
+    predicate.name = NULL;
+    predicate.surname = NULL;
+    predicate.city = NULL;
+    return predicate;
+}
+
+int HT_Scan(HT_info* ht_info, const HT_Predicate* predicate, HT_ScanCallback callback, void* argument){
+    HT_Predicate allRecords = HT_AllRecords();
+    if(predicate == NULL)
+        predicate = &allRecords;
+
+    int blocksRead;
+    if(ht_info->hasZoneMap && (predicate->minId != INT_MIN || predicate->maxId != INT_MAX))
+        return scanZones(ht_info, predicate, callback, argument, &blocksRead);
+    return scanBuckets(ht_info, predicate, callback, argument, &blocksRead);
+}
+
+int HT_GetRangeEntries(HT_info* ht_info, int low, int high){
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = low;
+    predicate.maxId = high;
+
+    int blocksRead;
+    int recordsPassed = ht_info->hasZoneMap ? scanZones(ht_info, &predicate, printCallback, NULL, &blocksRead)
+                                            : scanBuckets(ht_info, &predicate, printCallback, NULL, &blocksRead);
+    if(recordsPassed > 0)
+        return blocksRead;
+    // We didnt found any record inside the range.
     return -1;
 }
 
+// Serializes the calls to the BF level of the threads of a parallel walk and of their callbacks.
+static pthread_mutex_t blockLevelMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void HT_LockBlockLevel(void){
+    pthread_mutex_lock(&blockLevelMutex);
+}
+
+void HT_UnlockBlockLevel(void){
+    pthread_mutex_unlock(&blockLevelMutex);
+}
+
+// A parallel walk over the bucket chains, shared by all the threads.
+// The threads take morsels of MORSEL_BUCKETS buckets with an atomic counter,
+// so a thread that finishes its morsel early takes the next one instead of waiting.
+typedef struct ParallelWalk {
+    HT_info* info;
+    int* arrayOfBuckets;            // Copy of the buckets.
+    int nextBucket;                 // First bucket of the next morsel, changed atomically.
+    bool stop;                      // Set atomically when a thread asks every thread to stop.
+    // Called for every block of bucket with its data pinned and the partial result of the thread.
+    // A nonzero return value stops every thread.
+    int (*visitBlock)(struct ParallelWalk* walk, const char* data, int bucket, void* partial);
+    const HT_Predicate* predicate;  // The predicate of HT_ParallelScan.
+    HT_ScanCallback callback;       // The callback of HT_ParallelScan.
+} ParallelWalk;
+
+// The partial result of a thread of a ParallelWalk.
+typedef struct {
+    ParallelWalk* walk;
+    void* partial;
+} WalkThread;
+
+// Walks the chains of the morsels that the thread takes.
+static void* walkMorsels(void* argument){
+    WalkThread* thread = argument;
+    ParallelWalk* walk = thread->walk;
+
+    BF_Block *block;
+    pthread_mutex_lock(&blockLevelMutex);
+	BF_Block_Init(&block);
+    pthread_mutex_unlock(&blockLevelMutex);
+
+    while(!__atomic_load_n(&walk->stop, __ATOMIC_RELAXED)){
+        int first = __atomic_fetch_add(&walk->nextBucket, MORSEL_BUCKETS, __ATOMIC_RELAXED);
+        if(first >= walk->info->numOfBuckets)
+            break;
+        int last = first + MORSEL_BUCKETS;
+        if(last > walk->info->numOfBuckets)
+            last = walk->info->numOfBuckets;
+
+        for(int i = first; i < last && !__atomic_load_n(&walk->stop, __ATOMIC_RELAXED); i++){
+            int currentBlock = walk->arrayOfBuckets[i];
+            while(currentBlock != UNITIALLIZED){
+                // The blocks of a read-only file are read from its mapping, without the BF level.
+                const char* data;
+                if(!walk->info->readOnly)
+                    pthread_mutex_lock(&blockLevelMutex);
+                CALL_OR_DIE(BF_GetBlockData(walk->info->fileDesc, currentBlock, block, &data));
+                if(!walk->info->readOnly)
+                    pthread_mutex_unlock(&blockLevelMutex);
+
+                // The block stays pinned, so the other threads can use the BF level meanwhile.
+                memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+                if(walk->visitBlock(walk, data, i, thread->partial))
+                    __atomic_store_n(&walk->stop, true, __ATOMIC_RELAXED);
+
+                if(!walk->info->readOnly)
+                    pthread_mutex_lock(&blockLevelMutex);
+                CALL_OR_DIE(BF_ReleaseBlock(walk->info->fileDesc, block));
+                if(!walk->info->readOnly)
+                    pthread_mutex_unlock(&blockLevelMutex);
+                if(__atomic_load_n(&walk->stop, __ATOMIC_RELAXED))
+                    break;
+            }
+        }
+    }
+
+    pthread_mutex_lock(&blockLevelMutex);
+    BF_Block_Destroy(&block);
+    pthread_mutex_unlock(&blockLevelMutex);
+    return NULL;
+}
+
+// Returns the number of threads to use for numOfThreads.
+static int threadsToUse(int numOfThreads){
+    if(numOfThreads <= 0)
+        numOfThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(numOfThreads < 1)
+        numOfThreads = 1;
+    if(numOfThreads > HT_MAX_SCAN_THREADS)
+        numOfThreads = HT_MAX_SCAN_THREADS;
+    return numOfThreads;
+}
+
+// Runs the walk on numOfThreads threads, the caller being the first of them.
+// Thread t gets partials[t].
+static void runWalk(ParallelWalk* walk, int numOfThreads, void** partials){
+    BF_Block *block;
+	BF_Block_Init(&block);
+    // Get the block where we have store the buckets and copy them.
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(walk->info->fileDesc, 1, block, &data));
+    walk->arrayOfBuckets = malloc(walk->info->numOfBuckets * sizeof(int));
+    memcpy(walk->arrayOfBuckets, data, walk->info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_ReleaseBlock(walk->info->fileDesc, block));
+    BF_Block_Destroy(&block);
+
+    walk->nextBucket = 0;
+    walk->stop = false;
+
+    pthread_t threads[HT_MAX_SCAN_THREADS];
+    WalkThread walkThreads[HT_MAX_SCAN_THREADS];
+    int numOfStarted = 1;
+    for(int t = 0; t < numOfThreads; t++){
+        walkThreads[t].walk = walk;
+        walkThreads[t].partial = partials[t];
+    }
+    // If a thread can not be created, the started ones do its morsels.
+    for(int t = 1; t < numOfThreads; t++){
+        if(pthread_create(&threads[t], NULL, walkMorsels, &walkThreads[t]))
+            break;
+        numOfStarted++;
+    }
+    walkMorsels(&walkThreads[0]);
+    for(int t = 1; t < numOfStarted; t++)
+        pthread_join(threads[t], NULL);
+
+    free(walk->arrayOfBuckets);
+}
+
+// The partial result of a thread of HT_ParallelScan.
+typedef struct {
+    void* argument;                 // The argument of the callback of the thread.
+    int recordsPassed;              // Number of records that were passed to the callback.
+} ScanPartial;
+
+// Calls the callback of the walk for the records of the block that pass its predicate.
+static int scanVisit(ParallelWalk* walk, const char* data, int bucket, void* partial){
+    (void)bucket;
+    ScanPartial* scan = partial;
+    ulint numOfRecords;
+    memcpy(&numOfRecords, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+
+    uint passed = filterBlock(data, walk->info->layout, numOfRecords, walk->predicate);
+    while(passed){
+        int r = __builtin_ctz(passed);
+        passed &= passed - 1;
+        scan->recordsPassed++;
+        if(callRecord(walk->info->layout, data, r, walk->callback, scan->argument))
+            return 1;
+    }
+    return 0;
+}
+
+int HT_ParallelScan(HT_info* ht_info, const HT_Predicate* predicate, HT_ScanCallback callback,
+                    void** arguments, int numOfThreads){
+    HT_Predicate allRecords = HT_AllRecords();
+    if(predicate == NULL)
+        predicate = &allRecords;
+    numOfThreads = threadsToUse(numOfThreads);
+
+    ParallelWalk walk;
+    walk.info = ht_info;
+    walk.visitBlock = scanVisit;
+    walk.predicate = predicate;
+    walk.callback = callback;
+
+    ScanPartial scans[HT_MAX_SCAN_THREADS];
+    void* partials[HT_MAX_SCAN_THREADS];
+    for(int t = 0; t < numOfThreads; t++){
+        scans[t].argument = arguments[t];
+        scans[t].recordsPassed = 0;
+        partials[t] = &scans[t];
+    }
+    runWalk(&walk, numOfThreads, partials);
+
+    int recordsPassed = 0;
+    for(int t = 0; t < numOfThreads; t++)
+        recordsPassed += scans[t].recordsPassed;
+    return recordsPassed;
+}
+
+// The partial result of a thread of HT_GetStatistics.
+typedef struct {
+    int* bucketRecords;             // Number of records of every bucket, shared by the threads.
+    int numOfBlocks;                // Number of blocks of the buckets the thread read.
+    int minId;                      // Smallest id of the records the thread read.
+    int maxId;                      // Biggest id of the records the thread read.
+} StatisticsPartial;
+
+// Adds the records of the block to its bucket and to the id bounds of the thread.
+// Every bucket is walked by one thread, so its counter is written by one thread only.
+static int statisticsVisit(ParallelWalk* walk, const char* data, int bucket, void* partial){
+    StatisticsPartial* statistics = partial;
+    ulint numOfRecords;
+    memcpy(&numOfRecords, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+    statistics->bucketRecords[bucket] += numOfRecords;
+    statistics->numOfBlocks++;
+
+    for(int r = 0; r < numOfRecords; r++){
+        int id;
+        memcpy(&id, data + HT_FieldOffset(walk->info->layout, ID, r), sizeof(int));
+        if(id < statistics->minId)
+            statistics->minId = id;
+        if(id > statistics->maxId)
+            statistics->maxId = id;
+    }
+    return 0;
+}
+
+int HT_GetStatistics(HT_info* ht_info, int numOfThreads, HT_statistics* statistics, int* bucketRecords){
+    if(!ht_info->isHashTable)
+        return -1;
+    numOfThreads = threadsToUse(numOfThreads);
+
+    int* records = calloc(ht_info->numOfBuckets, sizeof(int));
+    ParallelWalk walk;
+    walk.info = ht_info;
+    walk.visitBlock = statisticsVisit;
+
+    StatisticsPartial partials[HT_MAX_SCAN_THREADS];
+    void* partialPointers[HT_MAX_SCAN_THREADS];
+    for(int t = 0; t < numOfThreads; t++){
+        partials[t].bucketRecords = records;
+        partials[t].numOfBlocks = 0;
+        partials[t].minId = INT_MAX;
+        partials[t].maxId = INT_MIN;
+        partialPointers[t] = &partials[t];
+    }
+    runWalk(&walk, numOfThreads, partialPointers);
+
+    // Merge the partial results. On ties the smallest bucket id is kept,
+    // like a sequential walk over the buckets would do.
+    // The reserved blocks of the extents are not in a chain, so they are not counted.
+    statistics->numOfBucketBlocks = 0;
+    for(int t = 0; t < numOfThreads; t++)
+        statistics->numOfBucketBlocks += partials[t].numOfBlocks;
+    // The block of the HT_info and the block of the buckets.
+    statistics->numOfBlocks = 2 + statistics->numOfBucketBlocks;
+    statistics->numOfRecords = 0;
+    statistics->minRecords = INT_MAX;
+    statistics->minRecordsBucket = 0;
+    statistics->maxRecords = 0;
+    statistics->maxRecordsBucket = 0;
+    statistics->numOfBucketsOverflowed = 0;
+    statistics->minId = INT_MAX;
+    statistics->maxId = INT_MIN;
+    for(int i = 0; i < ht_info->numOfBuckets; i++){
+        statistics->numOfRecords += records[i];
+        if(records[i] > MAX_RECORDS_PER_BLOCK)
+            statistics->numOfBucketsOverflowed++;
+        if(records[i] > statistics->maxRecords){
+            statistics->maxRecords = records[i];
+            statistics->maxRecordsBucket = i;
+        }
+        if(records[i] < statistics->minRecords){
+            statistics->minRecords = records[i];
+            statistics->minRecordsBucket = i;
+        }
+    }
+    for(int t = 0; t < numOfThreads; t++){
+        if(partials[t].minId < statistics->minId)
+            statistics->minId = partials[t].minId;
+        if(partials[t].maxId > statistics->maxId)
+            statistics->maxId = partials[t].maxId;
+    }
+
+    if(bucketRecords != NULL)
+        memcpy(bucketRecords, records, ht_info->numOfBuckets * sizeof(int));
+    free(records);
+    return 0;
+}
+
 // We take as fact that the Hash Table file already exist.
 // Also you need to already have initiallized the BF level with BF_Init().
 // If it doesnt we have undefined behavior.
 int HashStatistics(char *fileName) {
     // Get the HT_info of the file.
     HT_info* info = HT_OpenFile(fileName);
+    if(info == NULL)
+        return -1;
+
+    // Read the buckets in parallel and hold the number of records of each one.
+    HT_statistics statistics;
+    int *bucketRecords = malloc(info->numOfBuckets * sizeof(int));
+    if(HT_GetStatistics(info, 0, &statistics, bucketRecords) == -1){
+        free(bucketRecords);
+        HT_CloseFile(info);
+        return -1;
+    }
 
     // Just for beauty
     printf("\n       Statistics of the HT_file\n");
     printf("---------------------------------------\n");
 
     //Number of blocks inside the file
-    int* numOfBlocks = malloc(sizeof(int)); 
-    CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, numOfBlocks));
-    printf("Number of blocks inside the HT_file:%d\n", *numOfBlocks);
+    printf("Number of blocks inside the HT_file:%d\n", statistics.numOfBlocks);
 
     // Avg blocks per bucket
-    int averageBlocksPerBucket = *numOfBlocks / info->numOfBuckets;
+    int averageBlocksPerBucket = statistics.numOfBucketBlocks / info->numOfBuckets;
     printf("Average number of blocks inside each bucket:%d\n\n", averageBlocksPerBucket);
 
-    BF_Block *block;
-	BF_Block_Init(&block);
-
-    // Get the block where we have store the buckets
-    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, block));
-
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Malloc an array to hold the buckets 
-    int *arrayOfBuckets = malloc(info->numOfBuckets * sizeof(int));
-    // Copy data of buckets into the array
-    memcpy(arrayOfBuckets, data, info->numOfBuckets * sizeof(int));
-
-    // Unpin the block
-    CALL_OR_DIE(BF_UnpinBlock(block));
-
-    // Iterate each bucket and hold the number of its records.    
-    int minRecords = INT_MAX;       // Minimum number of records in all the buckets.
-    int maxRecords = 0;             // Maximum number of records in all the buckets.
-    int minRecordsBucket = 0;       // Bucket's ID that holds the minimum number of records.
-    int maxRecordsBucket = 0;       // Bucket's ID that holds the maximum number of records.
-    int totalRecords = 0;           // Total records in all the buckets.
-    int numOfBucketsOverflowed = 0; // Number of buckets that have been overflowed.
     for(int i = 0; i < info->numOfBuckets; i++) {
         printf("BucketID:%d\n", i);
-        int numOfRecords = 0;
-        int currentBlock = arrayOfBuckets[i];
-        while(currentBlock != UNITIALLIZED){
-            int currentBlockRecords;
-            // Get the block where we have store the buckets
-            CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
-            // Get the data of this block
-	        char *data = BF_Block_GetData(block);
-            // Go to the Ht_block_info.numOfRecords 
-            data += BYTES_UNTIL_NUM_OF_RECORDS;
-            memcpy(&currentBlockRecords, data, sizeof(int));
-            numOfRecords += currentBlockRecords;
-            // Go to Ht_block_info.next 
-            data -= sizeof(int); 
-            memcpy(&currentBlock, data, sizeof(int));
-            BF_UnpinBlock(block);
-        }
-        //Update totalRecords counter 
-        totalRecords += numOfRecords;
         // If the number of records inside the bucket is greater than the maximun 
         // number of records inside one block it means that the bucket has been overflowed.
-        if(numOfRecords > MAX_RECORDS_PER_BLOCK){
+        if(bucketRecords[i] > MAX_RECORDS_PER_BLOCK){
             printf("Overflowed: YES\n");
-            numOfBucketsOverflowed++; // Update counter.
 
             // Number of OverflowedBlocks of each bucket = bucketInfo.numOfRecords / MAX_RECORDS_PER_BLOCK
             int maxRecordsPerBlock = MAX_RECORDS_PER_BLOCK;
-            printf("Number of Overflowed Blocks:%d\n\n", (numOfRecords / maxRecordsPerBlock));
-        }
-
-        if(numOfRecords > maxRecords){
-            maxRecords = numOfRecords;
-            maxRecordsBucket = i;
-        }
-        if(numOfRecords < minRecords){
-            minRecords = numOfRecords;
-            minRecordsBucket = i;
+            printf("Number of Overflowed Blocks:%d\n\n", (bucketRecords[i] / maxRecordsPerBlock));
         }
     }
 
-    printf("Bucket's id with LESS Records:%d and has %d Records\n", minRecordsBucket, minRecords);
-    printf("Bucket's id with MORE Records:%d and has %d Records\n", maxRecordsBucket, maxRecords);
-    printf("Average records per bucket:%ld\n", totalRecords/info->numOfBuckets);
-    printf("Number of buckets that have been Overflowed:%d\n", numOfBucketsOverflowed);
+    printf("Bucket's id with LESS Records:%d and has %d Records\n", statistics.minRecordsBucket, statistics.minRecords);
+    printf("Bucket's id with MORE Records:%d and has %d Records\n", statistics.maxRecordsBucket, statistics.maxRecords);
+    printf("Average records per bucket:%ld\n", statistics.numOfRecords/info->numOfBuckets);
+    printf("Number of buckets that have been Overflowed:%d\n", statistics.numOfBucketsOverflowed);
 
     CALL_OR_DIE(HT_CloseFile(info));
-    free(numOfBlocks);
-    free(arrayOfBuckets);
-    BF_Block_Destroy(&block);
+    free(bucketRecords);
     return 0;
 }
-
-
-
-
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bf.h"
+#include "ht_table.h"
+#include "record.h"
+#include "temp_file.h"
+#include "join.h"
+
+#define UNITIALLIZED -1
+#define HT_BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int) + sizeof(int)
+#define HT_BYTES_UNTIL_NEXT BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int)
+#define MIN_CAPACITY 64
+#define DEFAULT_MEMORY_BUDGET (1 << 20)
+#define PARTITION_BITS 4            // Bits of the hash that choose a partition, JOIN_GRACE_PARTITIONS <= 1 << PARTITION_BITS.
+#define MAX_LEVEL 7                 // The last level of partitions, whose bits end at the lowest bit of the hash.
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// The records of the build side of a join, chained by id.
+// heads[hash(id)] is the first record with the hash and next[r] the record after r, or -1.
+typedef struct {
+    Record* records;
+    int numOfRecords;
+    int capacity;                   // Room of records and next.
+    int* next;
+    int* heads;
+    int numOfHeads;                 // A power of 2.
+} RecordTable;
+
+// The state of a join, shared by the helpers.
+typedef struct {
+    JOIN_Callback callback;
+    void* argument;
+    int numOfPairs;                 // Number of pairs that were passed to callback.
+    bool stop;                      // True if callback asked to stop.
+    ulint memoryBudget;             // Bytes of the left records of a grace partition that are loaded at once.
+} Join;
+
+// Allocates an empty table.
+static void tableInit(RecordTable* table){
+    table->capacity = MIN_CAPACITY;
+    table->records = malloc(table->capacity * sizeof(Record));
+    table->next = malloc(table->capacity * sizeof(int));
+    table->numOfRecords = 0;
+    table->heads = NULL;
+    table->numOfHeads = 0;
+}
+
+// Adds a record, before the table is built.
+static void tableAdd(RecordTable* table, const Record* record){
+    if(table->numOfRecords == table->capacity){
+        table->capacity *= 2;
+        table->records = realloc(table->records, table->capacity * sizeof(Record));
+        table->next = realloc(table->next, table->capacity * sizeof(int));
+    }
+    table->records[table->numOfRecords++] = *record;
+}
+
+// Returns the head of the chain of an id.
+static int* headOf(RecordTable* table, int id){
+    return &table->heads[((uint)id * 2654435761u) & (table->numOfHeads - 1)];
+}
+
+// Chains the records that were added by their id, with at least as many heads as records.
+static void tableBuild(RecordTable* table){
+    int numOfHeads = MIN_CAPACITY;
+    while(numOfHeads < table->numOfRecords)
+        numOfHeads *= 2;
+    if(numOfHeads != table->numOfHeads){
+        free(table->heads);
+        table->heads = malloc(numOfHeads * sizeof(int));
+        table->numOfHeads = numOfHeads;
+    }
+    memset(table->heads, UNITIALLIZED, numOfHeads * sizeof(int));
+    for(int r = 0; r < table->numOfRecords; r++){
+        int* head = headOf(table, table->records[r].id);
+        table->next[r] = *head;
+        *head = r;
+    }
+}
+
+// Removes every record, so the table can be filled again.
+static void tableClear(RecordTable* table){
+    table->numOfRecords = 0;
+}
+
+// Frees the memory of the table.
+static void tableDestroy(RecordTable* table){
+    free(table->records);
+    free(table->next);
+    free(table->heads);
+}
+
+// Calls the callback of the join for every record of the built table with the id of the right record.
+static void probe(Join* join, RecordTable* table, const Record* right){
+    if(table->numOfRecords == 0)
+        return;
+    for(int r = *headOf(table, right->id); r != UNITIALLIZED && !join->stop; r = table->next[r]){
+        if(table->records[r].id != right->id)
+            continue;
+        join->numOfPairs++;
+        if(join->callback(&table->records[r], right, join->argument))
+            join->stop = true;
+    }
+}
+
+// Copies the bucket array of a hash file. The caller frees it.
+static int* readBuckets(HT_info* info){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, block));
+    int* arrayOfBuckets = malloc(info->numOfBuckets * sizeof(int));
+    memcpy(arrayOfBuckets, BF_Block_GetData(block), info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+    return arrayOfBuckets;
+}
+
+// Adds the records of the chain that starts at firstBlock to the table.
+static void loadChain(HT_info* info, BF_Block* block, int firstBlock, RecordTable* table){
+    int currentBlock = firstBlock;
+    while(currentBlock != UNITIALLIZED){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        ulint numOfRecords;
+        memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        Record record;
+        for(int r = 0; r < numOfRecords; r++){
+            HT_ReadRecord(info->layout, data, r, &record);
+            tableAdd(table, &record);
+        }
+        memcpy(&currentBlock, data + HT_BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+}
+
+// Probes the table with the records of the chain that starts at firstBlock.
+static void probeChain(Join* join, HT_info* info, BF_Block* block, int firstBlock, RecordTable* table){
+    int currentBlock = firstBlock;
+    while(currentBlock != UNITIALLIZED && !join->stop){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        ulint numOfRecords;
+        memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        Record record;
+        for(int r = 0; r < numOfRecords && !join->stop; r++){
+            HT_ReadRecord(info->layout, data, r, &record);
+            probe(join, table, &record);
+        }
+        memcpy(&currentBlock, data + HT_BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+}
+
+// Joins bucket i of left with bucket i of right, for every bucket.
+static void bucketJoin(Join* join, HT_info* left, HT_info* right){
+    int* leftBuckets = readBuckets(left);
+    int* rightBuckets = readBuckets(right);
+    BF_Block* block;
+    BF_Block_Init(&block);
+    RecordTable table;
+    tableInit(&table);
+
+    for(int i = 0; i < left->numOfBuckets && !join->stop; i++){
+        // A bucket that is empty on either side has no pairs.
+        if(leftBuckets[i] == UNITIALLIZED || rightBuckets[i] == UNITIALLIZED)
+            continue;
+        tableClear(&table);
+        loadChain(left, block, leftBuckets[i], &table);
+        tableBuild(&table);
+        probeChain(join, right, block, rightBuckets[i], &table);
+    }
+
+    tableDestroy(&table);
+    BF_Block_Destroy(&block);
+    free(leftBuckets);
+    free(rightBuckets);
+}
+
+// Returns the grace partition of an id at a level of partitioning. The partitions must not
+// follow the buckets of either file, so the id is mixed first. Level 0 uses the high bits of
+// the mixed id, and every level the next PARTITION_BITS bits below them, so a partition that
+// is split again spreads its records.
+static int partitionOf(int id, int level){
+    return (((uint)id * 2654435761u) >> (MAX_LEVEL - level) * PARTITION_BITS) % JOIN_GRACE_PARTITIONS;
+}
+
+// Creates JOIN_GRACE_PARTITIONS new temporary files.
+static void createPartitions(TMP_file** partitions){
+    for(int p = 0; p < JOIN_GRACE_PARTITIONS; p++)
+        partitions[p] = TMP_Create(sizeof(Record));
+}
+
+// Closes the partitions, so only the two partitions that are joined are open afterwards.
+static void closePartitions(TMP_file** partitions){
+    for(int p = 0; p < JOIN_GRACE_PARTITIONS; p++)
+        TMP_Close(partitions[p]);
+}
+
+// HT_ScanCallback that appends the record to its partition of level 0.
+static int partitionRecord(const Record* record, void* argument){
+    TMP_file** partitions = argument;
+    TMP_Append(partitions[partitionOf(record->id, 0)], record);
+    return 0;
+}
+
+// Writes the records of a hash file into JOIN_GRACE_PARTITIONS new temporary files.
+static void partitionFile(HT_info* info, TMP_file** partitions){
+    createPartitions(partitions);
+    HT_Scan(info, NULL, partitionRecord, partitions);
+    closePartitions(partitions);
+}
+
+// Writes the records of a partition of the level into JOIN_GRACE_PARTITIONS new temporary
+// files of the next level, and destroys it.
+static void splitPartition(TMP_file* partition, int level, TMP_file** partitions){
+    createPartitions(partitions);
+    Record record;
+    for(ulint i = 0; i < partition->numOfEntries; i++){
+        TMP_Get(partition, i, &record);
+        TMP_Append(partitions[partitionOf(record.id, level + 1)], &record);
+    }
+    TMP_Destroy(partition);
+    closePartitions(partitions);
+}
+
+// Joins partition left of the level with partition right of the same level, and destroys both.
+// When the records of left do not fit inside the memory budget of the join, both partitions are
+// split by the next bits of the mixed id and the partitions of the next level are joined one
+// after the other. The records of a partition of MAX_LEVEL share every bit of the mixed id,
+// so they have the same id and are joined even if they do not fit.
+static void joinPartitions(Join* join, RecordTable* table, TMP_file* left, TMP_file* right, int level){
+    if(join->stop || left->numOfEntries == 0 || right->numOfEntries == 0){
+        TMP_Destroy(left);
+        TMP_Destroy(right);
+        return;
+    }
+
+    if(level < MAX_LEVEL && left->numOfEntries * sizeof(Record) > join->memoryBudget){
+        TMP_file* leftPartitions[JOIN_GRACE_PARTITIONS];
+        TMP_file* rightPartitions[JOIN_GRACE_PARTITIONS];
+        splitPartition(left, level, leftPartitions);
+        splitPartition(right, level, rightPartitions);
+        for(int p = 0; p < JOIN_GRACE_PARTITIONS; p++)
+            joinPartitions(join, table, leftPartitions[p], rightPartitions[p], level + 1);
+        return;
+    }
+
+    Record record;
+    tableClear(table);
+    for(ulint i = 0; i < left->numOfEntries; i++){
+        TMP_Get(left, i, &record);
+        tableAdd(table, &record);
+    }
+    tableBuild(table);
+    for(ulint i = 0; i < right->numOfEntries && !join->stop; i++){
+        TMP_Get(right, i, &record);
+        probe(join, table, &record);
+    }
+    TMP_Destroy(left);
+    TMP_Destroy(right);
+}
+
+// Partitions both files by id and joins partition p of left with partition p of right.
+static void graceJoin(Join* join, HT_info* left, HT_info* right){
+    TMP_file* leftPartitions[JOIN_GRACE_PARTITIONS];
+    TMP_file* rightPartitions[JOIN_GRACE_PARTITIONS];
+    partitionFile(left, leftPartitions);
+    partitionFile(right, rightPartitions);
+
+    RecordTable table;
+    tableInit(&table);
+    for(int p = 0; p < JOIN_GRACE_PARTITIONS; p++)
+        joinPartitions(join, &table, leftPartitions[p], rightPartitions[p], 0);
+    tableDestroy(&table);
+}
+
+int JOIN_HashJoin(HT_info* left, HT_info* right, JOIN_Callback callback, void* argument){
+    return JOIN_HashJoinWithBudget(left, right, DEFAULT_MEMORY_BUDGET, callback, argument);
+}
+
+int JOIN_HashJoinWithBudget(HT_info* left, HT_info* right, ulint memoryBudget,
+                            JOIN_Callback callback, void* argument){
+    if(memoryBudget < sizeof(Record))
+        return -1;
+    Join join;
+    join.callback = callback;
+    join.argument = argument;
+    join.numOfPairs = 0;
+    join.stop = false;
+    join.memoryBudget = memoryBudget;
+
+    // Both files hash an id to id % numOfBuckets.
+    if(left->numOfBuckets == right->numOfBuckets)
+        bucketJoin(&join, left, right);
+    else
+        graceJoin(&join, left, right);
+    return join.numOfPairs;
+}
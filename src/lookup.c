@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bf.h"
+#include "ht_table.h"
+#include "record.h"
+#include "scan_kernel.h"
+#include "bf_async.h"
+#include "lookup.h"
+
+#define UNITIALLIZED -1
+#define HT_BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int) + sizeof(int)
+#define HT_BYTES_UNTIL_NEXT BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int)
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+struct Batch;
+
+// The state of a lookup that is in flight: the read of currentBlock was submitted.
+typedef struct {
+    struct Batch* batch;
+    int index;                      // Position of the id inside the ids of the batch.
+    int currentBlock;
+    int blocksRead;
+    BF_Block* block;                // Handle of the read, one for every lookup.
+} Lookup;
+
+// The state of all the lookups, shared by the callbacks of the reads.
+typedef struct Batch {
+    HT_info* info;
+    const int* ids;
+    int numOfIds;
+    int nextId;                     // Position of the next id that starts.
+    int* buckets;                   // The bucket array of the hash file.
+    BF_AsyncQueue* queue;
+    LOOKUP_Callback callback;
+    void* argument;
+    int numOfFound;
+    bool stop;                      // True if callback asked to stop, or a read failed.
+    BF_ErrorCode error;             // The first error of a read, BF_OK if there is none.
+} Batch;
+
+// Copies the bucket array of a hash file. The caller frees it.
+static int* readBuckets(HT_info* info){
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, info->block));
+    int* buckets = malloc(info->numOfBuckets * sizeof(int));
+    memcpy(buckets, BF_Block_GetData(info->block), info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_UnpinBlock(info->block));
+    return buckets;
+}
+
+// Calls the callback of the batch for a lookup that finished.
+static void report(Batch* batch, Lookup* lookup, const Record* record){
+    if(record != NULL)
+        batch->numOfFound++;
+    if(batch->callback(lookup->index, record, lookup->blocksRead, batch->argument))
+        batch->stop = true;
+}
+
+static void onBlock(BF_ErrorCode code, BF_Block* block, int blockId, void* argument);
+
+// Stops the lookups after a read failed. The lookup of the read does not finish,
+// and the first error is returned by LOOKUP_GetAllEntries.
+static void fail(Batch* batch, BF_ErrorCode code){
+    if(batch->error == BF_OK)
+        batch->error = code;
+    batch->stop = true;
+}
+
+// Submits the read of the current block of the lookup.
+static void submit(Batch* batch, Lookup* lookup){
+    BF_ErrorCode code = BF_GetBlockAsync(batch->queue, batch->info->fileDesc, lookup->currentBlock,
+                                         lookup->block, onBlock, lookup);
+    if(code != BF_OK)
+        fail(batch, code);
+}
+
+// Starts the lookup of the next id that did not start. The ids of empty buckets finish
+// at once, so it goes on until a read is submitted or there is no id left.
+static void startNext(Batch* batch, Lookup* lookup){
+    while(!batch->stop && batch->nextId < batch->numOfIds){
+        lookup->index = batch->nextId++;
+        lookup->currentBlock = batch->buckets[batch->ids[lookup->index] % batch->info->numOfBuckets];
+        lookup->blocksRead = 0;
+        if(lookup->currentBlock != UNITIALLIZED){
+            submit(batch, lookup);
+            return;
+        }
+        report(batch, lookup, NULL);
+    }
+}
+
+// BF_AsyncCallback of the read of the current block of a lookup.
+// The lookup finishes if the block holds the id or is the last one of the chain,
+// otherwise it submits the read of the next block. If the read failed the block is not pinned.
+static void onBlock(BF_ErrorCode code, BF_Block* block, int blockId, void* argument){
+    (void)blockId;
+    Lookup* lookup = argument;
+    Batch* batch = lookup->batch;
+    if(code != BF_OK){
+        fail(batch, code);
+        return;
+    }
+    lookup->blocksRead++;
+    if(batch->stop){
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        return;
+    }
+
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = batch->ids[lookup->index];
+    predicate.maxId = predicate.minId;
+    char* data = BF_Block_GetData(block);
+    ulint numOfRecords;
+    memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+    uint passed = filterBlock(data, batch->info->layout, numOfRecords, &predicate);
+    if(passed){
+        Record record;
+        HT_ReadRecord(batch->info->layout, data, __builtin_ctz(passed), &record);
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        report(batch, lookup, &record);
+        startNext(batch, lookup);
+        return;
+    }
+
+    memcpy(&lookup->currentBlock, data + HT_BYTES_UNTIL_NEXT, sizeof(int));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    if(lookup->currentBlock == UNITIALLIZED){
+        report(batch, lookup, NULL);
+        startNext(batch, lookup);
+        return;
+    }
+    submit(batch, lookup);
+}
+
+int LOOKUP_GetAllEntries(HT_info* ht_info, const int* ids, int numOfIds, BF_AsyncQueue* queue,
+                         LOOKUP_Callback callback, void* argument){
+    Batch batch;
+    batch.info = ht_info;
+    batch.ids = ids;
+    batch.numOfIds = numOfIds;
+    batch.nextId = 0;
+    batch.buckets = readBuckets(ht_info);
+    batch.queue = queue;
+    batch.callback = callback;
+    batch.argument = argument;
+    batch.numOfFound = 0;
+    batch.stop = false;
+    batch.error = BF_OK;
+
+    // One lookup for every request the queue keeps in flight, so a lookup never waits
+    // for room inside the queue, and the queue always has a free request when a read completes.
+    // If the queue failed, the first submit of a lookup fails too.
+    while(BF_AsyncInFlight(queue) > 0 && BF_AsyncComplete(queue, 1) >= 0)
+        ;
+    int numOfLookups = BF_AsyncDepth(queue);
+    if(numOfLookups > numOfIds)
+        numOfLookups = numOfIds;
+    Lookup* lookups = malloc(numOfLookups * sizeof(Lookup));
+    for(int l = 0; l < numOfLookups; l++){
+        lookups[l].batch = &batch;
+        BF_Block_Init(&lookups[l].block);
+        startNext(&batch, &lookups[l]);
+    }
+
+    // The callbacks of the reads start the next reads, until every lookup finished.
+    // The requests of a queue that failed never complete, so their lookups are left.
+    while(BF_AsyncInFlight(queue) > 0){
+        if(BF_AsyncComplete(queue, 1) < 0){
+            fail(&batch, BF_ERROR);
+            break;
+        }
+    }
+
+    for(int l = 0; l < numOfLookups; l++)
+        BF_Block_Destroy(&lookups[l].block);
+    free(lookups);
+    free(batch.buckets);
+    if(batch.error != BF_OK){
+        BF_PrintError(batch.error);
+        return -1;
+    }
+    return batch.numOfFound;
+}
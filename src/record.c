@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include "../include/record.h"
 
 const char* names[] = {
@@ -95,5 +96,44 @@ void printRecord(Record record){
 
 }
 
+// Prints only the attributes of the record that belong to the set attributes.
+// With ALL_ATTRIBUTES it prints the same as printRecord.
+void printProjectedRecord(Record record, int attributes){
+    const char* separator = "";
+    printf("(");
+    if(attributes & ATTRIBUTE_BIT(ID)){
+        printf("%s%d", separator, record.id);
+        separator = ",";
+    }
+    if(attributes & ATTRIBUTE_BIT(NAME)){
+        printf("%s%s", separator, record.name);
+        separator = ",";
+    }
+    if(attributes & ATTRIBUTE_BIT(SURNAME)){
+        printf("%s%s", separator, record.surname);
+        separator = ",";
+    }
+    if(attributes & ATTRIBUTE_BIT(CITY))
+        printf("%s%s", separator, record.city);
+    printf(")\n");
+}
 
+// Returns where the attribute starts inside a Record.
+unsigned long attributeOffset(Record_Attribute attribute){
+    switch(attribute){
+        case ID: return offsetof(Record, id);
+        case NAME: return offsetof(Record, name);
+        case SURNAME: return offsetof(Record, surname);
+        default: return offsetof(Record, city);
+    }
+}
 
+// Returns the size of the attribute inside a Record.
+unsigned long attributeSize(Record_Attribute attribute){
+    switch(attribute){
+        case ID: return sizeof(((Record*)0)->id);
+        case NAME: return sizeof(((Record*)0)->name);
+        case SURNAME: return sizeof(((Record*)0)->surname);
+        default: return sizeof(((Record*)0)->city);
+    }
+}
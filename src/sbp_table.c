@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "bf.h"
+#include "ht_table.h"
+#include "sbp_table.h"
+#include "record.h"
+
+#define UNITIALLIZED -1
+#define BLOCK_INFO_OFFSET (BF_BLOCK_SIZE - sizeof(SBP_block_info))
+#define MAX_ENTRIES_PER_LEAF (BLOCK_INFO_OFFSET / sizeof(SBP_Entry))
+// An internal node with n keys has n + 1 children.
+#define MAX_KEYS_PER_NODE ((BLOCK_INFO_OFFSET - sizeof(int)) / (sizeof(SBP_Entry) + sizeof(int)))
+#define HT_BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int) + sizeof(int)
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// An internal node as it is stored at the start of its block.
+// keys[i] is the first entry of the subtree of children[i + 1], so every entry of
+// children[i] is smaller than keys[i] and every entry of children[i + 1] is >= keys[i].
+typedef struct {
+    int children[MAX_KEYS_PER_NODE + 1];
+    SBP_Entry keys[MAX_KEYS_PER_NODE];
+} Node;
+
+// The entries to scan: the ones >= low that are <= high, or that start with prefix.
+typedef struct {
+    SBP_Entry low;                  // The smallest key, with the smallest blockId.
+    char* high;                     // The biggest key, or NULL for a prefix scan.
+    char* prefix;                   // The prefix of the keys, or NULL for a range scan.
+} KeyRange;
+
+// Orders the entries by key, then by blockId.
+static int compareEntries(const SBP_Entry* first, const SBP_Entry* second){
+    int keys = strncmp(first->key, second->key, SBP_MAX_KEY_SIZE);
+    if(keys)
+        return keys;
+    return (first->blockId > second->blockId) - (first->blockId < second->blockId);
+}
+
+// Makes the entry of a key. The key is zero padded, so equal keys have equal bytes.
+static void makeEntry(SBP_info* info, const char* key, int blockId, SBP_Entry* entry){
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->key, key, info->keySize);
+    entry->blockId = blockId;
+}
+
+// Allocates a new, empty leaf or internal node and returns its ID.
+static int allocateNode(SBP_info* info, bool isLeaf){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    // Allocate a new block, it is the last block of the file.
+    CALL_OR_DIE(BF_AllocateBlock(info->fileDesc, block));
+    int blocksNum;
+    CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, &blocksNum));
+
+    SBP_block_info blockInfo;
+    blockInfo.blockIndex = blocksNum - 1;
+    blockInfo.next = UNITIALLIZED;
+    blockInfo.isLeaf = isLeaf;
+    blockInfo.numOfEntries = 0;
+    memcpy(BF_Block_GetData(block) + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+    return blockInfo.blockIndex;
+}
+
+// Stores the SBP_info into the first block of the file.
+static void writeSBP_info(SBP_info* info){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 0, block));
+    memcpy(BF_Block_GetData(block), info, sizeof(*info));
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+}
+
+// Writes the entries or the node, numOfEntries and the next leaf into the block blockId.
+static void writeNode(SBP_info* info, int blockId, const void* entries, ulint size, ulint numOfEntries, int next){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    memcpy(data, entries, size);
+
+    SBP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+    blockInfo.numOfEntries = numOfEntries;
+    blockInfo.next = next;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+}
+
+// Returns the child of an internal node with numOfKeys keys where entry belongs,
+// the number of keys that are <= entry.
+static int childIndex(const Node* node, int numOfKeys, const SBP_Entry* entry){
+    int low = 0;
+    int high = numOfKeys;
+    while(low < high){
+        int middle = (low + high) / 2;
+        if(compareEntries(&node->keys[middle], entry) <= 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// Inserts the entry into the leaf blockId. If the leaf is full it is split and
+// *newBlock gets the new leaf after it, and *separator its first entry.
+// Returns 1 if the entry was inserted and 0 if the leaf already had it.
+static int insertIntoLeaf(SBP_info* info, int blockId, const SBP_Entry* entry, SBP_Entry* separator, int* newBlock){
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    SBP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+
+    *newBlock = UNITIALLIZED;
+    SBP_Entry entries[MAX_ENTRIES_PER_LEAF + 1];
+    int numOfEntries = blockInfo.numOfEntries;
+    memcpy(entries, data, numOfEntries * sizeof(SBP_Entry));
+    int position = numOfEntries;
+    while(position > 0 && compareEntries(&entries[position - 1], entry) > 0)
+        position--;
+    // The HT returns the same blockId for consecutive inserts until the block fills up.
+    if(position > 0 && compareEntries(&entries[position - 1], entry) == 0){
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        BF_Block_Destroy(&block);
+        return 0;
+    }
+    memmove(entries + position + 1, entries + position, (numOfEntries - position) * sizeof(SBP_Entry));
+    entries[position] = *entry;
+    numOfEntries++;
+
+    if(numOfEntries <= MAX_ENTRIES_PER_LEAF){
+        memcpy(data, entries, numOfEntries * sizeof(SBP_Entry));
+        blockInfo.numOfEntries = numOfEntries;
+        memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+        BF_Block_SetDirty(block);
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        BF_Block_Destroy(&block);
+        return 1;
+    }
+
+    // Split the leaf in half. The last leaf stays full when the new entry is the biggest one.
+    int leftEntries = numOfEntries / 2;
+    if(position == numOfEntries - 1 && blockInfo.next == UNITIALLIZED)
+        leftEntries = numOfEntries - 1;
+
+    *newBlock = allocateNode(info, true);
+    *separator = entries[leftEntries];
+    writeNode(info, *newBlock, entries + leftEntries, (numOfEntries - leftEntries) * sizeof(SBP_Entry),
+              numOfEntries - leftEntries, blockInfo.next);
+
+    memcpy(data, entries, leftEntries * sizeof(SBP_Entry));
+    blockInfo.numOfEntries = leftEntries;
+    blockInfo.next = *newBlock;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+    return 1;
+}
+
+// Inserts the entry into the subtree of blockId, which is level levels above the leaves.
+// If the root of the subtree is split, *newBlock gets the new node after it and
+// *separator the first entry under the new node. Otherwise *newBlock is UNITIALLIZED.
+// Returns 1 if the entry was inserted and 0 if the index already had it.
+static int insertIntoSubtree(SBP_info* info, int blockId, int level, const SBP_Entry* entry, SBP_Entry* separator, int* newBlock){
+    if(level == 0)
+        return insertIntoLeaf(info, blockId, entry, separator, newBlock);
+
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, blockId, block));
+    char* data = BF_Block_GetData(block);
+    SBP_block_info blockInfo;
+    memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+    Node node;
+    memcpy(&node, data, sizeof(node));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    int numOfKeys = blockInfo.numOfEntries;
+    int child = childIndex(&node, numOfKeys, entry);
+    SBP_Entry childSeparator;
+    int childBlock;
+    int inserted = insertIntoSubtree(info, node.children[child], level - 1, entry, &childSeparator, &childBlock);
+
+    *newBlock = UNITIALLIZED;
+    if(childBlock == UNITIALLIZED)
+        return inserted;
+
+    // The child was split, its new sibling goes right after it.
+    SBP_Entry keys[MAX_KEYS_PER_NODE + 1];
+    int children[MAX_KEYS_PER_NODE + 2];
+    memcpy(keys, node.keys, child * sizeof(SBP_Entry));
+    keys[child] = childSeparator;
+    memcpy(keys + child + 1, node.keys + child, (numOfKeys - child) * sizeof(SBP_Entry));
+    memcpy(children, node.children, (child + 1) * sizeof(int));
+    children[child + 1] = childBlock;
+    memcpy(children + child + 2, node.children + child + 1, (numOfKeys - child) * sizeof(int));
+    numOfKeys++;
+
+    if(numOfKeys <= MAX_KEYS_PER_NODE){
+        memcpy(node.keys, keys, numOfKeys * sizeof(SBP_Entry));
+        memcpy(node.children, children, (numOfKeys + 1) * sizeof(int));
+        writeNode(info, blockId, &node, sizeof(node), numOfKeys, UNITIALLIZED);
+        return inserted;
+    }
+
+    // Split the node, its middle key moves up to the parent.
+    int middle = numOfKeys / 2;
+    Node right;
+    memcpy(right.keys, keys + middle + 1, (numOfKeys - middle - 1) * sizeof(SBP_Entry));
+    memcpy(right.children, children + middle + 1, (numOfKeys - middle) * sizeof(int));
+    memcpy(node.keys, keys, middle * sizeof(SBP_Entry));
+    memcpy(node.children, children, (middle + 1) * sizeof(int));
+    *newBlock = allocateNode(info, false);
+    *separator = keys[middle];
+    writeNode(info, *newBlock, &right, sizeof(right), numOfKeys - middle - 1, UNITIALLIZED);
+    writeNode(info, blockId, &node, sizeof(node), middle, UNITIALLIZED);
+    return inserted;
+}
+
+// Checks if the entry is after the end of the range.
+static bool pastRange(const KeyRange* range, const SBP_Entry* entry){
+    if(range->prefix != NULL)
+        return strncmp(entry->key, range->prefix, strlen(range->prefix)) != 0;
+    return strncmp(entry->key, range->high, SBP_MAX_KEY_SIZE) > 0;
+}
+
+// Walks from the root to the first entry of the range and then through the leaves
+// until the first entry after it. The entries of the range are returned in order
+// inside a malloced array in *entries, which the caller must free.
+// Returns the number of entries, *blocksRead gets the number of SBP blocks that were read.
+static int scanRange(SBP_info* info, const KeyRange* range, SBP_Entry** entries, int* blocksRead){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    *blocksRead = 0;
+    int currentBlock = info->root;
+    for(int level = info->height - 1; level > 0; level--){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        SBP_block_info blockInfo;
+        memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+        Node node;
+        memcpy(&node, data, sizeof(node));
+        currentBlock = node.children[childIndex(&node, blockInfo.numOfEntries, &range->low)];
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        (*blocksRead)++;
+    }
+
+    *entries = NULL;
+    int numOfEntries = 0;
+    int capacity = 0;
+    bool done = false;
+    while(currentBlock != UNITIALLIZED && !done){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        SBP_block_info blockInfo;
+        memcpy(&blockInfo, data + BLOCK_INFO_OFFSET, sizeof(blockInfo));
+        (*blocksRead)++;
+
+        SBP_Entry entry;
+        for(int i = 0; i < blockInfo.numOfEntries; i++){
+            memcpy(&entry, data + i * sizeof(SBP_Entry), sizeof(entry));
+            if(compareEntries(&entry, &range->low) < 0)
+                continue;
+            if(pastRange(range, &entry)){
+                done = true;
+                break;
+            }
+            if(numOfEntries == capacity){
+                capacity = capacity ? 2 * capacity : 16;
+                *entries = realloc(*entries, capacity * sizeof(SBP_Entry));
+            }
+            (*entries)[numOfEntries++] = entry;
+        }
+
+        currentBlock = blockInfo.next;
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+
+    BF_Block_Destroy(&block);
+    return numOfEntries;
+}
+
+// Prints the records of the primary file for the entries, key after key.
+// Every HT block of a key is read once and all of its records with the key are printed.
+// Returns the number of records that were printed.
+static int printEntries(HT_info* ht_info, SBP_info* info, const SBP_Entry* entries, int numOfEntries){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int recordsPrinted = 0;
+    for(int i = 0; i < numOfEntries; i++){
+        CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, entries[i].blockId, block));
+        char* data = BF_Block_GetData(block);
+        ulint numOfRecords;
+        memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        Record record;
+        for(int r = 0; r < numOfRecords; r++){
+            HT_ReadRecord(ht_info->layout, data, r, &record);
+            char* key = (char*)&record + attributeOffset(info->keyAttribute);
+            if(!strncmp(key, entries[i].key, info->keySize)){
+                printRecord(record);
+                recordsPrinted++;
+            }
+        }
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+
+    BF_Block_Destroy(&block);
+    return recordsPrinted;
+}
+
+// Scans the range and prints its records.
+// Returns the number of SBP blocks that were read, or -1 if no record was printed.
+static int getEntries(HT_info* ht_info, SBP_info* info, const KeyRange* range){
+    SBP_Entry* entries;
+    int blocksRead;
+    int numOfEntries = scanRange(info, range, &entries, &blocksRead);
+    int recordsPrinted = printEntries(ht_info, info, entries, numOfEntries);
+    free(entries);
+
+    if(recordsPrinted > 0)
+        return blocksRead;
+    return -1;
+}
+
+// Makes the KeyRange low <= key <= high.
+static void makeRange(SBP_info* info, char* low, char* high, KeyRange* range){
+    makeEntry(info, low, INT_MIN, &range->low);
+    range->high = high;
+    range->prefix = NULL;
+}
+
+static int compareBlockIds(const void* a, const void* b){
+    int first = *(const int*)a;
+    int second = *(const int*)b;
+    return (first > second) - (first < second);
+}
+
+int SBP_CreateSecondaryIndex(char *sfileName, char* fileName, Record_Attribute keyAttribute){
+    // The primary file is not read, the entries are inserted by SBP_SecondaryInsertEntry.
+    (void)fileName;
+    // The index orders strings.
+    if(keyAttribute != NAME && keyAttribute != SURNAME && keyAttribute != CITY)
+        return -1;
+
+    BF_Block* block;
+
+    BF_Block_Init(&block); // Initiallize the struct BF_Block.
+    CALL_OR_DIE(BF_CreateFile(sfileName)); // Create a file which consists of blocks.
+
+    int fileDescriptor; // The file descriptor of the file we are going to open.
+    CALL_OR_DIE(BF_OpenFile(sfileName, &fileDescriptor)); // Open the file
+
+    CALL_OR_DIE(BF_AllocateBlock(fileDescriptor, block));
+    char* data = BF_Block_GetData(block);
+
+    // The root is the empty leaf of block 1.
+    SBP_info info;
+    memset(&info, 0, sizeof(info));
+    info.isSecondaryBPlusTree = true;
+    info.fileDesc = fileDescriptor;
+    info.root = 1;
+    info.height = 1;
+    info.firstLeaf = 1;
+    info.keyAttribute = keyAttribute;
+    info.keySize = attributeSize(keyAttribute);
+    memcpy(data, &info, sizeof(info));
+
+    SBP_block_info blockInfo;
+    blockInfo.blockIndex = 0;
+    blockInfo.next = UNITIALLIZED;
+    blockInfo.isLeaf = false;
+    blockInfo.numOfEntries = 0;
+    memcpy(data + BLOCK_INFO_OFFSET, &blockInfo, sizeof(blockInfo));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    allocateNode(&info, true);
+
+    CALL_OR_DIE(BF_CloseFile(fileDescriptor));
+    return 0;
+}
+
+SBP_info* SBP_OpenSecondaryIndex(char *indexName){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int fileDescriptor;
+    CALL_OR_DIE(BF_OpenFile(indexName, &fileDescriptor));
+    CALL_OR_DIE(BF_GetBlock(fileDescriptor, 0, block));
+
+    SBP_info* info = malloc(sizeof(*info));
+    memcpy(info, BF_Block_GetData(block), sizeof(*info));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    // Check if the file is a SBP file
+    if(!info->isSecondaryBPlusTree){
+        free(info);
+        CALL_OR_DIE(BF_CloseFile(fileDescriptor));
+        return NULL;
+    }
+
+    // We allocate the fileName here so we can free the pointer.
+    info->fileName = malloc(strlen(indexName) + 1);
+    strcpy(info->fileName, indexName);
+    // The fileDesc stored inside the file is the one it had when it was created.
+    info->fileDesc = fileDescriptor;
+    return info;
+}
+
+int SBP_CloseSecondaryIndex(SBP_info* info){
+    CALL_OR_DIE(BF_CloseFile(info->fileDesc));
+
+    // memory managment
+    free(info->fileName);
+    free(info);
+    return 0;
+}
+
+int SBP_SecondaryInsertEntry(SBP_info* info, Record record, int block_id){
+    SBP_Entry entry;
+    makeEntry(info, (char*)&record + attributeOffset(info->keyAttribute), block_id, &entry);
+
+    SBP_Entry separator;
+    int newBlock;
+    insertIntoSubtree(info, info->root, info->height - 1, &entry, &separator, &newBlock);
+    if(newBlock == UNITIALLIZED)
+        return 0;
+
+    // The root was split, the tree grows by one level.
+    Node root;
+    root.children[0] = info->root;
+    root.children[1] = newBlock;
+    root.keys[0] = separator;
+    int rootBlock = allocateNode(info, false);
+    writeNode(info, rootBlock, &root, sizeof(root), 1, UNITIALLIZED);
+    info->root = rootBlock;
+    info->height++;
+    writeSBP_info(info);
+    return 0;
+}
+
+int SBP_SecondaryGetAllEntries(HT_info* ht_info, SBP_info* info, char* value){
+    KeyRange range;
+    makeRange(info, value, value, &range);
+    return getEntries(ht_info, info, &range);
+}
+
+int SBP_SecondaryGetRangeEntries(HT_info* ht_info, SBP_info* info, char* low, char* high){
+    KeyRange range;
+    makeRange(info, low, high, &range);
+    return getEntries(ht_info, info, &range);
+}
+
+int SBP_SecondaryGetPrefixEntries(HT_info* ht_info, SBP_info* info, char* prefix){
+    // Every key with the prefix is >= the prefix itself.
+    KeyRange range;
+    makeEntry(info, prefix, INT_MIN, &range.low);
+    range.high = NULL;
+    range.prefix = prefix;
+    return getEntries(ht_info, info, &range);
+}
+
+int SBP_SecondaryGetBlockIds(SBP_info* info, char* low, char* high, int** blockIds){
+    KeyRange range;
+    makeRange(info, low, high, &range);
+    SBP_Entry* entries;
+    int blocksRead;
+    int numOfEntries = scanRange(info, &range, &entries, &blocksRead);
+
+    // The entries are sorted by key, a block can hold more than one key of the range.
+    *blockIds = malloc((numOfEntries > 0 ? numOfEntries : 1) * sizeof(int));
+    for(int i = 0; i < numOfEntries; i++)
+        (*blockIds)[i] = entries[i].blockId;
+    qsort(*blockIds, numOfEntries, sizeof(int), compareBlockIds);
+    int numOfBlockIds = 0;
+    for(int i = 0; i < numOfEntries; i++)
+        if(numOfBlockIds == 0 || (*blockIds)[numOfBlockIds - 1] != (*blockIds)[i])
+            (*blockIds)[numOfBlockIds++] = (*blockIds)[i];
+
+    free(entries);
+    return numOfBlockIds;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_KERNELS
+#endif
+
+#include "../include/record.h"
+#include "../include/ht_table.h"
+#include "../include/scan_kernel.h"
+
+// Where the attributes of the records of a block are: the attribute of the
+// record r starts at offset[attribute] + r * stride[attribute].
+typedef struct {
+    int offset[4];
+    int stride[4];
+} Columns;
+
+// The bytes of a string field of the predicate, ready for the 16 byte compares.
+// A field of up to 32 bytes is covered by two overlapping chunks, the first
+// 16 bytes and the last 16 bytes of the field.
+typedef struct {
+    int offset;                     // Offset of the field of the first record inside the block.
+    int stride;                     // Bytes from the field of a record to the field of the next one.
+    int secondChunk;                // Offset of the second chunk inside the field.
+    unsigned char bytes[32];        // The value, zero padded.
+    uint firstMask;                 // The bytes of the first chunk that are compared.
+    uint secondMask;                // The bytes of the second chunk that are compared.
+} FieldPattern;
+
+// The columns of every layout and the kernel of filterBlock, set once by initKernels.
+static Columns layoutColumns[HT_PAX + 1];
+static uint (*kernel)(const char*, HT_Layout, int, const HT_Predicate*) = NULL;
+static const char* kernelName = "scalar";
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+static void initKernels(void);
+
+// Finds where the attributes are inside a block with the given layout.
+static void findColumns(HT_Layout layout, Columns* columns){
+    for(int attribute = ID; attribute <= CITY; attribute++){
+        columns->offset[attribute] = HT_FieldOffset(layout, attribute, 0);
+        columns->stride[attribute] = HT_FieldOffset(layout, attribute, 1) - columns->offset[attribute];
+    }
+}
+
+// Checks if the string attribute of the record r is equal to value, like strncmp does.
+static bool stringPasses(const char* data, const Columns* columns, Record_Attribute attribute, int r, const char* value){
+    const char* field = data + columns->offset[attribute] + r * columns->stride[attribute];
+    return !strncmp(field, value, attributeSize(attribute));
+}
+
+// Checks if the record r passes the predicate.
+static bool recordPasses(const char* data, const Columns* columns, int r, const HT_Predicate* predicate){
+    int id;
+    memcpy(&id, data + columns->offset[ID] + r * columns->stride[ID], sizeof(int));
+    if(id < predicate->minId || id > predicate->maxId)
+        return false;
+    if(predicate->name != NULL && !stringPasses(data, columns, NAME, r, predicate->name))
+        return false;
+    if(predicate->surname != NULL && !stringPasses(data, columns, SURNAME, r, predicate->surname))
+        return false;
+    if(predicate->city != NULL && !stringPasses(data, columns, CITY, r, predicate->city))
+        return false;
+    return true;
+}
+
+uint filterBlockScalar(const char* data, HT_Layout layout, int numOfRecords, const HT_Predicate* predicate){
+    pthread_once(&kernelsOnce, initKernels);
+    const Columns* columns = &layoutColumns[layout];
+    uint passed = 0;
+    for(int r = 0; r < numOfRecords; r++)
+        if(recordPasses(data, columns, r, predicate))
+            passed |= 1u << r;
+    return passed;
+}
+
+uint filterRecordsScalar(const Record* records, int numOfRecords, const HT_Predicate* predicate){
+    return filterBlockScalar((const char*)records, HT_ROW, numOfRecords, predicate);
+}
+
+#ifdef HAS_X86_KERNELS
+
+// Prepares the pattern of a string attribute. Like strncmp, the bytes up to and
+// including the '\0' of the value are compared, but never more than the field.
+static void makePattern(const char* value, const Columns* columns, Record_Attribute attribute, FieldPattern* pattern){
+    int size = attributeSize(attribute);
+    int length = strlen(value) + 1;
+    if(length > size)
+        length = size;
+    pattern->offset = columns->offset[attribute];
+    pattern->stride = columns->stride[attribute];
+    pattern->secondChunk = size > 16 ? size - 16 : 0;
+    memset(pattern->bytes, 0, sizeof(pattern->bytes));
+    memcpy(pattern->bytes, value, length);
+
+    pattern->firstMask = 0;
+    pattern->secondMask = 0;
+    for(int i = 0; i < length; i++){
+        if(i < 16)
+            pattern->firstMask |= 1u << i;
+        else
+            pattern->secondMask |= 1u << (i - pattern->secondChunk);
+    }
+}
+
+// Compares the string field of the record r with the pattern, 16 bytes at a time.
+// A 15 byte name reads the first byte of the next field too, which the mask ignores.
+// With both layouts the next field is still inside the block.
+__attribute__((target("avx2")))
+static bool fieldMatches(const char* data, int r, const FieldPattern* pattern){
+    const char* field = data + pattern->offset + r * pattern->stride;
+    __m128i chunk = _mm_loadu_si128((const __m128i*)field);
+    __m128i value = _mm_loadu_si128((const __m128i*)pattern->bytes);
+    uint equal = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, value));
+    if((equal & pattern->firstMask) != pattern->firstMask)
+        return false;
+    if(pattern->secondMask == 0)
+        return true;
+    chunk = _mm_loadu_si128((const __m128i*)(field + pattern->secondChunk));
+    value = _mm_loadu_si128((const __m128i*)(pattern->bytes + pattern->secondChunk));
+    equal = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, value));
+    return (equal & pattern->secondMask) == pattern->secondMask;
+}
+
+// Compares the ids of 8 records at once with the bounds, then compares the
+// string fields of the records that are still inside. Contiguous ids (HT_PAX)
+// are loaded directly, the ids of the HT_ROW layout are gathered.
+__attribute__((target("avx2")))
+static uint filterBlockAVX2(const char* data, HT_Layout layout, int numOfRecords, const HT_Predicate* predicate){
+    const Columns* columns = &layoutColumns[layout];
+    FieldPattern patterns[3];
+    int numOfPatterns = 0;
+    if(predicate->name != NULL)
+        makePattern(predicate->name, columns, NAME, &patterns[numOfPatterns++]);
+    if(predicate->surname != NULL)
+        makePattern(predicate->surname, columns, SURNAME, &patterns[numOfPatterns++]);
+    if(predicate->city != NULL)
+        makePattern(predicate->city, columns, CITY, &patterns[numOfPatterns++]);
+
+    const __m256i minId = _mm256_set1_epi32(predicate->minId);
+    const __m256i maxId = _mm256_set1_epi32(predicate->maxId);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i offsets = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(columns->stride[ID]));
+    const bool contiguous = columns->stride[ID] == sizeof(int);
+
+    uint passed = 0;
+    for(int first = 0; first < numOfRecords; first += 8){
+        // Only the lanes of existing records are read.
+        __m256i used = _mm256_cmpgt_epi32(_mm256_set1_epi32(numOfRecords - first), lanes);
+        const int* ids = (const int*)(data + columns->offset[ID] + first * columns->stride[ID]);
+        __m256i id;
+        if(contiguous)
+            id = _mm256_maskload_epi32(ids, used);
+        else
+            id = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), ids, offsets, used, 1);
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(minId, id), _mm256_cmpgt_epi32(id, maxId));
+        __m256i inside = _mm256_andnot_si256(outside, used);
+        passed |= (uint)_mm256_movemask_ps(_mm256_castsi256_ps(inside)) << first;
+    }
+
+    for(int p = 0; p < numOfPatterns; p++){
+        uint candidates = passed;
+        while(candidates){
+            int r = __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+            if(!fieldMatches(data, r, &patterns[p]))
+                passed &= ~(1u << r);
+        }
+    }
+    return passed;
+}
+
+#endif // HAS_X86_KERNELS
+
+// Finds the columns of every layout and chooses the kernel of filterBlock from the instructions of the CPU.
+// It runs once, even when the first scans run on many threads.
+static void initKernels(void){
+    for(int layout = HT_ROW; layout <= HT_PAX; layout++)
+        findColumns(layout, &layoutColumns[layout]);
+    kernel = filterBlockScalar;
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        kernel = filterBlockAVX2;
+        kernelName = "avx2";
+    }
+#endif
+}
+
+uint filterBlock(const char* data, HT_Layout layout, int numOfRecords, const HT_Predicate* predicate){
+    pthread_once(&kernelsOnce, initKernels);
+    return kernel(data, layout, numOfRecords, predicate);
+}
+
+uint filterRecords(const Record* records, int numOfRecords, const HT_Predicate* predicate){
+    return filterBlock((const char*)records, HT_ROW, numOfRecords, predicate);
+}
+
+const char* filterKernelName(void){
+    pthread_once(&kernelsOnce, initKernels);
+    return kernelName;
+}
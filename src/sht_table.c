@@ -2,17 +2,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stddef.h>
 
 #include "../include/bf.h"
+#include "../include/bf_ext.h"
 #include "../include/ht_table.h"
 #include "../include/sht_table.h"
 #include "../include/record.h"
+#include "../include/temp_file.h"
 
 #define UNITIALLIZED -1
 #define MAX_RECORDS_PER_BLOCK (BF_BLOCK_SIZE - sizeof(HT_block_info)) / (sizeof(Record))
-#define MAX_SHT_RECORDS_PER_BLOCK (BF_BLOCK_SIZE - sizeof(SHT_block_info)) / (sizeof(SHT_Record))
+#define MAX_SHT_ENTRY_SIZE (SHT_MAX_KEY_SIZE + 2 * sizeof(int) + sizeof(Record))
 #define BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(SHT_block_info) + sizeof(int) + sizeof(int)
 #define BYTES_UNTIL_NEXT BF_BLOCK_SIZE - sizeof(SHT_block_info) + sizeof(int)
+#define MAX_POSTING_BYTES (BF_BLOCK_SIZE - sizeof(SHT_block_info) - sizeof(SHT_postings_info))
+#define MAX_POSTINGS_PER_BLOCK MAX_POSTING_BYTES
+#define MAX_VARINT_BYTES 5
+#define DEFAULT_BUILD_MEMORY_BUDGET (1 << 20)
+#define MIN_BUILD_CAPACITY 64
+#define HT_BYTES_UNTIL_NUM_OF_RECORDS BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int) + sizeof(int)
+#define HT_BYTES_UNTIL_NEXT BF_BLOCK_SIZE - sizeof(HT_block_info) + sizeof(int)
 #define CALL_OR_DIE(call)     \
   {                           \
     BF_ErrorCode code = call; \
@@ -22,16 +32,143 @@
     }                         \
   }
 
+// A key of the index together with its hash, ready to be compared with the entries.
+typedef struct {
+    char key[SHT_MAX_KEY_SIZE];     // The key attributes, as makeKey writes them.
+    uint hash;                      // hashKey(key).
+} SearchKey;
+
+// Returns the bytes of the key slot at the start of every entry and SHT_Key.
+// It is the size of the key attributes rounded up to a multiple of an int, so
+// for names an entry has the layout of SHT_Record and a SHT_Key the layout of SHT_Key.
+static ulint keySlotSize(SHT_info* info){
+    return (info->keySize + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+// Returns the bytes of a SHT_Key of a SHT_POSTINGS file:
+// the key slot, the first postings block, the hash and the number of postings.
+static ulint keyEntrySize(SHT_info* info){
+    return keySlotSize(info) + 3 * sizeof(int);
+}
+
+// Returns the ATTRIBUTE_BITs of the key attributes.
+static int keyColumns(SHT_info* info){
+    int columns = 0;
+    for(int i = 0; i < info->numOfKeyAttributes; i++)
+        columns |= ATTRIBUTE_BIT(info->keyAttributes[i]);
+    return columns;
+}
+
+// Writes into key the key attributes of the record, one after the other in
+// the order of keyAttributes. Strings are copied until their '\0' and the rest
+// of their place is zeroed, so two keys are equal exactly when their bytes are equal.
+static void makeKey(SHT_info* info, const Record* record, char* key){
+    memset(key, 0, SHT_MAX_KEY_SIZE);
+    for(int i = 0; i < info->numOfKeyAttributes; i++){
+        Record_Attribute attribute = info->keyAttributes[i];
+        const char* value = (const char*)record + attributeOffset(attribute);
+        if(attribute == ID)
+            memcpy(key, value, sizeof(int));
+        else
+            strncpy(key, value, attributeSize(attribute));
+        key += attributeSize(attribute);
+    }
+}
+
+// Writes into key the key of a lookup value. value is a string for name, surname
+// and city, a pointer to an int for id, and a pointer to a Record that holds the
+// key attributes for a composite key.
+static void makeKeyFromValue(SHT_info* info, const void* value, char* key){
+    if(info->numOfKeyAttributes > 1){
+        makeKey(info, value, key);
+        return;
+    }
+    Record record;
+    memset(&record, 0, sizeof(record));
+    Record_Attribute attribute = info->keyAttributes[0];
+    if(attribute == ID)
+        memcpy(&record.id, value, sizeof(int));
+    else
+        strncpy((char*)&record + attributeOffset(attribute), value, attributeSize(attribute));
+    makeKey(info, &record, key);
+}
+
+// djb2 over one string attribute of a key, like hash_string,
+// but it stops at the end of the attribute too.
+static uint hashString(const char* value, ulint size){
+    uint hash = 5381;
+    for(int i = 0; i < size && value[i] != '\0'; i++)
+        hash = (hash << 5) + hash + value[i];
+    return hash;
+}
+
+// Hashes a key made by makeKey. For a single string attribute it is the same as
+// hash_string, a single id is its own hash like inside the HT. The hashes of the
+// attributes of a composite key are combined the way djb2 combines characters.
+static uint hashKey(SHT_info* info, const char* key){
+    uint hash = 5381;
+    for(int i = 0; i < info->numOfKeyAttributes; i++){
+        Record_Attribute attribute = info->keyAttributes[i];
+        uint attributeHash;
+        if(attribute == ID)
+            memcpy(&attributeHash, key, sizeof(int));
+        else
+            attributeHash = hashString(key, attributeSize(attribute));
+        if(info->numOfKeyAttributes == 1)
+            return attributeHash;
+        hash = (hash << 5) + hash + attributeHash;
+        key += attributeSize(attribute);
+    }
+    return hash;
+}
+
+// Makes the SearchKey of a lookup value.
+static void makeSearchKey(SHT_info* info, const void* value, SearchKey* search){
+    makeKeyFromValue(info, value, search->key);
+    search->hash = hashKey(info, search->key);
+}
+
+// Checks if the key slot of an entry, or of a SHT_Key, holds the key we search.
+// The hash after the key slot is compared first.
+static bool keyMatches(SHT_info* info, const char* entry, const SearchKey* search){
+    uint hash;
+    memcpy(&hash, entry + keySlotSize(info) + sizeof(int), sizeof(uint));
+    return hash == search->hash && !memcmp(entry, search->key, info->keySize);
+}
+
 // Mallocs and initiallizes a struct SHT_info
 // Initiallizes all the fields exept fileName so we are
 // able to free the memory.
-SHT_info* createSHT_info(int fileDescriptor, int numOfBuckets){
+SHT_info* createSHT_info(int fileDescriptor, int numOfBuckets, SHT_options options){
     // Allocate the struct SHT_info
     SHT_info* info = malloc(sizeof(*info)); 
     // Initiallize it
     info->isSecondaryHashTable = true;
     info->fileDesc = fileDescriptor;
     info->numOfBuckets = numOfBuckets;
+    info->format = options.format;
+    info->numOfKeyAttributes = options.numOfKeyAttributes;
+    info->keySize = 0;
+    for(int i = 0; i < options.numOfKeyAttributes; i++){
+        info->keyAttributes[i] = options.keyAttributes[i];
+        info->keySize += attributeSize(options.keyAttributes[i]);
+    }
+    // The key attributes are always inside the entry.
+    info->includedColumns = options.includedColumns & ~keyColumns(info);
+    // The key slot, the blockId and the hash, then the included columns.
+    info->entrySize = keySlotSize(info) + 2 * sizeof(int);
+    for(Record_Attribute attribute = ID; attribute <= CITY; attribute++)
+        if(info->includedColumns & ATTRIBUTE_BIT(attribute))
+            info->entrySize += attributeSize(attribute);
+    // Made by SHT_OpenSecondaryIndex.
+    info->block = NULL;
+    info->postingsBlock = NULL;
+    info->newBlock = NULL;
+    info->blockIds = NULL;
+    info->capacityOfBlockIds = 0;
+    for(int b = 0; b < SHT_FETCH_BATCH; b++)
+        info->fetchBlocks[b] = NULL;
+    info->readOnly = false;             // Set by SHT_OpenSecondaryIndexReadOnly.
 
     return info;
 }
@@ -49,47 +186,22 @@ SHT_block_info* createSHT_block_info(int index, int next){
 }
 
 // Allocated a new block and returns its ID.
+// The block stays pinned inside the handle info->newBlock, so the caller can fill it
+// without getting it again, and must unpin it. info->block and info->postingsBlock
+// can stay pinned meanwhile.
 static int createBlock(SHT_info* info){
-    BF_Block* block;
-	BF_Block_Init(&block);
-		
-    // Allocate a new block
-	CALL_OR_DIE(BF_AllocateBlock(info->fileDesc, block));
-
-    // Malloc a pointer where we will write the total blocks number
-    int *blocksNum = malloc(sizeof(int)); 
-
-    // Get the total numbers of the blocks
-	CALL_OR_DIE(BF_GetBlockCounter(info->fileDesc, blocksNum));
+    // Allocate a new block, pinned once
+    int index;
+	CALL_OR_DIE(BF_AllocateBlockId(info->fileDesc, info->newBlock, &index));
 
-    // Get the index of the last block we just allocated
-	int index = *blocksNum - 1;
-    // Get the block with this specific index
-	CALL_OR_DIE(BF_GetBlock(info->fileDesc, index, block));
-
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Allocate the SHT_block_info struct and initiallize it.
-    SHT_block_info* blockInfo = createSHT_block_info(index, -1);
+    // The SHT_block_info of an empty block without a next block.
+    SHT_block_info blockInfo = { index, UNITIALLIZED, 0 };
 
     // Move to the end of the block to store the struct BlockInfo
-    data += BF_BLOCK_SIZE - sizeof(*blockInfo);
-
-	memcpy(data, blockInfo, sizeof(*blockInfo));
-
-	BF_Block_SetDirty(block);
-    CALL_OR_DIE(BF_UnpinBlock(block));
-	BF_Block_Destroy(&block);
+	char *data = BF_Block_GetData(info->newBlock) + BF_BLOCK_SIZE - sizeof(blockInfo);
+	memcpy(data, &blockInfo, sizeof(blockInfo));
 
-    // Store the blockId so we can return it
-	int blockId = blockInfo->blockIndex;
-
-    // Memory managment
-	free(blockInfo);
-	free(blocksNum);
-
-    return blockId;
+    return index;
 }
 
 // Creates the buckets of the hashTable
@@ -125,34 +237,37 @@ static void createBuckets(SHT_info* info){
     BF_Block_Destroy(&block);
 }
 
-// Check if a specific bucket is unitiallized.
-// If it is allocate a new block and let bucket point to that block.
-// If it is NOT just return and do nothing.
-static void checkBucket(SHT_info* info, int* buckets, int hashedId){
-    // If the bucket is initiallized return
-    if(buckets[hashedId] != UNITIALLIZED)
-        return;
-
-    BF_Block* block;
-    BF_Block_Init(&block); // Initiallize the struct BF_Block.
-    // If it isn't:
-    // Add the new block inside the bucket at the position of the hashed id.
-    buckets[hashedId] = createBlock(info);
+// Returns the first block of the bucket hashedId.
+// Only this bucket is read from the block of the buckets, not the whole array.
+static int readBucket(SHT_info* info, int hashedId){
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(info->fileDesc, 1, info->block, &data));
+    int bucket;
+    memcpy(&bucket, data + hashedId * sizeof(int), sizeof(int));
+    CALL_OR_DIE(BF_ReleaseBlock(info->fileDesc, info->block));
+    return bucket;
+}
 
+// Returns the first block of the bucket hashedId.
+// If the bucket is unitiallized allocate a new block and let bucket point to that block.
+static int checkBucket(SHT_info* info, int hashedId){
     // Get the block that holds all the buckets
-    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, block));
-    // Get the data of this block
-	char* data = BF_Block_GetData(block);
+    CALL_OR_DIE(BF_GetBlock(info->fileDesc, 1, info->block));
     // Go to the right data's position
-    data += hashedId * sizeof(int); 
-    // Store the block into the bucket position
-    memcpy(data, &buckets[hashedId], sizeof(int));
-
-    // Write the block back to the disk.
-    BF_Block_SetDirty(block);
-    CALL_OR_DIE(BF_UnpinBlock(block));
-    // Memory managment
-    BF_Block_Destroy(&block);
+	char* data = BF_Block_GetData(info->block) + hashedId * sizeof(int);
+    int bucket;
+    memcpy(&bucket, data, sizeof(int));
+
+    if(bucket == UNITIALLIZED){
+        // Add the new block inside the bucket at the position of the hashed id.
+        bucket = createBlock(info);
+        CALL_OR_DIE(BF_UnpinBlock(info->newBlock));
+        memcpy(data, &bucket, sizeof(int));
+        // Write the block back to the disk.
+        BF_Block_SetDirty(info->block);
+    }
+    CALL_OR_DIE(BF_UnpinBlock(info->block));
+    return bucket;
 }
 
 // Frees the memory of the structs SHT_info, SHT_block_info.
@@ -161,11 +276,53 @@ static void infoDestroy(SHT_info* info, SHT_block_info* block_info){
     free(block_info);
 }
 
-// Checks if a specific file is a secondaryhashTable file
-bool isSecondaryHashTable(SHT_info* info){
-    if(info->isSecondaryHashTable)
-        return false;
-    return true;
+// Returns how many entries fit inside a block of a SHT_ENTRIES file.
+static ulint maxEntriesPerBlock(SHT_info* info){
+    return (BF_BLOCK_SIZE - sizeof(SHT_block_info)) / info->entrySize;
+}
+
+// Returns how many SHT_Keys fit inside a block of a SHT_POSTINGS file.
+static ulint maxKeysPerBlock(SHT_info* info){
+    return (BF_BLOCK_SIZE - sizeof(SHT_block_info)) / keyEntrySize(info);
+}
+
+// Writes the included columns of the record one after the other into column, in Record_Attribute order.
+static void packColumns(SHT_info* info, const Record* record, char* column){
+    for(Record_Attribute attribute = ID; attribute <= CITY; attribute++){
+        if(!(info->includedColumns & ATTRIBUTE_BIT(attribute)))
+            continue;
+        memcpy(column, (const char*)record + attributeOffset(attribute), attributeSize(attribute));
+        column += attributeSize(attribute);
+    }
+}
+
+// Writes the entry of the record into entry: the key slot, the blockId, the hash
+// and then the included columns of the record in Record_Attribute order.
+static void makeEntry(SHT_info* info, const Record* record, int blockId, uint hash, char* entry){
+    memset(entry, 0, info->entrySize);
+    makeKey(info, record, entry);
+    memcpy(entry + keySlotSize(info), &blockId, sizeof(int));
+    memcpy(entry + keySlotSize(info) + sizeof(int), &hash, sizeof(uint));
+    packColumns(info, record, entry + keySlotSize(info) + 2 * sizeof(int));
+}
+
+// Reverses makeEntry. The attributes that the entry does not include are left empty.
+static void readEntry(SHT_info* info, const char* entry, Record* record){
+    memset(record, 0, sizeof(*record));
+    const char* key = entry;
+    for(int i = 0; i < info->numOfKeyAttributes; i++){
+        Record_Attribute attribute = info->keyAttributes[i];
+        memcpy((char*)record + attributeOffset(attribute), key, attributeSize(attribute));
+        key += attributeSize(attribute);
+    }
+
+    const char* column = entry + keySlotSize(info) + 2 * sizeof(int);
+    for(Record_Attribute attribute = ID; attribute <= CITY; attribute++){
+        if(!(info->includedColumns & ATTRIBUTE_BIT(attribute)))
+            continue;
+        memcpy((char*)record + attributeOffset(attribute), column, attributeSize(attribute));
+        column += attributeSize(attribute);
+    }
 }
 
 // Borrowed by the Data Bases class of Mister Chatzikokolakis!
@@ -177,58 +334,807 @@ uint hash_string(void* value) {
     return hash;                        // foo << 5 is a faster version of foo * 32.
 }
 
-// Prints the record inside HT_Block with id:blockId and record.name = name.
-// If there isnt a block with this recordId inside return -1.
-// If there is this block, returns 0.
-// Also incease the number of blocks that have been read until we found all the records with record.name == name
-int printHT_blockId(HT_info* ht_info, int blockId, char* name){
-    BF_Block *block;
-	BF_Block_Init(&block);
+// Comparator for qsort over block ids.
+static int compareBlockIds(const void* a, const void* b){
+    int first = *(const int*)a;
+    int second = *(const int*)b;
+    return (first > second) - (first < second);
+}
+
+// Appends blockId into the growable array blockIds.
+// The array is (re)allocated when there isnt space for one more id.
+static void appendBlockId(int** blockIds, int* numOfBlockIds, int* capacity, int blockId){
+    if(*numOfBlockIds == *capacity){
+        *capacity = *capacity ? 2 * (*capacity) : 16;
+        *blockIds = realloc(*blockIds, *capacity * sizeof(int));
+    }
+    (*blockIds)[(*numOfBlockIds)++] = blockId;
+}
+
+// Sorts the block ids and removes the duplicates.
+// Returns the number of distinct block ids that remained at the start of the array.
+static int sortAndDedupeBlockIds(int* blockIds, int numOfBlockIds){
+    if(numOfBlockIds == 0)
+        return 0;
+    qsort(blockIds, numOfBlockIds, sizeof(int), compareBlockIds);
+    int distinct = 1;
+    for(int i = 1; i < numOfBlockIds; i++)
+        if(blockIds[i] != blockIds[distinct - 1])
+            blockIds[distinct++] = blockIds[i];
+    return distinct;
+}
 
+// Returns the number of bytes that encodeVarint needs for value.
+static int varintSize(uint value){
+    int bytes = 1;
+    while(value >= 0x80){
+        value >>= 7;
+        bytes++;
+    }
+    return bytes;
+}
+
+// Writes value as a varint: 7 bits in every byte, the high bit of a byte
+// is set when more bytes follow. Returns the number of bytes written.
+static int encodeVarint(uint value, unsigned char* out){
+    int bytes = 0;
+    while(value >= 0x80){
+        out[bytes++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[bytes++] = value;
+    return bytes;
+}
+
+// Reads a varint written by encodeVarint. Returns the number of bytes read.
+static int decodeVarint(const unsigned char* in, uint* value){
+    int bytes = 0;
+    int shift = 0;
+    *value = 0;
+    do{
+        *value |= (uint)(in[bytes] & 0x7F) << shift;
+        shift += 7;
+    }while(in[bytes++] & 0x80);
+    return bytes;
+}
+
+// Returns the number of bytes that encodePostings needs for the sorted blockIds.
+static int encodedPostingsSize(const int* blockIds, int numOfBlockIds){
+    int bytes = 0;
+    int previous = 0;
+    for(int i = 0; i < numOfBlockIds; i++){
+        bytes += varintSize(blockIds[i] - previous);
+        previous = blockIds[i];
+    }
+    return bytes;
+}
+
+// Writes every blockId as its distance from the previous one.
+// The first blockId is written as is. Returns the number of bytes written.
+static int encodePostings(const int* blockIds, int numOfBlockIds, unsigned char* out){
+    int bytes = 0;
+    int previous = 0;
+    for(int i = 0; i < numOfBlockIds; i++){
+        bytes += encodeVarint(blockIds[i] - previous, out + bytes);
+        previous = blockIds[i];
+    }
+    return bytes;
+}
+
+// Reverses encodePostings. Returns the number of blockIds that were decoded.
+static int decodePostings(const unsigned char* in, int numOfBytes, int* blockIds){
+    int numOfBlockIds = 0;
+    int bytes = 0;
+    int previous = 0;
+    while(bytes < numOfBytes){
+        uint delta;
+        bytes += decodeVarint(in + bytes, &delta);
+        previous += delta;
+        blockIds[numOfBlockIds++] = previous;
+    }
+    return numOfBlockIds;
+}
+
+// Writes the sorted blockIds into the data of a postings block and updates
+// its SHT_postings_info and SHT_block_info.numOfSHTRecords.
+// The caller has checked that they fit inside MAX_POSTING_BYTES.
+static void writePostings(char* data, const int* blockIds, int numOfBlockIds){
+    SHT_postings_info postingsInfo;
+    postingsInfo.firstBlockId = blockIds[0];
+    postingsInfo.lastBlockId = blockIds[numOfBlockIds - 1];
+    postingsInfo.numOfBytes = encodePostings(blockIds, numOfBlockIds, (unsigned char*)data + sizeof(postingsInfo));
+    memcpy(data, &postingsInfo, sizeof(postingsInfo));
+
+    ulint numOfPostings = numOfBlockIds;
+    memcpy(data + BYTES_UNTIL_NUM_OF_RECORDS, &numOfPostings, sizeof(ulint));
+}
 
-    // Get the block with id = block
-    CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, blockId, block));
-    // Get the data of this block
+// Allocates a new postings block that holds the sorted blockIds and whose next block is next.
+// Returns the id of the new block.
+// It uses the handle info->newBlock.
+static int createPostingsBlock(SHT_info* info, const int* blockIds, int numOfBlockIds, int next){
+    int newBlock = createBlock(info);
+
+    // The new block is still pinned, fill it.
+    BF_Block* block = info->newBlock;
     char* data = BF_Block_GetData(block);
-    // Get the numOfRecords of the block
-    data += BYTES_UNTIL_NUM_OF_RECORDS;
-    ulint numOfRecords;
-    memcpy(&numOfRecords, data, sizeof(ulint)); 
-    Record record;
-    // Go back to the start of the currentBlock data
-    data -= BYTES_UNTIL_NUM_OF_RECORDS;
 
-    for(int i = 0; i < numOfRecords; i++){
-        // Get the record
-        memcpy(&record, data, sizeof(record));
-        // Check if the record.id has the correct value, and the names are the same.
-        if (!strcmp(record.name, name)){
-            printRecord(record);
-            // Memory Managment
+    writePostings(data, blockIds, numOfBlockIds);
+    memcpy(data + BYTES_UNTIL_NEXT, &next, sizeof(int));
+
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    return newBlock;
+}
+
+// Inserts blockId into the sorted postings chain that starts at firstPostingBlock.
+// It uses the handle info->postingsBlock, so the block of the SHT_Key can stay pinned.
+// Returns 1 if the blockId was inserted and 0 if the chain already had it.
+static int insertPosting(SHT_info* info, int firstPostingBlock, int blockId){
+    BF_Block* block = info->postingsBlock;
+
+    int blockIds[MAX_POSTINGS_PER_BLOCK + 1];
+    int currentBlock = firstPostingBlock;
+    while(true){
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        SHT_postings_info postingsInfo;
+        memcpy(&postingsInfo, data, sizeof(postingsInfo));
+        int next;
+        memcpy(&next, data + BYTES_UNTIL_NEXT, sizeof(int));
+
+        // The blockId belongs to the first block of the chain that ends at or after it.
+        // Bigger blockIds than all the others go to the last block.
+        if(blockId > postingsInfo.lastBlockId && next != UNITIALLIZED){
+            CALL_OR_DIE(BF_UnpinBlock(block));
+            currentBlock = next;
+            continue;
+        }
+
+        // The HT returns the same blockId for consecutive inserts until the block fills up,
+        // so the most common duplicate is the last blockId.
+        if(blockId == postingsInfo.lastBlockId){
             CALL_OR_DIE(BF_UnpinBlock(block));
-            BF_Block_Destroy(&block);
             return 0;
         }
-        // Go to the next Record
-        data += sizeof(Record);
+
+        if(blockId > postingsInfo.lastBlockId){
+            // Append it at the end of the chain.
+            unsigned char bytes[MAX_VARINT_BYTES];
+            int size = encodeVarint(blockId - postingsInfo.lastBlockId, bytes);
+            if(postingsInfo.numOfBytes + size <= MAX_POSTING_BYTES){
+                memcpy(data + sizeof(postingsInfo) + postingsInfo.numOfBytes, bytes, size);
+                postingsInfo.numOfBytes += size;
+                postingsInfo.lastBlockId = blockId;
+                memcpy(data, &postingsInfo, sizeof(postingsInfo));
+                ulint numOfPostings;
+                memcpy(&numOfPostings, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+                numOfPostings++;
+                memcpy(data + BYTES_UNTIL_NUM_OF_RECORDS, &numOfPostings, sizeof(ulint));
+            }
+            else{
+                // The last block is full, continue the chain into a new block.
+                int newBlock = createPostingsBlock(info, &blockId, 1, UNITIALLIZED);
+                memcpy(data + BYTES_UNTIL_NEXT, &newBlock, sizeof(int));
+            }
+        }
+        else{
+            // Insert it in the middle of the block.
+            int numOfBlockIds = decodePostings((unsigned char*)data + sizeof(postingsInfo), postingsInfo.numOfBytes, blockIds);
+            int position = 0;
+            while(blockIds[position] < blockId)
+                position++;
+            if(blockIds[position] == blockId){
+                CALL_OR_DIE(BF_UnpinBlock(block));
+                return 0;
+            }
+            memmove(blockIds + position + 1, blockIds + position, (numOfBlockIds - position) * sizeof(int));
+            blockIds[position] = blockId;
+            numOfBlockIds++;
+
+            if(encodedPostingsSize(blockIds, numOfBlockIds) <= MAX_POSTING_BYTES)
+                writePostings(data, blockIds, numOfBlockIds);
+            else{
+                // Split the block, its second half moves into a new block right after it.
+                int half = numOfBlockIds / 2;
+                int newBlock = createPostingsBlock(info, blockIds + half, numOfBlockIds - half, next);
+                writePostings(data, blockIds, half);
+                memcpy(data + BYTES_UNTIL_NEXT, &newBlock, sizeof(int));
+            }
+        }
+
+        BF_Block_SetDirty(block);
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        return 1;
     }
+}
 
-    // Memory Managment
+// Inserts the blockId of the record into a SHT_POSTINGS file.
+// If the key of the record has no SHT_Key yet, a SHT_Key is appended at the end of its bucket.
+static int postingsInsertEntry(SHT_info* sht_info, Record record, int block_id){
+    // The handle of the file, so an insert does not allocate any memory.
+    BF_Block *block = sht_info->block;
+
+    // Hash the key.
+    SearchKey search;
+    makeKey(sht_info, &record, search.key);
+    search.hash = hashKey(sht_info, search.key);
+    uint hashedIndex = search.hash % sht_info->numOfBuckets;
+
+    int firstBlock = checkBucket(sht_info, hashedIndex);
+
+    // Search the bucket for the SHT_Key of the key.
+    // We remember the last block, in case the key is new.
+    ulint firstPostingBlockOffset = keySlotSize(sht_info);
+    ulint numOfPostingsOffset = keySlotSize(sht_info) + 2 * sizeof(int);
+    int currentBlock = firstBlock;
+    int lastBlock = currentBlock;
+    while(currentBlock != UNITIALLIZED){
+        CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, currentBlock, block));
+        char* data = BF_Block_GetData(block);
+        ulint numOfKeys;
+        memcpy(&numOfKeys, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        for(int i = 0; i < numOfKeys; i++){
+            char* entry = data + i * keyEntrySize(sht_info);
+            if(!keyMatches(sht_info, entry, &search))
+                continue;
+            // The key exists, add the blockId to its postings.
+            int firstPostingBlock;
+            memcpy(&firstPostingBlock, entry + firstPostingBlockOffset, sizeof(int));
+            if(insertPosting(sht_info, firstPostingBlock, block_id)){
+                int numOfPostings;
+                memcpy(&numOfPostings, entry + numOfPostingsOffset, sizeof(int));
+                numOfPostings++;
+                memcpy(entry + numOfPostingsOffset, &numOfPostings, sizeof(int));
+                BF_Block_SetDirty(block);
+            }
+            CALL_OR_DIE(BF_UnpinBlock(block));
+            return 0;
+        }
+        lastBlock = currentBlock;
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_UnpinBlock(block));
+    }
+
+    // The key is new. Make its SHT_Key and its first postings block.
+    char key[MAX_SHT_ENTRY_SIZE];
+    memset(key, 0, keyEntrySize(sht_info));
+    memcpy(key, search.key, sht_info->keySize);
+    int firstPostingBlock = createPostingsBlock(sht_info, &block_id, 1, UNITIALLIZED);
+    int numOfPostings = 1;
+    memcpy(key + firstPostingBlockOffset, &firstPostingBlock, sizeof(int));
+    memcpy(key + firstPostingBlockOffset + sizeof(int), &search.hash, sizeof(uint));
+    memcpy(key + numOfPostingsOffset, &numOfPostings, sizeof(int));
+
+    CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, lastBlock, block));
+    char* data = BF_Block_GetData(block);
+    ulint numOfKeys;
+    memcpy(&numOfKeys, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+    if(numOfKeys == maxKeysPerBlock(sht_info)){
+        // The last block of the bucket is full, continue the bucket into a new block.
+        int newBlock = createBlock(sht_info);
+        memcpy(data + BYTES_UNTIL_NEXT, &newBlock, sizeof(int));
+        BF_Block_SetDirty(block);
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        // The new block is still pinned, fill it.
+        block = sht_info->newBlock;
+        data = BF_Block_GetData(block);
+        numOfKeys = 0;
+    }
+    memcpy(data + numOfKeys * keyEntrySize(sht_info), key, keyEntrySize(sht_info));
+    numOfKeys++;
+    memcpy(data + BYTES_UNTIL_NUM_OF_RECORDS, &numOfKeys, sizeof(ulint));
+
+    BF_Block_SetDirty(block);
     CALL_OR_DIE(BF_UnpinBlock(block));
+    return 0;
+}
+
+// Walks the bucket chain of the key inside a SHT_POSTINGS file and appends into blockIds
+// the postings of its SHT_Key. Only the postings blocks of this key are read.
+// Returns the number of SHT blocks that were read.
+static int collectPostings(SHT_info* sht_info, const SearchKey* search,
+                           int** blockIds, int* numOfBlockIds, int* capacity){
+    BF_Block *block = sht_info->block;
+
+    uint hashedIndex = search->hash % sht_info->numOfBuckets;
+
+    int firstPostingBlock = UNITIALLIZED;
+    int currentBlock = readBucket(sht_info, hashedIndex);
+    int blocksRead = 0;
+    while(currentBlock != UNITIALLIZED && firstPostingBlock == UNITIALLIZED){
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+        ulint numOfKeys;
+        memcpy(&numOfKeys, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        for(int i = 0; i < numOfKeys; i++){
+            const char* entry = data + i * keyEntrySize(sht_info);
+            if(keyMatches(sht_info, entry, search)){
+                memcpy(&firstPostingBlock, entry + keySlotSize(sht_info), sizeof(int));
+                break;
+            }
+        }
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+        blocksRead++;
+    }
+
+    // Decode the postings chain of the key.
+    int postings[MAX_POSTINGS_PER_BLOCK];
+    currentBlock = firstPostingBlock;
+    while(currentBlock != UNITIALLIZED){
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+        SHT_postings_info postingsInfo;
+        memcpy(&postingsInfo, data, sizeof(postingsInfo));
+        int numOfPostings = decodePostings((const unsigned char*)data + sizeof(postingsInfo), postingsInfo.numOfBytes, postings);
+        for(int i = 0; i < numOfPostings; i++)
+            appendBlockId(blockIds, numOfBlockIds, capacity, postings[i]);
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+        blocksRead++;
+    }
+
+    return blocksRead;
+}
+
+// Walks the bucket chain of the key and appends into blockIds the HT blockId
+// of every entry with this key.
+// Returns the number of SHT blocks that were read.
+static int collectBlockIds(SHT_info* sht_info, const SearchKey* search,
+                           int** blockIds, int* numOfBlockIds, int* capacity){
+    if(sht_info->format == SHT_POSTINGS)
+        return collectPostings(sht_info, search, blockIds, numOfBlockIds, capacity);
+
+    BF_Block *block = sht_info->block;
+
+    uint hashedIndex = search->hash % sht_info->numOfBuckets;
+
+    int currentBlock = readBucket(sht_info, hashedIndex);
+    int blocksRead = 0;
+    // Iterate into all the blocks with this hashedIndex
+    while(currentBlock != UNITIALLIZED){
+        // Get the data of the block with id = currentBlock
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+        // Get the numOfSHTRecords of the block
+        ulint numOfSHTRecords;
+        memcpy(&numOfSHTRecords, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        const char* entry = data;
+        for(int i = 0; i < numOfSHTRecords; i++, entry += sht_info->entrySize){
+            // Its possible that there are multiple Records with the same key.
+            // We want them all, so we only remember where they are.
+            if(keyMatches(sht_info, entry, search)){
+                int blockId;
+                memcpy(&blockId, entry + keySlotSize(sht_info), sizeof(int));
+                appendBlockId(blockIds, numOfBlockIds, capacity, blockId);
+            }
+        }
+        // Go to the next block.
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+        blocksRead++;
+    }
+
+    return blocksRead;
+}
+
+// A (key, blockId) pair of the primary file, sorted by SHT_BuildFromPrimary.
+// Only the columns that the index includes are stored, see buildEntrySize.
+typedef struct {
+    uint bucket;                    // The bucket of the SHT where the pair goes.
+    uint hash;                      // hashKey(key).
+    char key[SHT_MAX_KEY_SIZE];     // The key of the record, as makeKey writes it.
+    int blockId;                    // The HT block that holds the record.
+    char columns[sizeof(Record)];   // The included columns of the record, as packColumns writes them.
+} BuildEntry;
+
+// The state of SHT_BuildFromPrimary while the primary file is scanned.
+typedef struct {
+    SHT_info* info;
+    ulint entrySize;                // Bytes of every BuildEntry, buildEntrySize.
+    char* entries;                  // The pairs of the run that is being filled.
+    ulint numOfEntries;
+    ulint capacity;                 // Room of pairs, it grows up to maxEntries.
+    ulint maxEntries;               // Pairs of a run, the memory budget.
+    TMP_file** runs;                // The sorted runs that were written, all of them closed.
+    int numOfRuns;
+    int runCapacity;                // Room of runs.
+} Build;
+
+// Returns the bytes of a BuildEntry of the index: the room of the columns that
+// it does not include is cut from the end, rounded up to a multiple of an int.
+static ulint buildEntrySize(SHT_info* info){
+    ulint size = offsetof(BuildEntry, columns) + info->entrySize - keySlotSize(info) - 2 * sizeof(int);
+    return (size + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+// Orders the pairs by bucket, then by key, then by blockId.
+static int compareBuildEntries(const void* a, const void* b){
+    const BuildEntry* first = a;
+    const BuildEntry* second = b;
+    if(first->bucket != second->bucket)
+        return (first->bucket > second->bucket) - (first->bucket < second->bucket);
+    int keys = memcmp(first->key, second->key, SHT_MAX_KEY_SIZE);
+    if(keys)
+        return keys;
+    return (first->blockId > second->blockId) - (first->blockId < second->blockId);
+}
+
+// Sorts the pairs of the build and writes them as a new run. The run is closed,
+// so the runs of a big primary file do not hit BF_MAX_OPEN_FILES.
+static void writeBuildRun(Build* build){
+    qsort(build->entries, build->numOfEntries, build->entrySize, compareBuildEntries);
+    TMP_file* run = TMP_Create(build->entrySize);
+    for(ulint e = 0; e < build->numOfEntries; e++)
+        TMP_Append(run, build->entries + e * build->entrySize);
+    TMP_Close(run);
+
+    if(build->numOfRuns == build->runCapacity){
+        build->runCapacity *= 2;
+        build->runs = realloc(build->runs, build->runCapacity * sizeof(TMP_file*));
+    }
+    build->runs[build->numOfRuns++] = run;
+    build->numOfEntries = 0;
+}
+
+// Returns the room of the next pair of the run that is being filled,
+// after writing the run if it already holds the pairs of the budget.
+static BuildEntry* nextBuildEntry(Build* build){
+    if(build->numOfEntries == build->capacity){
+        if(build->capacity == build->maxEntries)
+            writeBuildRun(build);
+        else{
+            build->capacity = build->capacity * 2 < build->maxEntries ? build->capacity * 2 : build->maxEntries;
+            build->entries = realloc(build->entries, build->capacity * build->entrySize);
+        }
+    }
+    return (BuildEntry*)(build->entries + build->numOfEntries++ * build->entrySize);
+}
+
+// Walks every bucket chain of the HT file and adds a BuildEntry for every record to the build.
+static void scanPrimary(HT_info* ht_info, Build* build){
+    SHT_info* sht_info = build->info;
+    BF_Block *block;
+    BF_Block_Init(&block);
+
+    // Get the buckets of the HT file.
+    CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, 1, block));
+    int *arrayOfBuckets = malloc(ht_info->numOfBuckets * sizeof(int));
+    memcpy(arrayOfBuckets, BF_Block_GetData(block), ht_info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_UnpinBlock(block));
+
+    for(int i = 0; i < ht_info->numOfBuckets; i++){
+        int currentBlock = arrayOfBuckets[i];
+        while(currentBlock != UNITIALLIZED){
+            CALL_OR_DIE(BF_GetBlock(ht_info->fileDesc, currentBlock, block));
+            char* data = BF_Block_GetData(block);
+            ulint numOfRecords;
+            memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+            for(int r = 0; r < numOfRecords; r++){
+                Record record;
+                HT_ReadRecord(ht_info->layout, data, r, &record);
+                BuildEntry* entry = nextBuildEntry(build);
+                makeKey(sht_info, &record, entry->key);
+                entry->hash = hashKey(sht_info, entry->key);
+                entry->bucket = entry->hash % sht_info->numOfBuckets;
+                entry->blockId = currentBlock;
+                packColumns(sht_info, &record, entry->columns);
+            }
+            memcpy(&currentBlock, data + HT_BYTES_UNTIL_NEXT, sizeof(int));
+            CALL_OR_DIE(BF_UnpinBlock(block));
+        }
+    }
+
+    free(arrayOfBuckets);
     BF_Block_Destroy(&block);
+}
 
-    // We didnt found any record with Id == recordId.
-    return -1;
+// Appends one fixed size entry into the chain whose last block is pinned inside block.
+// When the block is full a new block is linked after it and becomes the pinned one.
+// *blockId is the id of the pinned block and *firstBlock the first block of the chain,
+// a chain with *firstBlock == UNITIALLIZED has no blocks yet.
+static void appendPacked(SHT_info* info, BF_Block* block, int* firstBlock, int* blockId,
+                         const void* entry, size_t entrySize, ulint maxEntriesPerBlock){
+    char* data;
+    ulint numOfEntries = 0;
+    if(*firstBlock == UNITIALLIZED){
+        // The chain keeps its own handle pinned, so the new block moves into it.
+        *firstBlock = *blockId = createBlock(info);
+        CALL_OR_DIE(BF_UnpinBlock(info->newBlock));
+        CALL_OR_DIE(BF_GetBlock(info->fileDesc, *blockId, block));
+    }
+    else{
+        data = BF_Block_GetData(block);
+        memcpy(&numOfEntries, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        if(numOfEntries == maxEntriesPerBlock){
+            int newBlock = createBlock(info);
+            CALL_OR_DIE(BF_UnpinBlock(info->newBlock));
+            memcpy(data + BYTES_UNTIL_NEXT, &newBlock, sizeof(int));
+            BF_Block_SetDirty(block);
+            CALL_OR_DIE(BF_UnpinBlock(block));
+            *blockId = newBlock;
+            CALL_OR_DIE(BF_GetBlock(info->fileDesc, *blockId, block));
+            numOfEntries = 0;
+        }
+    }
+    data = BF_Block_GetData(block);
+    memcpy(data + numOfEntries * entrySize, entry, entrySize);
+    numOfEntries++;
+    memcpy(data + BYTES_UNTIL_NUM_OF_RECORDS, &numOfEntries, sizeof(ulint));
 }
 
-// Mallocs an integer with value == value
-int* create_int(int value) {
-	int* p = malloc(sizeof(int));
-	*p = value;
-	return p;
+// Unpins the last block of a chain that was written by appendPacked.
+static void finishPacked(BF_Block* block, int firstBlock){
+    if(firstBlock == UNITIALLIZED)
+        return;
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+}
+
+// Writes the sorted, distinct blockIds of one key as a packed postings chain.
+// Every block is filled with as many blockIds as fit. Returns the first block of the chain.
+static int writePostingsChain(SHT_info* info, const int* blockIds, int numOfBlockIds){
+    BF_Block* block;
+    BF_Block_Init(&block);
+
+    int firstBlock = UNITIALLIZED;
+    int previousBlock = UNITIALLIZED;
+    int start = 0;
+    while(start < numOfBlockIds){
+        // The first blockId of a block is stored as is, the next ones as deltas.
+        int bytes = varintSize(blockIds[start]);
+        int end = start + 1;
+        while(end < numOfBlockIds && bytes + varintSize(blockIds[end] - blockIds[end - 1]) <= MAX_POSTING_BYTES){
+            bytes += varintSize(blockIds[end] - blockIds[end - 1]);
+            end++;
+        }
+        int newBlock = createPostingsBlock(info, blockIds + start, end - start, UNITIALLIZED);
+        if(previousBlock == UNITIALLIZED)
+            firstBlock = newBlock;
+        else{
+            CALL_OR_DIE(BF_GetBlock(info->fileDesc, previousBlock, block));
+            memcpy(BF_Block_GetData(block) + BYTES_UNTIL_NEXT, &newBlock, sizeof(int));
+            BF_Block_SetDirty(block);
+            CALL_OR_DIE(BF_UnpinBlock(block));
+        }
+        previousBlock = newBlock;
+        start = end;
+    }
+
+    BF_Block_Destroy(&block);
+    return firstBlock;
+}
+
+// Writes the pairs of SHT_BuildFromPrimary, which come one at a time in the order of
+// compareBuildEntries, as one packed chain for every bucket. Only the SHT_Keys of one
+// bucket and the blockIds of one key of a SHT_POSTINGS file are kept in memory.
+typedef struct {
+    SHT_info* info;
+    int* arrayOfBuckets;            // The first block of the chain of every bucket.
+    BF_Block* block;                // The last block of the chain that is being written.
+    int bucket;                     // The bucket that is being written, UNITIALLIZED before the first pair.
+    int currentBlock;               // Id of the block that is pinned inside block.
+    SearchKey key;                  // SHT_POSTINGS: the key whose blockIds are collected.
+    int* blockIds;                  // Its sorted, distinct blockIds.
+    int numOfBlockIds;
+    int capacityOfBlockIds;
+    char* keys;                     // The SHT_Keys of the bucket, written after its postings chains.
+    int numOfKeys;
+    int capacityOfKeys;
+} BucketWriter;
+
+// Writes the postings chain of the key that the writer collects and keeps its SHT_Key.
+static void finishKey(BucketWriter* writer){
+    SHT_info* info = writer->info;
+    if(writer->numOfBlockIds == 0)
+        return;
+    if(writer->numOfKeys == writer->capacityOfKeys){
+        writer->capacityOfKeys = writer->capacityOfKeys ? 2 * writer->capacityOfKeys : 16;
+        writer->keys = realloc(writer->keys, writer->capacityOfKeys * keyEntrySize(info));
+    }
+    char* key = writer->keys + writer->numOfKeys++ * keyEntrySize(info);
+    int firstPostingBlock = writePostingsChain(info, writer->blockIds, writer->numOfBlockIds);
+    memset(key, 0, keyEntrySize(info));
+    memcpy(key, writer->key.key, info->keySize);
+    memcpy(key + keySlotSize(info), &firstPostingBlock, sizeof(int));
+    memcpy(key + keySlotSize(info) + sizeof(int), &writer->key.hash, sizeof(uint));
+    memcpy(key + keySlotSize(info) + 2 * sizeof(int), &writer->numOfBlockIds, sizeof(int));
+    writer->numOfBlockIds = 0;
+}
+
+// Finishes the chain of the bucket that the writer writes. SHT_POSTINGS writes the
+// SHT_Keys only now, so the SHT_Key blocks of the bucket end up next to each other.
+static void finishBucket(BucketWriter* writer){
+    SHT_info* info = writer->info;
+    if(writer->bucket == UNITIALLIZED)
+        return;
+    int* firstBlock = &writer->arrayOfBuckets[writer->bucket];
+    if(info->format == SHT_POSTINGS){
+        finishKey(writer);
+        for(int i = 0; i < writer->numOfKeys; i++)
+            appendPacked(info, writer->block, firstBlock, &writer->currentBlock,
+                         writer->keys + i * keyEntrySize(info), keyEntrySize(info), maxKeysPerBlock(info));
+        writer->numOfKeys = 0;
+    }
+    finishPacked(writer->block, *firstBlock);
+}
+
+// Adds the next pair to the chain of its bucket.
+static void writeBuildEntry(BucketWriter* writer, const BuildEntry* entry){
+    SHT_info* info = writer->info;
+    if((int)entry->bucket != writer->bucket){
+        finishBucket(writer);
+        writer->bucket = entry->bucket;
+    }
+
+    if(info->format == SHT_ENTRIES){
+        char packed[MAX_SHT_ENTRY_SIZE];
+        ulint columnsOffset = keySlotSize(info) + 2 * sizeof(int);
+        memset(packed, 0, columnsOffset);
+        memcpy(packed, entry->key, info->keySize);
+        memcpy(packed + keySlotSize(info), &entry->blockId, sizeof(int));
+        memcpy(packed + keySlotSize(info) + sizeof(int), &entry->hash, sizeof(uint));
+        memcpy(packed + columnsOffset, entry->columns, info->entrySize - columnsOffset);
+        appendPacked(info, writer->block, &writer->arrayOfBuckets[writer->bucket], &writer->currentBlock,
+                     packed, info->entrySize, maxEntriesPerBlock(info));
+        return;
+    }
+
+    // SHT_POSTINGS: the blockIds of a key are collected until the next key comes.
+    if(writer->numOfBlockIds > 0 && memcmp(entry->key, writer->key.key, SHT_MAX_KEY_SIZE))
+        finishKey(writer);
+    if(writer->numOfBlockIds == 0){
+        memcpy(writer->key.key, entry->key, SHT_MAX_KEY_SIZE);
+        writer->key.hash = entry->hash;
+    }
+    if(writer->numOfBlockIds == 0 || writer->blockIds[writer->numOfBlockIds - 1] != entry->blockId)
+        appendBlockId(&writer->blockIds, &writer->numOfBlockIds, &writer->capacityOfBlockIds, entry->blockId);
+}
+
+// Merges the numOfRuns sorted runs of the build and destroys them. Every pair is appended
+// to output in order, or passed to writeBuildEntry if output is NULL. There are at most
+// SHT_BUILD_FAN_IN runs, so the smallest current pair is found by comparing all of them.
+static void mergeBuildRuns(Build* build, TMP_file** runs, int numOfRuns, TMP_file* output, BucketWriter* writer){
+    ulint entrySize = build->entrySize;
+    char* current = malloc(numOfRuns * entrySize);
+    ulint* positions = calloc(numOfRuns, sizeof(ulint));
+    bool* exhausted = malloc(numOfRuns * sizeof(bool));
+    for(int r = 0; r < numOfRuns; r++)
+        exhausted[r] = TMP_Get(runs[r], positions[r]++, current + r * entrySize) != 0;
+
+    while(true){
+        int smallest = UNITIALLIZED;
+        for(int r = 0; r < numOfRuns; r++)
+            if(!exhausted[r] && (smallest == UNITIALLIZED ||
+               compareBuildEntries(current + r * entrySize, current + smallest * entrySize) < 0))
+                smallest = r;
+        if(smallest == UNITIALLIZED)
+            break;
+        const BuildEntry* entry = (const BuildEntry*)(current + smallest * entrySize);
+        if(output != NULL)
+            TMP_Append(output, entry);
+        else
+            writeBuildEntry(writer, entry);
+        exhausted[smallest] = TMP_Get(runs[smallest], positions[smallest]++, current + smallest * entrySize) != 0;
+    }
+
+    for(int r = 0; r < numOfRuns; r++)
+        TMP_Destroy(runs[r]);
+    free(current);
+    free(positions);
+    free(exhausted);
+}
+
+// Walks the bucket chain of the key inside a SHT_ENTRIES file and prints the projection
+// of every entry with this key straight from its included columns.
+// *recordsPrinted is increased by the number of printed entries.
+// Returns the number of SHT blocks that were read.
+static int printCoveredEntries(SHT_info* sht_info, const SearchKey* search, int projection, int* recordsPrinted){
+    BF_Block *block = sht_info->block;
+
+    uint hashedIndex = search->hash % sht_info->numOfBuckets;
+
+    int currentBlock = readBucket(sht_info, hashedIndex);
+    int blocksRead = 0;
+    while(currentBlock != UNITIALLIZED){
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+        ulint numOfSHTRecords;
+        memcpy(&numOfSHTRecords, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        const char* entry = data;
+        for(int i = 0; i < numOfSHTRecords; i++, entry += sht_info->entrySize){
+            if(!keyMatches(sht_info, entry, search))
+                continue;
+            Record record;
+            readEntry(sht_info, entry, &record);
+            printProjectedRecord(record, projection);
+            (*recordsPrinted)++;
+        }
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+        blocksRead++;
+    }
+
+    return blocksRead;
+}
+
+// Checks if the key of the record is one of the numOfSearches keys.
+static bool recordMatches(SHT_info* sht_info, const Record* record, const SearchKey* searches, int numOfSearches){
+    char key[SHT_MAX_KEY_SIZE];
+    makeKey(sht_info, record, key);
+    for(int i = 0; i < numOfSearches; i++)
+        if(!memcmp(key, searches[i].key, sht_info->keySize))
+            return true;
+    return false;
+}
+
+// Fetches every HT block of the sorted and deduplicated blockIds exactly once
+// and prints the projection of all of its records whose key is one of the numOfSearches keys.
+// Returns the number of records that were printed.
+static int printHT_blocks(HT_info* ht_info, SHT_info* sht_info, int* blockIds, int numOfBlockIds,
+                          const SearchKey* searches, int numOfSearches, int projection){
+    BF_Block **blocks = sht_info->fetchBlocks;
+
+    int recordsPrinted = 0;
+    for(int first = 0; first < numOfBlockIds; first += SHT_FETCH_BATCH){
+        // Pin the next SHT_FETCH_BATCH blocks of the schedule at once, so they are read concurrently.
+        int numOfBlocks = numOfBlockIds - first < SHT_FETCH_BATCH ? numOfBlockIds - first : SHT_FETCH_BATCH;
+        const char* datas[SHT_FETCH_BATCH];
+        CALL_OR_DIE(BF_GetBlocksData(ht_info->fileDesc, numOfBlocks, &blockIds[first], blocks, datas));
+        for(int b = 0; b < numOfBlocks; b++){
+            // Get the data of this block
+            const char* data = datas[b];
+            // Get the numOfRecords of the block
+            ulint numOfRecords;
+            memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+            Record record;
+            // A block can hold more than one record with the same key, print them all.
+            for(int i = 0; i < numOfRecords; i++){
+                HT_ReadRecord(ht_info->layout, data, i, &record);
+                if(recordMatches(sht_info, &record, searches, numOfSearches)){
+                    printProjectedRecord(record, projection);
+                    recordsPrinted++;
+                }
+            }
+            CALL_OR_DIE(BF_ReleaseBlock(ht_info->fileDesc, blocks[b]));
+        }
+    }
+
+    return recordsPrinted;
+}
+
+SHT_options SHT_DefaultOptions(void){
+    SHT_options options;
+    options.format = SHT_ENTRIES;
+    options.includedColumns = 0;
+    options.keyAttributes[0] = NAME;
+    options.numOfKeyAttributes = 1;
+    options.buildMemoryBudget = DEFAULT_BUILD_MEMORY_BUDGET;
+    return options;
 }
 
 int SHT_CreateSecondaryIndex(char *sfileName, int buckets, char* fileName){
+    return SHT_CreateSecondaryIndexWithOptions(sfileName, buckets, fileName, SHT_DefaultOptions());
+}
+
+int SHT_CreateSecondaryIndexWithOptions(char *sfileName, int buckets, char* fileName, SHT_options options){
+    // The primary file is not read, the entries are inserted by SHT_SecondaryInsertEntry.
+    (void)fileName;
+    // The key is a tuple of different attributes.
+    if(options.numOfKeyAttributes < 1 || options.numOfKeyAttributes > SHT_MAX_KEY_ATTRIBUTES)
+        return -1;
+    int keyColumns = 0;
+    for(int i = 0; i < options.numOfKeyAttributes; i++){
+        Record_Attribute attribute = options.keyAttributes[i];
+        if(attribute < ID || attribute > CITY || (keyColumns & ATTRIBUTE_BIT(attribute)))
+            return -1;
+        keyColumns |= ATTRIBUTE_BIT(attribute);
+    }
+    // The postings hold only blockIds, there is no space for included columns.
+    if(options.format == SHT_POSTINGS && (options.includedColumns & ~keyColumns))
+        return -1;
+
     BF_Block* block;
 
     BF_Block_Init(&block); // Initiallize the struct BF_Block.
@@ -237,12 +1143,13 @@ int SHT_CreateSecondaryIndex(char *sfileName, int buckets, char* fileName){
     int fileDescriptor; // The file descriptor of the file we are going to open.
 	CALL_OR_DIE(BF_OpenFile(sfileName, &fileDescriptor)); // Open the file
 
-    CALL_OR_DIE(BF_AllocateBlock(fileDescriptor, block));
+    int blockId;
+    CALL_OR_DIE(BF_AllocateBlockId(fileDescriptor, block, &blockId));
 
     char* data = BF_Block_GetData(block);
 
     // Create struct SHT_info
-	SHT_info* info = createSHT_info(fileDescriptor, buckets); 
+	SHT_info* info = createSHT_info(fileDescriptor, buckets, options); 
     // Store the info into the data
     memcpy(data, info, sizeof(*info));
 
@@ -269,79 +1176,212 @@ int SHT_CreateSecondaryIndex(char *sfileName, int buckets, char* fileName){
     // Memory managment
     BF_Block_Destroy(&block);
     infoDestroy(info, blockInfo);
+    return 0;
 }
 
-SHT_info* SHT_OpenSecondaryIndex(char *indexName){
+int SHT_BuildFromPrimary(char *sfileName, int buckets, char* fileName){
+    return SHT_BuildFromPrimaryWithOptions(sfileName, buckets, fileName, SHT_DefaultOptions());
+}
+
+int SHT_BuildFromPrimaryWithOptions(char *sfileName, int buckets, char* fileName, SHT_options options){
+    // The HT file is opened first, so the two files get different fileDesc.
+    HT_info* ht_info = HT_OpenFile(fileName);
+    if(ht_info == NULL)
+        return -1;
+    if(SHT_CreateSecondaryIndexWithOptions(sfileName, buckets, fileName, options) == -1){
+        HT_CloseFile(ht_info);
+        return -1;
+    }
+    SHT_info* sht_info = SHT_OpenSecondaryIndex(sfileName);
+    if(sht_info == NULL){
+        HT_CloseFile(ht_info);
+        return -1;
+    }
+
+    // One sequential pass over the primary file, sorting every memory budget of pairs into a run.
+    Build build;
+    build.info = sht_info;
+    build.entrySize = buildEntrySize(sht_info);
+    build.maxEntries = options.buildMemoryBudget / build.entrySize;
+    if(build.maxEntries == 0)
+        build.maxEntries = 1;
+    build.capacity = build.maxEntries < MIN_BUILD_CAPACITY ? build.maxEntries : MIN_BUILD_CAPACITY;
+    build.entries = malloc(build.capacity * build.entrySize);
+    build.numOfEntries = 0;
+    build.runCapacity = MIN_BUILD_CAPACITY;
+    build.runs = malloc(build.runCapacity * sizeof(TMP_file*));
+    build.numOfRuns = 0;
+    scanPrimary(ht_info, &build);
+
+    // Write the pairs in order of bucket and key, every bucket as one packed chain.
+    BucketWriter writer;
+    writer.info = sht_info;
+    writer.arrayOfBuckets = malloc(sht_info->numOfBuckets * sizeof(int));
+    for(int i = 0; i < sht_info->numOfBuckets; i++)
+        writer.arrayOfBuckets[i] = UNITIALLIZED;
+    BF_Block_Init(&writer.block);
+    writer.bucket = UNITIALLIZED;
+    writer.currentBlock = UNITIALLIZED;
+    writer.blockIds = NULL;
+    writer.numOfBlockIds = 0;
+    writer.capacityOfBlockIds = 0;
+    writer.keys = NULL;
+    writer.numOfKeys = 0;
+    writer.capacityOfKeys = 0;
+    if(build.numOfRuns == 0){
+        // Every pair fits inside the budget.
+        qsort(build.entries, build.numOfEntries, build.entrySize, compareBuildEntries);
+        for(ulint e = 0; e < build.numOfEntries; e++)
+            writeBuildEntry(&writer, (const BuildEntry*)(build.entries + e * build.entrySize));
+        free(build.entries);
+    }
+    else{
+        if(build.numOfEntries > 0)
+            writeBuildRun(&build);
+        free(build.entries);
+        // Merge SHT_BUILD_FAN_IN runs at a time into longer runs, until one pass is enough.
+        while(build.numOfRuns > SHT_BUILD_FAN_IN){
+            int numOfMerged = 0;
+            for(int first = 0; first < build.numOfRuns; first += SHT_BUILD_FAN_IN){
+                int numOfRuns = build.numOfRuns - first < SHT_BUILD_FAN_IN ? build.numOfRuns - first : SHT_BUILD_FAN_IN;
+                TMP_file* merged = TMP_Create(build.entrySize);
+                mergeBuildRuns(&build, &build.runs[first], numOfRuns, merged, NULL);
+                TMP_Close(merged);
+                build.runs[numOfMerged++] = merged;
+            }
+            build.numOfRuns = numOfMerged;
+        }
+        mergeBuildRuns(&build, build.runs, build.numOfRuns, NULL, &writer);
+    }
+    finishBucket(&writer);
+    int* arrayOfBuckets = writer.arrayOfBuckets;
+    free(build.runs);
+    free(writer.blockIds);
+    free(writer.keys);
+    BF_Block_Destroy(&writer.block);
+
+    // Store all the buckets at once.
+    BF_Block* block;
+    BF_Block_Init(&block);
+    CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, 1, block));
+    memcpy(BF_Block_GetData(block), arrayOfBuckets, sht_info->numOfBuckets * sizeof(int));
+    BF_Block_SetDirty(block);
+    CALL_OR_DIE(BF_UnpinBlock(block));
+    BF_Block_Destroy(&block);
+
+    free(arrayOfBuckets);
+    SHT_CloseSecondaryIndex(sht_info);
+    HT_CloseFile(ht_info);
+    return 0;
+}
+
+// Opens the index for SHT_OpenSecondaryIndex, or for SHT_OpenSecondaryIndexReadOnly if readOnly is true.
+static SHT_info* openIndex(char *indexName, bool readOnly){
+    int fileDescriptor;                     // FileDescriptor
+
+    if(readOnly){
+        // Map the file, a file that can not be mapped is not opened.
+        if(BF_OpenFileMapped(indexName, &fileDescriptor) != BF_OK)
+            return NULL;
+    }
+    else
+        CALL_OR_DIE(BF_OpenFile(indexName, &fileDescriptor));   // Open the file
+
     BF_Block* block;                        // block
     BF_Block_Init(&block);                  // Initiallize the BF_Block.
 
     SHT_info* info = malloc(sizeof(*info)); // Allocate the struct with the metadata
-    int fileDescriptor;                     // FileDescriptor
 
-    CALL_OR_DIE(BF_OpenFile(indexName, &fileDescriptor));   // Open the file
     CALL_OR_DIE(BF_GetBlock(fileDescriptor, 0, block));     // Get the first block
     char* data = BF_Block_GetData(block);                   // Get the data of the first block
 
     // Copy the SHT_info of file
     memcpy(info, data, sizeof(*info));
+
+    // Check if the file is a SHT file, before anything else is allocated for it.
+    if(!info->isSecondaryHashTable){
+        CALL_OR_DIE(BF_UnpinBlock(block));
+        CALL_OR_DIE(readOnly ? BF_CloseFileWithPrefetch(fileDescriptor) : BF_CloseFile(fileDescriptor));
+        BF_Block_Destroy(&block);
+        free(info);
+        return NULL;
+    }
+
     // Update fileName
     // We allocate it inside openFile so we can free the pointer.
     info->fileName = malloc(strlen(indexName) + 1);
     strcpy(info->fileName, indexName);
+    // The fileDesc stored inside the file is the one it had when it was created.
+    info->fileDesc = fileDescriptor;
+    info->readOnly = readOnly;
 
-    // Copy the SHT_info of file
-    memcpy(data, info, sizeof(*info));
+    // Copy the SHT_info of file, a read-only file is left as it is.
+    if(!readOnly)
+        memcpy(data, info, sizeof(*info));
 
-    // Check if the file is a SHT file
-    if(isSecondaryHashTable(info))
-        return NULL;
-    
     // Unpin the block
     CALL_OR_DIE(BF_UnpinBlock(block));
 
     BF_Block_Destroy(&block);
 
+    // The handles and the blockIds of the insert and lookup paths are made once for every open file.
+    BF_Block_Init(&info->block);
+    BF_Block_Init(&info->postingsBlock);
+    BF_Block_Init(&info->newBlock);
+    info->blockIds = NULL;
+    info->capacityOfBlockIds = 0;
+    for(int b = 0; b < SHT_FETCH_BATCH; b++)
+        BF_Block_Init(&info->fetchBlocks[b]);
+
     return info;
 }
 
+SHT_info* SHT_OpenSecondaryIndex(char *indexName){
+    return openIndex(indexName, false);
+}
+
+SHT_info* SHT_OpenSecondaryIndexReadOnly(char *indexName){
+    return openIndex(indexName, true);
+}
 
-int SHT_CloseSecondaryIndex(SHT_info* SHT_info ){
-    // Close the file
-    CALL_OR_DIE(BF_CloseFile(SHT_info->fileDesc));
 
+int SHT_CloseSecondaryIndex(SHT_info* SHT_info ){
+    // Close the file, and the mapping of a read-only one
+    CALL_OR_DIE(SHT_info->readOnly ? BF_CloseFileWithPrefetch(SHT_info->fileDesc) : BF_CloseFile(SHT_info->fileDesc));
+
+    BF_Block_Destroy(&SHT_info->block);
+    BF_Block_Destroy(&SHT_info->postingsBlock);
+    BF_Block_Destroy(&SHT_info->newBlock);
+    for(int b = 0; b < SHT_FETCH_BATCH; b++)
+        BF_Block_Destroy(&SHT_info->fetchBlocks[b]);
+    free(SHT_info->blockIds);
     free(SHT_info->fileName);
     free(SHT_info);
     return 0;
 }
 
 int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record record, int block_id){
-    BF_Block *block;
-	BF_Block_Init(&block);
-    // Get the block where we have stored the buckets
-    CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, 1, block));
-
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
-
-    // Malloc an array to hold the buckets 
-    int *arrayOfBuckets = malloc(sht_info->numOfBuckets * sizeof(int));
-    // Copy data of buckets into the array
-    memcpy(arrayOfBuckets, data, sht_info->numOfBuckets * sizeof(int));
-
-    // Unpin the block with the buckets we dont need it anymore
-    CALL_OR_DIE(BF_UnpinBlock(block));
-
-    // Hash the Name.
-    uint hashedName = hash_string(record.name);
-    uint hashedIndex = abs(hashedName % sht_info->numOfBuckets);
-
-    // Check if a specific bucket is unitiallized.
-    // If it is allocate a new block and let bucket point to that block.
-    // If it is NOT just return and do nothing.
-    checkBucket(sht_info, arrayOfBuckets, hashedIndex);
+    // The mapping of a read-only file can not be written.
+    if(sht_info->readOnly)
+        return -1;
+    if(sht_info->format == SHT_POSTINGS)
+        return postingsInsertEntry(sht_info, record, block_id);
+
+    // The handle of the file, so an insert does not allocate any memory.
+    BF_Block *block = sht_info->block;
+    char* data;
+
+    // Hash the key.
+    char key[SHT_MAX_KEY_SIZE];
+    makeKey(sht_info, &record, key);
+    uint hashedKey = hashKey(sht_info, key);
+    uint hashedIndex = hashedKey % sht_info->numOfBuckets;
+
+    // Get the first block of the bucket.
+    // If the bucket is unitiallized a new block is allocated for it.
+    int currentBlock = checkBucket(sht_info, hashedIndex);
 
     // We need to find the last block inside that bucket to insert the SHT_Record
-    int currentBlock = arrayOfBuckets[hashedIndex];
     int nextBlock = currentBlock;
     while(nextBlock != UNITIALLIZED){
         // Get the block of the nextBlockId
@@ -367,24 +1407,24 @@ int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record record, int block_id){
     ulint numOfSHTRecords; 
     memcpy(&numOfSHTRecords, data, sizeof(ulint));
     
-    // if the numOfSHTRecords == MAX_SHT_RECORDS_PER_BLOCK allocate a new block and update 
+    // if the numOfSHTRecords == maxEntriesPerBlock allocate a new block and update 
     // the currentBlock so its next block will be the block we just allocated
-    if(numOfSHTRecords == MAX_SHT_RECORDS_PER_BLOCK){ 
-        int newBlock = createBlock(sht_info);  // create a new block
+    // Make the new entry.
+    char entry[MAX_SHT_ENTRY_SIZE];
+    makeEntry(sht_info, &record, block_id, hashedKey, entry);
+
+    if(numOfSHTRecords == maxEntriesPerBlock(sht_info)){ 
+        int newBlock = createBlock(sht_info);  // create a new block, pinned inside sht_info->newBlock
         data -= sizeof(int);                   // Go to the next field of the sht_block_info struct of the currentBlock  
         memcpy(data, &newBlock, sizeof(int));  // Pass the updated next into the next field of the ht_block_info struct of the currentBlock  
         // Write changes to block
         BF_Block_SetDirty(block);  
         // Unpin the currentBlock 
         CALL_OR_DIE(BF_UnpinBlock(block));
-        // Get the new block and its data
-        CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, newBlock, block));
+        // The new block is still pinned, fill it.
+        block = sht_info->newBlock;
         char* data = BF_Block_GetData(block); 
-        // Make a new SHT_Record and initiallize it.
-        SHT_Record sht_record; 
-        strcpy(sht_record.name, record.name);
-        sht_record.blockId = block_id;
-        memcpy(data, &sht_record, sizeof(sht_record)); // Insert the sht_record into the new block
+        memcpy(data, entry, sht_info->entrySize); // Insert the entry into the new block
         data += BYTES_UNTIL_NUM_OF_RECORDS; // Go to the SHT_block_info.numOfSHTRecords location 
         // Update the numOfSHTRecords of sht_block_info of the newBlock
         // and write it back to the data.
@@ -394,122 +1434,305 @@ int SHT_SecondaryInsertEntry(SHT_info* sht_info, Record record, int block_id){
         // Write changes to block
         BF_Block_SetDirty(block);
         CALL_OR_DIE(BF_UnpinBlock(block));
-
-        // Memory Managment
-        BF_Block_Destroy(&block);
-        free(arrayOfBuckets);
         return 0;
     }
     // If we have enough space for one more block:
     // Go back to the start of the data of the currentBlock
     data -= BYTES_UNTIL_NUM_OF_RECORDS;
 
-    // Make a new SHT_Record and initiallize it.
-    SHT_Record sht_record; 
-    strcpy(sht_record.name, record.name);
-    sht_record.blockId = block_id;
-    // Calculate the position that the record should be inserted.
-    data += numOfSHTRecords * sizeof(sht_record);    
-    // Insert the record   
-    memcpy(data, &sht_record, sizeof(sht_record)); 
+    // Calculate the position that the entry should be inserted.
+    data += numOfSHTRecords * sht_info->entrySize;    
+    // Insert the entry   
+    memcpy(data, entry, sht_info->entrySize); 
     // Update numOfSHTRecords
     numOfSHTRecords++; 
     // Go to the SHT_block_info.numOfSHTRecords location
-    data += BYTES_UNTIL_NUM_OF_RECORDS - ((numOfSHTRecords - 1) * sizeof(SHT_Record));
+    data += BYTES_UNTIL_NUM_OF_RECORDS - ((numOfSHTRecords - 1) * sht_info->entrySize);
     memcpy(data, &numOfSHTRecords, sizeof(ulint));
 
     // Write changes to block
     BF_Block_SetDirty(block);
     CALL_OR_DIE(BF_UnpinBlock(block));
-    BF_Block_Destroy(&block);
-    free(arrayOfBuckets);
     return 0;
 }
 
-int SHT_SecondaryGetAllEntries(HT_info* ht_info, SHT_info* sht_info, char* name){
-    BF_Block *block;
-	BF_Block_Init(&block);
+int SHT_SecondaryGetBlockIds(SHT_info* sht_info, void* value, int** blockIds){
+    SearchKey search;
+    makeSearchKey(sht_info, value, &search);
 
-    int recordFound = 0; // A boolean to help us return the correct exit code.
+    *blockIds = NULL;
+    int numOfBlockIds = 0;
+    int capacity = 0;
+    collectBlockIds(sht_info, &search, blockIds, &numOfBlockIds, &capacity);
+    return sortAndDedupeBlockIds(*blockIds, numOfBlockIds);
+}
 
-    // Get the block where we have stored the buckets
-    CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, 1, block));
+// Prints the projection of every record of the primary file whose key is one of the values.
+// The HT blocks of all the values are collected into one sorted schedule first.
+// Returns the number of SHT blocks that were read, or -1 if no record was found.
+static int getAllEntries(HT_info* ht_info, SHT_info* sht_info, void** values, int numOfValues, int projection){
+    // Collect the HT blocks of all the keys into one schedule.
+    // The schedule is kept inside the SHT_info, so after the first lookups it does not grow anymore,
+    // and the key of a single value stays on the stack.
+    SearchKey search;
+    SearchKey* searches = numOfValues == 1 ? &search : malloc(numOfValues * sizeof(SearchKey));
+    int numOfBlockIds = 0;
+    int blocksRead = 0;
+    for(int i = 0; i < numOfValues; i++){
+        makeSearchKey(sht_info, values[i], &searches[i]);
+        blocksRead += collectBlockIds(sht_info, &searches[i], &sht_info->blockIds, &numOfBlockIds, &sht_info->capacityOfBlockIds);
+    }
+    int* blockIds = sht_info->blockIds;
 
-    // Get the data of this block
-	char *data = BF_Block_GetData(block);
+    // Sort the schedule and remove the duplicates so every HT block is fetched once.
+    numOfBlockIds = sortAndDedupeBlockIds(blockIds, numOfBlockIds);
 
-    // Malloc an array to hold the buckets 
-    int *arrayOfBuckets = malloc(sht_info->numOfBuckets * sizeof(int));
-    // Copy data of buckets into the array
-    memcpy(arrayOfBuckets, data, sht_info->numOfBuckets * sizeof(int));
+    int recordsPrinted = 0;
+    if(numOfBlockIds > 0){
+        recordsPrinted = printHT_blocks(ht_info, sht_info, blockIds, numOfBlockIds, searches, numOfValues, projection);
+        if(recordsPrinted == 0) // Error Handling
+            fprintf(stderr, "There is not a block inside HT with these records\n");
+    }
 
-    // Unpin the block with the buckets we dont need it anymore
-    CALL_OR_DIE(BF_UnpinBlock(block));
+    // Memory Managment
+    if(searches != &search)
+        free(searches);
 
-    // Hash the Name.
-    int hashedName = hash_string(name);
-    int hashedIndex = abs(hashedName % sht_info->numOfBuckets);
+    if(recordsPrinted > 0)
+        return blocksRead;
+    // We didnt found any record with its key in values
+    return -1;
+}
 
-    int currentBlock = arrayOfBuckets[hashedIndex];
-    int* blocksRead = create_int(0);
-    // Iterate into all the blocks with this hashedIndex
+int SHT_SecondaryGetAllEntries(HT_info* ht_info, SHT_info* sht_info, void* value){
+    return getAllEntries(ht_info, sht_info, &value, 1, ALL_ATTRIBUTES);
+}
+
+int SHT_SecondaryGetAllEntriesMulti(HT_info* ht_info, SHT_info* sht_info, void** values, int numOfValues){
+    return getAllEntries(ht_info, sht_info, values, numOfValues, ALL_ATTRIBUTES);
+}
+
+int SHT_SecondaryGetAllEntriesProjected(HT_info* ht_info, SHT_info* sht_info, void* value, int projection){
+    // If the index does not include every attribute of the projection
+    // we have to read the records from the primary file.
+    int coveredColumns = sht_info->includedColumns | keyColumns(sht_info);
+    if(sht_info->format != SHT_ENTRIES || (projection & ~coveredColumns))
+        return getAllEntries(ht_info, sht_info, &value, 1, projection);
+
+    SearchKey search;
+    makeSearchKey(sht_info, value, &search);
+
+    int recordsPrinted = 0;
+    int blocksRead = printCoveredEntries(sht_info, &search, projection, &recordsPrinted);
+
+    if(recordsPrinted > 0)
+        return blocksRead;
+    // We didnt found any record with this key
+    return -1;
+}
+
+// An outer record of SHT_IndexJoin with the key of the index that it is joined on.
+typedef struct {
+    uint bucket;                    // The bucket of the SHT where the key is.
+    SearchKey search;               // The key of the outer record and its hash.
+    int outer;                      // Index of the outer record inside the batch.
+} JoinKey;
+
+// A primary block that holds records with one of the distinct keys of a batch.
+typedef struct {
+    int blockId;
+    int key;                        // Index of the distinct key inside the batch.
+} JoinPosting;
+
+// Comparator for qsort over JoinKeys, by bucket and then by key.
+// The keys are zero padded, so all their SHT_MAX_KEY_SIZE bytes can be compared.
+static int compareJoinKeys(const void* a, const void* b){
+    const JoinKey* first = a;
+    const JoinKey* second = b;
+    if(first->bucket != second->bucket)
+        return (first->bucket > second->bucket) - (first->bucket < second->bucket);
+    return memcmp(first->search.key, second->search.key, SHT_MAX_KEY_SIZE);
+}
+
+// Comparator for qsort over JoinPostings, by blockId and then by key.
+static int compareJoinPostings(const void* a, const void* b){
+    const JoinPosting* first = a;
+    const JoinPosting* second = b;
+    if(first->blockId != second->blockId)
+        return (first->blockId > second->blockId) - (first->blockId < second->blockId);
+    return (first->key > second->key) - (first->key < second->key);
+}
+
+// Appends a posting into the growable array postings.
+static void appendPosting(JoinPosting** postings, int* numOfPostings, int* capacity, int blockId, int key){
+    if(*numOfPostings == *capacity){
+        *capacity = *capacity ? 2 * (*capacity) : 64;
+        *postings = realloc(*postings, *capacity * sizeof(JoinPosting));
+    }
+    (*postings)[*numOfPostings].blockId = blockId;
+    (*postings)[*numOfPostings].key = key;
+    (*numOfPostings)++;
+}
+
+// Walks the chain of one bucket once for the distinct keys first .. last - 1 of the
+// batch, which are all inside it, and appends the postings of every key.
+static void resolveBucket(SHT_info* sht_info, int* arrayOfBuckets, const JoinKey* keys, int first, int last,
+                          JoinPosting** postings, int* numOfPostings, int* capacity){
+    BF_Block *block;
+    BF_Block_Init(&block);
+
+    // The first postings block of every key of a SHT_POSTINGS file.
+    int firstPostingBlocks[SHT_JOIN_BATCH];
+    for(int k = first; k < last; k++)
+        firstPostingBlocks[k - first] = UNITIALLIZED;
+
+    ulint entrySize = sht_info->format == SHT_POSTINGS ? keyEntrySize(sht_info) : sht_info->entrySize;
+    int currentBlock = arrayOfBuckets[keys[first].bucket];
     while(currentBlock != UNITIALLIZED){
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+        ulint numOfEntries;
+        memcpy(&numOfEntries, data + BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        const char* entry = data;
+        for(int i = 0; i < numOfEntries; i++, entry += entrySize){
+            for(int k = first; k < last; k++){
+                if(!keyMatches(sht_info, entry, &keys[k].search))
+                    continue;
+                int blockId;
+                memcpy(&blockId, entry + keySlotSize(sht_info), sizeof(int));
+                if(sht_info->format == SHT_POSTINGS)
+                    firstPostingBlocks[k - first] = blockId;
+                else
+                    appendPosting(postings, numOfPostings, capacity, blockId, k);
+                break;
+            }
+        }
+        memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+        CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+    }
 
-        // Get the block with id = currentBlock
-        CALL_OR_DIE(BF_GetBlock(sht_info->fileDesc, currentBlock, block));
-        // Get the data of this block
-        char* data = BF_Block_GetData(block);
-        // Get the numOfSHTRecords of the block
-        data += BYTES_UNTIL_NUM_OF_RECORDS;
-        ulint numOfSHTRecords;
-        memcpy(&numOfSHTRecords, data, sizeof(ulint)); 
-        SHT_Record sht_record; // temporary sht_record
-        // Go back to the start of the currentBlock data
-        data -= BYTES_UNTIL_NUM_OF_RECORDS;
-        for(int i = 0; i < numOfSHTRecords; i++){
-            // Get the sht_record
-            memcpy(&sht_record, data, sizeof(sht_record));
-            // Check if a identical record.name exist inside this block
-            if (!strcmp(sht_record.name, name)){
-                // If there is one go and find the block with this name inside the primary hash table.
-                // Then print this record.
-                int htBlockNumber = printHT_blockId(ht_info, sht_record.blockId, name);
-                if(htBlockNumber == -1){// Error Handling
-                    perror("There is not a block inside HT with this record\n"); 
-                    free(arrayOfBuckets);
-                    free(blocksRead);
-                    CALL_OR_DIE(BF_UnpinBlock(block));
-                    BF_Block_Destroy(&block);
-                    exit(1);
+    // Decode the postings chains of the keys that were found.
+    int blockIds[MAX_POSTINGS_PER_BLOCK];
+    for(int k = first; k < last; k++){
+        currentBlock = firstPostingBlocks[k - first];
+        while(currentBlock != UNITIALLIZED){
+            const char* data;
+            CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, currentBlock, block, &data));
+            SHT_postings_info postingsInfo;
+            memcpy(&postingsInfo, data, sizeof(postingsInfo));
+            int numOfBlockIds = decodePostings((const unsigned char*)data + sizeof(postingsInfo), postingsInfo.numOfBytes, blockIds);
+            for(int i = 0; i < numOfBlockIds; i++)
+                appendPosting(postings, numOfPostings, capacity, blockIds[i], k);
+            memcpy(&currentBlock, data + BYTES_UNTIL_NEXT, sizeof(int));
+            CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+        }
+    }
+
+    BF_Block_Destroy(&block);
+}
+
+// Joins one batch of at most SHT_JOIN_BATCH outer records.
+// *numOfPairs counts the pairs that were passed to callback. Returns true if callback asked to stop.
+static bool joinBatch(HT_info* ht_info, SHT_info* sht_info, int* arrayOfBuckets, const Record* outer, int numOfOuter,
+                      SHT_JoinCallback callback, void* argument, int* numOfPairs){
+    // Sort the outer records by bucket and key, so every bucket is walked once
+    // and the outer records of a key are next to each other.
+    JoinKey keys[SHT_JOIN_BATCH];
+    for(int r = 0; r < numOfOuter; r++){
+        makeKey(sht_info, &outer[r], keys[r].search.key);
+        keys[r].search.hash = hashKey(sht_info, keys[r].search.key);
+        keys[r].bucket = keys[r].search.hash % sht_info->numOfBuckets;
+        keys[r].outer = r;
+    }
+    qsort(keys, numOfOuter, sizeof(JoinKey), compareJoinKeys);
+
+    // The distinct keys: the outer records of distinct key k are keys[firstOuter[k]] .. keys[firstOuter[k + 1] - 1].
+    JoinKey distinct[SHT_JOIN_BATCH];
+    int firstOuter[SHT_JOIN_BATCH + 1];
+    int numOfDistinct = 0;
+    for(int r = 0; r < numOfOuter; r++){
+        if(r > 0 && !compareJoinKeys(&keys[r], &keys[r - 1]))
+            continue;
+        distinct[numOfDistinct] = keys[r];
+        firstOuter[numOfDistinct++] = r;
+    }
+    firstOuter[numOfDistinct] = numOfOuter;
+
+    // Resolve the postings of all the keys of a bucket with one walk of its chain.
+    JoinPosting* postings = NULL;
+    int numOfPostings = 0;
+    int capacity = 0;
+    for(int first = 0; first < numOfDistinct; ){
+        int last = first + 1;
+        while(last < numOfDistinct && distinct[last].bucket == distinct[first].bucket)
+            last++;
+        resolveBucket(sht_info, arrayOfBuckets, distinct, first, last, &postings, &numOfPostings, &capacity);
+        first = last;
+    }
+
+    // Sort the postings by block, so every primary block is fetched once for the batch.
+    if(numOfPostings > 0)
+        qsort(postings, numOfPostings, sizeof(JoinPosting), compareJoinPostings);
+
+    BF_Block *block;
+    BF_Block_Init(&block);
+    bool stop = false;
+    for(int p = 0; p < numOfPostings && !stop; ){
+        int blockId = postings[p].blockId;
+        int end = p;
+        while(end < numOfPostings && postings[end].blockId == blockId)
+            end++;
+
+        const char* data;
+        CALL_OR_DIE(BF_GetBlockData(ht_info->fileDesc, blockId, block, &data));
+        ulint numOfRecords;
+        memcpy(&numOfRecords, data + HT_BYTES_UNTIL_NUM_OF_RECORDS, sizeof(ulint));
+        Record inner;
+        char key[SHT_MAX_KEY_SIZE];
+        for(int i = 0; i < numOfRecords && !stop; i++){
+            HT_ReadRecord(ht_info->layout, data, i, &inner);
+            makeKey(sht_info, &inner, key);
+            // The same key can be listed twice for a block, join it once.
+            for(int q = p; q < end && !stop; q++){
+                int k = postings[q].key;
+                if((q > p && postings[q - 1].key == k) || memcmp(key, distinct[k].search.key, sht_info->keySize))
+                    continue;
+                for(int r = firstOuter[k]; r < firstOuter[k + 1] && !stop; r++){
+                    (*numOfPairs)++;
+                    if(callback(&outer[keys[r].outer], &inner, argument))
+                        stop = true;
                 }
-                recordFound = 1;
             }
-            // Its possible that there are multiple Records with the same name.
-            // We want to print them all.
-            // Go to the next SHT_Record
-            data += sizeof(SHT_Record);
         }
-        // There isnt any sht_record with sht_record.name == name inside this block.
-        // Go to the next block.
-        // Reset data.
-        data = BF_Block_GetData(block);
-        data += BYTES_UNTIL_NEXT;
-        memcpy(&currentBlock, data, sizeof(int));
-        CALL_OR_DIE(BF_UnpinBlock(block));
-        (*blocksRead)++;
+        CALL_OR_DIE(BF_ReleaseBlock(ht_info->fileDesc, block));
+        p = end;
     }
-    // Memory Managment
-    free(arrayOfBuckets);
-    BF_Block_Destroy(&block);
 
-    int totalBlocksRead = *blocksRead;
-    free(blocksRead);
-    if(recordFound)
-        return totalBlocksRead;
-    // We didnt found any record with record.name = name   
-    return -1;
+    BF_Block_Destroy(&block);
+    free(postings);
+    return stop;
 }
 
+int SHT_IndexJoin(HT_info* ht_info, SHT_info* sht_info, const Record* outer, int numOfOuter,
+                  SHT_JoinCallback callback, void* argument){
+    BF_Block *block;
+	BF_Block_Init(&block);
 
+    // Get the block where we have stored the buckets and copy them.
+    const char* data;
+    CALL_OR_DIE(BF_GetBlockData(sht_info->fileDesc, 1, block, &data));
+    int *arrayOfBuckets = malloc(sht_info->numOfBuckets * sizeof(int));
+    memcpy(arrayOfBuckets, data, sht_info->numOfBuckets * sizeof(int));
+    CALL_OR_DIE(BF_ReleaseBlock(sht_info->fileDesc, block));
+    BF_Block_Destroy(&block);
 
+    int numOfPairs = 0;
+    for(int first = 0; first < numOfOuter; first += SHT_JOIN_BATCH){
+        int batch = numOfOuter - first < SHT_JOIN_BATCH ? numOfOuter - first : SHT_JOIN_BATCH;
+        if(joinBatch(ht_info, sht_info, arrayOfBuckets, outer + first, batch, callback, argument, &numOfPairs))
+            break;
+    }
 
+    free(arrayOfBuckets);
+    return numOfPairs;
+}
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bf.h"
+#include "ht_table.h"
+#include "bp_table.h"
+#include "record.h"
+#include "temp_file.h"
+#include "sort.h"
+
+#define DEFAULT_MEMORY_BUDGET (1 << 20)
+#define MIN_CAPACITY 64
+
+typedef int (*Comparator)(const void* a, const void* b);
+
+// The state of a sort while the file is scanned, the argument of the scan callback.
+typedef struct {
+    Comparator compare;
+    Record* records;                // The records of the run that is being filled.
+    ulint numOfRecords;
+    ulint capacity;                 // Room of records, it grows up to maxRecords.
+    ulint maxRecords;               // Records of a run, the memory budget.
+    TMP_file** runs;                // The sorted runs that were written.
+    int numOfRuns;
+    int runCapacity;                // Room of runs.
+} Sort;
+
+// The state of a k-way merge. The runs are the leaves of a loser tree: tree[0] is the
+// run with the smallest current record and every other node keeps the run that lost
+// the match of its two subtrees. Leaf r is node numOfRuns + r and the parent of node i is i / 2.
+typedef struct {
+    Comparator compare;
+    TMP_file** runs;
+    int numOfRuns;
+    ulint* positions;               // Index of the next record of every run.
+    Record* current;                // The current record of every run.
+    bool* exhausted;                // True for a run without any records left.
+    int* tree;
+} Merge;
+
+static int compareIds(int a, int b){
+    return (a > b) - (a < b);
+}
+
+static int compareById(const void* a, const void* b){
+    return compareIds(((const Record*)a)->id, ((const Record*)b)->id);
+}
+
+static int compareByName(const void* a, const void* b){
+    const Record* first = a;
+    const Record* second = b;
+    int result = strncmp(first->name, second->name, sizeof(first->name));
+    return result ? result : compareIds(first->id, second->id);
+}
+
+static int compareBySurname(const void* a, const void* b){
+    const Record* first = a;
+    const Record* second = b;
+    int result = strncmp(first->surname, second->surname, sizeof(first->surname));
+    return result ? result : compareIds(first->id, second->id);
+}
+
+static int compareByCity(const void* a, const void* b){
+    const Record* first = a;
+    const Record* second = b;
+    int result = strncmp(first->city, second->city, sizeof(first->city));
+    return result ? result : compareIds(first->id, second->id);
+}
+
+// The comparator of every Record_Attribute.
+static const Comparator comparators[] = { compareById, compareByName, compareBySurname, compareByCity };
+
+// Sorts the records of the sort and writes them as a new run. The run is closed, so the
+// runs neither keep the blocks of the buffer while the file is scanned nor hit BF_MAX_OPEN_FILES.
+static void writeRun(Sort* sort){
+    qsort(sort->records, sort->numOfRecords, sizeof(Record), sort->compare);
+    TMP_file* run = TMP_Create(sizeof(Record));
+    for(ulint r = 0; r < sort->numOfRecords; r++)
+        TMP_Append(run, &sort->records[r]);
+    TMP_Close(run);
+
+    if(sort->numOfRuns == sort->runCapacity){
+        sort->runCapacity *= 2;
+        sort->runs = realloc(sort->runs, sort->runCapacity * sizeof(TMP_file*));
+    }
+    sort->runs[sort->numOfRuns++] = run;
+    sort->numOfRecords = 0;
+}
+
+// HT_ScanCallback that adds the record to the run that is being filled,
+// and writes the run when it holds the records of the budget.
+static int addRecord(const Record* record, void* argument){
+    Sort* sort = argument;
+    if(sort->numOfRecords == sort->capacity){
+        if(sort->capacity == sort->maxRecords)
+            writeRun(sort);
+        else{
+            sort->capacity = sort->capacity * 2 < sort->maxRecords ? sort->capacity * 2 : sort->maxRecords;
+            sort->records = realloc(sort->records, sort->capacity * sizeof(Record));
+        }
+    }
+    sort->records[sort->numOfRecords++] = *record;
+    return 0;
+}
+
+// SORT_Callback that appends the record to the temporary file of the argument.
+static int appendRecord(const Record* record, void* argument){
+    TMP_Append(argument, record);
+    return 0;
+}
+
+// Reads the next record of run r into current[r], or marks the run as exhausted.
+static void advance(Merge* merge, int r){
+    if(TMP_Get(merge->runs[r], merge->positions[r], &merge->current[r]) == 0)
+        merge->positions[r]++;
+    else
+        merge->exhausted[r] = true;
+}
+
+// Returns true if the current record of run a comes before the current record of run b.
+// An exhausted run comes after every other run.
+static bool beats(Merge* merge, int a, int b){
+    if(merge->exhausted[a])
+        return false;
+    if(merge->exhausted[b])
+        return true;
+    return merge->compare(&merge->current[a], &merge->current[b]) <= 0;
+}
+
+// Plays the matches of the subtree of node, stores the losers and returns the winner.
+static int buildTree(Merge* merge, int node){
+    if(node >= merge->numOfRuns)
+        return node - merge->numOfRuns;
+    int left = buildTree(merge, 2 * node);
+    int right = buildTree(merge, 2 * node + 1);
+    if(beats(merge, left, right)){
+        merge->tree[node] = right;
+        return left;
+    }
+    merge->tree[node] = left;
+    return right;
+}
+
+// Replays the matches from the leaf of the winner up to the root, after the winner advanced.
+// Only the losers on the path are compared, one comparison per level.
+static void replay(Merge* merge){
+    int winner = merge->tree[0];
+    for(int node = (merge->numOfRuns + winner) / 2; node > 0; node /= 2){
+        if(beats(merge, merge->tree[node], winner)){
+            int loser = winner;
+            winner = merge->tree[node];
+            merge->tree[node] = loser;
+        }
+    }
+    merge->tree[0] = winner;
+}
+
+// Merges the numOfRuns sorted runs and calls callback for every record in order,
+// until it returns nonzero. The runs are opened again by their first TMP_Get and destroyed.
+// *numOfRecords counts the records that were passed to callback. Returns true if callback asked to stop.
+static bool mergeRuns(Comparator compare, TMP_file** runs, int numOfRuns,
+                      SORT_Callback callback, void* argument, int* numOfRecords){
+    Merge merge;
+    merge.compare = compare;
+    merge.runs = runs;
+    merge.numOfRuns = numOfRuns;
+    merge.positions = calloc(numOfRuns, sizeof(ulint));
+    merge.current = malloc(numOfRuns * sizeof(Record));
+    merge.exhausted = calloc(numOfRuns, sizeof(bool));
+    merge.tree = malloc(numOfRuns * sizeof(int));
+    for(int r = 0; r < numOfRuns; r++)
+        advance(&merge, r);
+    merge.tree[0] = buildTree(&merge, 1);
+
+    bool stop = false;
+    while(!stop && !merge.exhausted[merge.tree[0]]){
+        int winner = merge.tree[0];
+        (*numOfRecords)++;
+        if(callback(&merge.current[winner], argument))
+            stop = true;
+        advance(&merge, winner);
+        replay(&merge);
+    }
+
+    for(int r = 0; r < numOfRuns; r++)
+        TMP_Destroy(runs[r]);
+    free(merge.positions);
+    free(merge.current);
+    free(merge.exhausted);
+    free(merge.tree);
+    return stop;
+}
+
+SORT_options SORT_DefaultOptions(Record_Attribute sortBy){
+    SORT_options options;
+    options.sortBy = sortBy;
+    options.memoryBudget = DEFAULT_MEMORY_BUDGET;
+    return options;
+}
+
+int SORT_Records(HT_info* ht_info, const HT_Predicate* predicate, const SORT_options* options,
+                 SORT_Callback callback, void* argument){
+    if(options->sortBy < ID || options->sortBy > CITY || options->memoryBudget < sizeof(Record))
+        return -1;
+
+    Sort sort;
+    sort.compare = comparators[options->sortBy];
+    sort.maxRecords = options->memoryBudget / sizeof(Record);
+    sort.capacity = sort.maxRecords < MIN_CAPACITY ? sort.maxRecords : MIN_CAPACITY;
+    sort.records = malloc(sort.capacity * sizeof(Record));
+    sort.numOfRecords = 0;
+    sort.runCapacity = MIN_CAPACITY;
+    sort.runs = malloc(sort.runCapacity * sizeof(TMP_file*));
+    sort.numOfRuns = 0;
+    HT_Scan(ht_info, predicate, addRecord, &sort);
+
+    int numOfRecords = 0;
+    if(sort.numOfRuns == 0){
+        // Every record fits inside the budget.
+        qsort(sort.records, sort.numOfRecords, sizeof(Record), sort.compare);
+        for(ulint r = 0; r < sort.numOfRecords; r++){
+            numOfRecords++;
+            if(callback(&sort.records[r], argument))
+                break;
+        }
+        free(sort.records);
+        free(sort.runs);
+        return numOfRecords;
+    }
+    if(sort.numOfRecords > 0)
+        writeRun(&sort);
+    free(sort.records);
+
+    // Merge SORT_MAX_FAN_IN runs at a time into longer runs, until one pass is enough.
+    while(sort.numOfRuns > SORT_MAX_FAN_IN){
+        int numOfMerged = 0;
+        for(int first = 0; first < sort.numOfRuns; first += SORT_MAX_FAN_IN){
+            int numOfRuns = sort.numOfRuns - first < SORT_MAX_FAN_IN ? sort.numOfRuns - first : SORT_MAX_FAN_IN;
+            TMP_file* merged = TMP_Create(sizeof(Record));
+            int numOfAppended = 0;
+            mergeRuns(sort.compare, &sort.runs[first], numOfRuns, appendRecord, merged, &numOfAppended);
+            TMP_Close(merged);
+            sort.runs[numOfMerged++] = merged;
+        }
+        sort.numOfRuns = numOfMerged;
+    }
+    mergeRuns(sort.compare, sort.runs, sort.numOfRuns, callback, argument, &numOfRecords);
+    free(sort.runs);
+    return numOfRecords;
+}
+
+// The argument of loadRecord.
+typedef struct {
+    BP_loader* loader;
+    bool failed;                    // True if BP_BulkLoadAdd did not accept a record.
+} BulkLoad;
+
+// SORT_Callback that adds the record to the B+-tree of the loader.
+static int loadRecord(const Record* record, void* argument){
+    BulkLoad* load = argument;
+    if(BP_BulkLoadAdd(load->loader, *record) != 0)
+        load->failed = true;
+    return load->failed;
+}
+
+int SORT_BulkLoad(HT_info* ht_info, char* fileName, ulint memoryBudget){
+    SORT_options options = SORT_DefaultOptions(ID);
+    options.memoryBudget = memoryBudget;
+    if(options.memoryBudget < sizeof(Record))
+        return -1;
+    BulkLoad load;
+    load.loader = BP_BulkLoadBegin(fileName);
+    load.failed = false;
+    if(load.loader == NULL)
+        return -1;
+
+    int numOfRecords = SORT_Records(ht_info, NULL, &options, loadRecord, &load);
+    if(BP_BulkLoadEnd(load.loader) != 0 || load.failed)
+        return -1;
+    return numOfRecords;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bf.h"
+#include "temp_file.h"
+
+#define NO_BLOCK -1
+#define NO_FILE -1
+#define CALL_OR_DIE(call)     \
+  {                           \
+    BF_ErrorCode code = call; \
+    if (code != BF_OK) {      \
+      BF_PrintError(code);    \
+      exit(code);             \
+    }                         \
+  }
+
+// Number of temporary files created by the process, part of their names.
+static int numOfCreated = 0;
+
+// Pins the block blockId of the file, allocating it if it is the first block after the end of the file.
+// The block that was pinned before is unpinned and a closed file is opened again.
+// Returns the data of the block.
+static char* pinBlock(TMP_file* file, int blockId){
+    if(file->pinnedBlock == blockId)
+        return BF_Block_GetData(file->block);
+    TMP_Unpin(file);
+    if(file->fileDesc == NO_FILE)
+        CALL_OR_DIE(BF_OpenFile(file->fileName, &file->fileDesc));
+
+    int numOfBlocks;
+    CALL_OR_DIE(BF_GetBlockCounter(file->fileDesc, &numOfBlocks));
+    if(blockId == numOfBlocks){
+        // BF_AllocateBlock pins the new block.
+        CALL_OR_DIE(BF_AllocateBlock(file->fileDesc, file->block));
+    }
+    else{
+        CALL_OR_DIE(BF_GetBlock(file->fileDesc, blockId, file->block));
+    }
+    file->pinnedBlock = blockId;
+    return BF_Block_GetData(file->block);
+}
+
+TMP_file* TMP_Create(ulint entrySize){
+    if(entrySize == 0 || entrySize > BF_BLOCK_SIZE)
+        return NULL;
+
+    // Find a name that no other file has, e.g. one of another process.
+    char fileName[64];
+    BF_ErrorCode code;
+    do{
+        int number = __atomic_fetch_add(&numOfCreated, 1, __ATOMIC_RELAXED);
+        sprintf(fileName, "tmp_%d_%d.tmp", (int)getpid(), number);
+        code = BF_CreateFile(fileName);
+    }while(code == BF_FILE_ALREADY_EXISTS);
+    if(code != BF_OK){
+        BF_PrintError(code);
+        return NULL;
+    }
+
+    TMP_file* file = malloc(sizeof(*file));
+    file->fileName = malloc(strlen(fileName) + 1);
+    strcpy(file->fileName, fileName);
+    CALL_OR_DIE(BF_OpenFile(fileName, &file->fileDesc));
+    file->entrySize = entrySize;
+    file->entriesPerBlock = BF_BLOCK_SIZE / entrySize;
+    file->numOfEntries = 0;
+    BF_Block_Init(&file->block);
+    file->pinnedBlock = NO_BLOCK;
+    return file;
+}
+
+long TMP_Append(TMP_file* file, const void* entry){
+    ulint index = file->numOfEntries;
+    char* data = pinBlock(file, index / file->entriesPerBlock);
+    memcpy(data + (index % file->entriesPerBlock) * file->entrySize, entry, file->entrySize);
+    BF_Block_SetDirty(file->block);
+    file->numOfEntries++;
+    return index;
+}
+
+int TMP_Get(TMP_file* file, ulint index, void* entry){
+    if(index >= file->numOfEntries)
+        return -1;
+    char* data = pinBlock(file, index / file->entriesPerBlock);
+    memcpy(entry, data + (index % file->entriesPerBlock) * file->entrySize, file->entrySize);
+    return 0;
+}
+
+void TMP_Unpin(TMP_file* file){
+    if(file->pinnedBlock == NO_BLOCK)
+        return;
+    CALL_OR_DIE(BF_UnpinBlock(file->block));
+    file->pinnedBlock = NO_BLOCK;
+}
+
+void TMP_Close(TMP_file* file){
+    if(file->fileDesc == NO_FILE)
+        return;
+    TMP_Unpin(file);
+    CALL_OR_DIE(BF_CloseFile(file->fileDesc));
+    file->fileDesc = NO_FILE;
+}
+
+void TMP_Clear(TMP_file* file){
+    file->numOfEntries = 0;
+}
+
+int TMP_Destroy(TMP_file* file){
+    TMP_Close(file);
+    BF_Block_Destroy(&file->block);
+    int result = remove(file->fileName) == 0 ? 0 : -1;
+    free(file->fileName);
+    free(file);
+    return result;
+}
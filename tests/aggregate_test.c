@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glob.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/ht_table.h"
+#include "../include/temp_file.h"
+#include "../include/aggregate.h"
+#include "../include/record.h"
+
+#define RECORDS_NUM 500
+#define FILE_NAME "data.db"
+
+// The groups that AGG_GroupBy passed to the callback.
+typedef struct {
+    AGG_Group groups[RECORDS_NUM];
+    int numOfGroups;
+} Groups;
+
+int collectGroup(const AGG_Group* group, void* argument){
+    Groups* groups = argument;
+    groups->groups[groups->numOfGroups++] = *group;
+    return 0;
+}
+
+// Returns the group with the string key, or NULL.
+AGG_Group* findGroup(Groups* groups, const char* key){
+    for(int i = 0; i < groups->numOfGroups; i++)
+        if(!strncmp(groups->groups[i].key, key, AGG_MAX_KEY_SIZE))
+            return &groups->groups[i];
+    return NULL;
+}
+
+// Returns the number of temporary files that exist.
+int temporaryFiles(void){
+    glob_t files;
+    int numOfFiles = glob("tmp_*.tmp", 0, NULL, &files) == 0 ? files.gl_pathc : 0;
+    globfree(&files);
+    return numOfFiles;
+}
+
+void test_TMP_File(void) {
+	BF_Init(LRU);
+    TMP_file* file = TMP_Create(sizeof(AGG_Group));
+    TEST_CHECK(file != NULL);
+    TEST_CHECK(access(file->fileName, F_OK) == 0);
+    char* fileName = malloc(strlen(file->fileName) + 1);
+    strcpy(fileName, file->fileName);
+
+    // The entries span many blocks and come back in order.
+    AGG_Group group;
+    memset(&group, 0, sizeof(group));
+    for(int i = 0; i < 100; i++){
+        group.minId = i;
+        TEST_CHECK(TMP_Append(file, &group) == i);
+    }
+    TEST_CHECK(file->numOfEntries == 100);
+    bool inOrder = true;
+    for(int i = 0; i < 100; i++){
+        TMP_Get(file, i, &group);
+        if(group.minId != i)
+            inOrder = false;
+    }
+    TEST_CHECK(inOrder);
+    TEST_CHECK(TMP_Get(file, 100, &group) == -1);
+
+    // The blocks are reused after a clear.
+    TMP_Clear(file);
+    group.minId = 7;
+    TEST_CHECK(TMP_Append(file, &group) == 0);
+    TMP_Get(file, 0, &group);
+    TEST_CHECK(group.minId == 7);
+
+    // The file is deleted.
+    TEST_CHECK(TMP_Destroy(file) == 0);
+    TEST_CHECK(access(fileName, F_OK) != 0);
+    free(fileName);
+    BF_Close();
+}
+
+void test_AGG_GroupBy(void) {
+	BF_Init(LRU);
+    HT_CreateFile(FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    srand(12569874);
+    Record records[RECORDS_NUM];
+    for(int id = 0; id < RECORDS_NUM; id++){
+        records[id] = randomRecord_WithSpecificID(id);
+        HT_InsertEntry(info, records[id]);
+    }
+
+    // Count of people per city, compared with counting the records one by one.
+    Groups* groups = malloc(sizeof(Groups));
+    groups->numOfGroups = 0;
+    AGG_options options = AGG_DefaultOptions(CITY);
+    int numOfGroups = AGG_GroupBy(info, NULL, &options, collectGroup, groups);
+    TEST_CHECK(numOfGroups == groups->numOfGroups);
+    bool allCorrect = true;
+    ulint total = 0;
+    for(int i = 0; i < groups->numOfGroups; i++)
+        total += groups->groups[i].count;
+    for(int id = 0; id < RECORDS_NUM; id++){
+        AGG_Group* group = findGroup(groups, records[id].city);
+        if(group == NULL || group->minId > id || group->maxId < id)
+            allCorrect = false;
+    }
+    TEST_CHECK(allCorrect);
+    TEST_CHECK(total == RECORDS_NUM);
+    AGG_Group* first = findGroup(groups, records[0].city);
+    int count = 0;
+    int maxId = 0;
+    for(int id = 0; id < RECORDS_NUM; id++)
+        if(!strcmp(records[id].city, records[0].city)){
+            count++;
+            maxId = id;
+        }
+    TEST_CHECK(first->count == count && first->minId == 0 && first->maxId == maxId);
+
+    // A budget of 2 groups spills, with many threads, and finds the same groups.
+    Groups* spilled = malloc(sizeof(Groups));
+    spilled->numOfGroups = 0;
+    options.numOfThreads = 4;
+    options.memoryBudget = 2 * sizeof(AGG_Group);
+    TEST_CHECK(AGG_GroupBy(info, NULL, &options, collectGroup, spilled) == numOfGroups);
+    bool sameGroups = true;
+    for(int i = 0; i < spilled->numOfGroups; i++){
+        AGG_Group* group = findGroup(groups, spilled->groups[i].key);
+        if(group == NULL || group->count != spilled->groups[i].count ||
+           group->minId != spilled->groups[i].minId || group->maxId != spilled->groups[i].maxId)
+            sameGroups = false;
+    }
+    TEST_CHECK(sameGroups);
+
+    // Distinct ids, with a spill every 8 groups.
+    spilled->numOfGroups = 0;
+    options = AGG_DefaultOptions(ID);
+    options.memoryBudget = 8 * sizeof(AGG_Group);
+    TEST_CHECK(AGG_GroupBy(info, NULL, &options, collectGroup, spilled) == RECORDS_NUM);
+    bool distinct = true;
+    for(int i = 0; i < spilled->numOfGroups; i++)
+        if(spilled->groups[i].count != 1 || spilled->groups[i].minId != spilled->groups[i].maxId)
+            distinct = false;
+    TEST_CHECK(distinct);
+
+    // A budget of one group, so a table holds a single group and every partition with more
+    // groups is split again, until a partition holds one id.
+    spilled->numOfGroups = 0;
+    options.numOfThreads = 4;
+    options.memoryBudget = sizeof(AGG_Group);
+    TEST_CHECK(AGG_GroupBy(info, NULL, &options, collectGroup, spilled) == RECORDS_NUM);
+    bool seen[RECORDS_NUM] = { false };
+    distinct = true;
+    for(int i = 0; i < spilled->numOfGroups; i++){
+        int id;
+        memcpy(&id, spilled->groups[i].key, sizeof(int));
+        if(id < 0 || id >= RECORDS_NUM || seen[id] || spilled->groups[i].count != 1 || spilled->groups[i].minId != id)
+            distinct = false;
+        else
+            seen[id] = true;
+    }
+    TEST_CHECK(distinct);
+    TEST_CHECK(temporaryFiles() == 0);
+
+    // Distinct names of the people of a city.
+    groups->numOfGroups = 0;
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.city = records[0].city;
+    options = AGG_DefaultOptions(NAME);
+    AGG_GroupBy(info, &predicate, &options, collectGroup, groups);
+    total = 0;
+    for(int i = 0; i < groups->numOfGroups; i++)
+        total += groups->groups[i].count;
+    TEST_CHECK(total == count);
+    TEST_CHECK(findGroup(groups, records[0].name) != NULL);
+
+    // The budget must hold at least one group.
+    options.memoryBudget = 1;
+    TEST_CHECK(AGG_GroupBy(info, NULL, &options, collectGroup, groups) == -1);
+
+    free(groups);
+    free(spilled);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "TMP_File", test_TMP_File },
+	{ "AGG_GroupBy", test_AGG_GroupBy },
+	{ NULL, NULL } // end the test list with a NULL
+};
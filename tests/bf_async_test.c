@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/syscall.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/bf_ext.h"
+#include "../include/bf_async.h"
+
+#define BLOCKS_NUM 64
+#define FILE_NAME "async.db"
+
+// The Makefile links the test with -Wl,--wrap=syscall, so the system calls of bf_async.c go
+// through __wrap_syscall, which fails io_uring_enter with EBADF while failEnter is true.
+static bool failEnter = false;
+
+long __real_syscall(long number, ...);
+
+long __wrap_syscall(long number, ...){
+    if(failEnter && number == __NR_io_uring_enter){
+        errno = EBADF;
+        return -1;
+    }
+    va_list arguments;
+    va_start(arguments, number);
+    long a[6];
+    for(int i = 0; i < 6; i++)
+        a[i] = va_arg(arguments, long);
+    va_end(arguments);
+    return __real_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+// The requests that completed.
+typedef struct {
+    int numOfCompleted;
+    int numOfWrong;                 // Completed without their block, or with the data of another block.
+    BF_Block* blocks[BLOCKS_NUM];
+    BF_AsyncQueue* queue;
+    int fileDesc;
+    int last;                       // The chain submits the next block until this one.
+} Completed;
+
+// BF_AsyncCallback that checks the data of the block, block b holds the byte b everywhere.
+void checkBlock(BF_ErrorCode code, BF_Block* block, int blockId, void* argument){
+    Completed* completed = argument;
+    completed->numOfCompleted++;
+    if(code != BF_OK){
+        completed->numOfWrong++;
+        return;
+    }
+    char* data = BF_Block_GetData(block);
+    if(data[0] != blockId || data[BF_BLOCK_SIZE - 1] != blockId)
+        completed->numOfWrong++;
+    BF_UnpinBlock(block);
+}
+
+// BF_AsyncCallback that checks the block and submits the next one, like a chain walk.
+void nextBlock(BF_ErrorCode code, BF_Block* block, int blockId, void* argument){
+    checkBlock(code, block, blockId, argument);
+    Completed* completed = argument;
+    if(blockId < completed->last)
+        BF_GetBlockAsync(completed->queue, completed->fileDesc, blockId + 1, completed->blocks[blockId + 1], nextBlock, completed);
+}
+
+// Reads every block of the file in a shuffled order through a queue of depth 8 with the backend.
+void readAll(int fileDesc, BF_AsyncBackend backend){
+    BF_AsyncQueue* queue = BF_AsyncCreate(8, backend);
+    TEST_CHECK(queue != NULL);
+    TEST_CHECK(BF_AsyncGetBackend(queue) == backend);
+    Completed completed;
+    memset(&completed, 0, sizeof(completed));
+    for(int b = 0; b < BLOCKS_NUM; b++)
+        BF_Block_Init(&completed.blocks[b]);
+
+    // More requests than the depth, so the queue completes some of them while they are submitted.
+    for(int i = 0; i < BLOCKS_NUM; i++){
+        int b = (i * 37) % BLOCKS_NUM;
+        TEST_CHECK(BF_GetBlockAsync(queue, fileDesc, b, completed.blocks[b], checkBlock, &completed) == BF_OK);
+        TEST_CHECK(BF_AsyncInFlight(queue) <= 8);
+    }
+    while(BF_AsyncInFlight(queue) > 0)
+        BF_AsyncComplete(queue, 1);
+    TEST_CHECK(completed.numOfCompleted == BLOCKS_NUM);
+    TEST_CHECK(completed.numOfWrong == 0);
+
+    // The callbacks submit the next requests.
+    completed.numOfCompleted = 0;
+    completed.queue = queue;
+    completed.fileDesc = fileDesc;
+    completed.last = BLOCKS_NUM - 1;
+    BF_GetBlockAsync(queue, fileDesc, 0, completed.blocks[0], nextBlock, &completed);
+    while(BF_AsyncInFlight(queue) > 0)
+        BF_AsyncComplete(queue, 1);
+    TEST_CHECK(completed.numOfCompleted == BLOCKS_NUM);
+    TEST_CHECK(completed.numOfWrong == 0);
+
+    // A request for a block that does not exist, or of a file that is not open, is not submitted.
+    completed.numOfCompleted = 0;
+    TEST_CHECK(BF_GetBlockAsync(queue, fileDesc, BLOCKS_NUM, completed.blocks[0], checkBlock, &completed) ==
+               BF_INVALID_BLOCK_NUMBER_ERROR);
+    TEST_CHECK(BF_GetBlockAsync(queue, fileDesc, -1, completed.blocks[0], checkBlock, &completed) ==
+               BF_INVALID_BLOCK_NUMBER_ERROR);
+    TEST_CHECK(BF_GetBlockAsync(queue, fileDesc + 1, 0, completed.blocks[0], checkBlock, &completed) != BF_OK);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0);
+    BF_AsyncDestroy(queue);
+    TEST_CHECK(completed.numOfCompleted == 0 && completed.numOfWrong == 0);
+
+    for(int b = 0; b < BLOCKS_NUM; b++)
+        BF_Block_Destroy(&completed.blocks[b]);
+}
+
+void test_BF_AsyncCreate(void) {
+	BF_Init(LRU);
+    TEST_CHECK(BF_CreateFile(FILE_NAME) == BF_OK);
+    int fileDesc;
+    TEST_CHECK(BF_OpenFile(FILE_NAME, &fileDesc) == BF_OK);
+    BF_Block* block;
+    BF_Block_Init(&block);
+    for(int b = 0; b < BLOCKS_NUM; b++){
+        int blockId;
+        TEST_CHECK(BF_AllocateBlockId(fileDesc, block, &blockId) == BF_OK && blockId == b);
+        memset(BF_Block_GetData(block), b, BF_BLOCK_SIZE);
+        BF_Block_SetDirty(block);
+        BF_UnpinBlock(block);
+    }
+    BF_Block_Destroy(&block);
+    TEST_CHECK(BF_CloseFile(fileDesc) == BF_OK);
+
+    TEST_CHECK(BF_AsyncCreate(0, BF_ASYNC_AUTO) == NULL);
+    TEST_CHECK(BF_AsyncCreate(BF_ASYNC_MAX_DEPTH + 1, BF_ASYNC_THREADS) == NULL);
+    BF_AsyncQueue* queue = BF_AsyncCreate(BF_ASYNC_MAX_DEPTH, BF_ASYNC_AUTO);
+    TEST_CHECK(queue != NULL && BF_AsyncGetBackend(queue) != BF_ASYNC_AUTO);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0 && BF_AsyncComplete(queue, 1) == 0);
+    BF_AsyncDestroy(queue);
+    BF_Close();
+}
+
+void test_BF_AsyncThreads(void) {
+	BF_Init(LRU);
+    int fileDesc;
+    TEST_CHECK(BF_OpenFileWithPrefetch(FILE_NAME, &fileDesc) == BF_OK);
+    readAll(fileDesc, BF_ASYNC_THREADS);
+    TEST_CHECK(BF_CloseFileWithPrefetch(fileDesc) == BF_OK);
+
+    // Without an OS file descriptor the blocks are only pinned when their request completes.
+    TEST_CHECK(BF_OpenFile(FILE_NAME, &fileDesc) == BF_OK);
+    readAll(fileDesc, BF_ASYNC_THREADS);
+    TEST_CHECK(BF_CloseFile(fileDesc) == BF_OK);
+    BF_Close();
+}
+
+void test_BF_AsyncIoUring(void) {
+    // The kernel or its configuration may not allow io_uring.
+    BF_AsyncQueue* queue = BF_AsyncCreate(8, BF_ASYNC_IO_URING);
+    if(queue == NULL){
+        TEST_MSG("io_uring is not available");
+        return;
+    }
+    BF_AsyncDestroy(queue);
+
+	BF_Init(LRU);
+    int fileDesc;
+    TEST_CHECK(BF_OpenFileWithPrefetch(FILE_NAME, &fileDesc) == BF_OK);
+    readAll(fileDesc, BF_ASYNC_IO_URING);
+    TEST_CHECK(BF_CloseFileWithPrefetch(fileDesc) == BF_OK);
+
+    TEST_CHECK(BF_OpenFile(FILE_NAME, &fileDesc) == BF_OK);
+    readAll(fileDesc, BF_ASYNC_IO_URING);
+    TEST_CHECK(BF_CloseFile(fileDesc) == BF_OK);
+    BF_Close();
+}
+
+void test_BF_AsyncFailure(void) {
+    BF_AsyncQueue* queue = BF_AsyncCreate(8, BF_ASYNC_IO_URING);
+    if(queue == NULL){
+        TEST_MSG("io_uring is not available");
+        return;
+    }
+
+	BF_Init(LRU);
+    int fileDesc;
+    TEST_CHECK(BF_OpenFileWithPrefetch(FILE_NAME, &fileDesc) == BF_OK);
+    Completed completed;
+    memset(&completed, 0, sizeof(completed));
+    BF_Block_Init(&completed.blocks[0]);
+    BF_Block_Init(&completed.blocks[1]);
+
+    // The kernel fails every io_uring_enter, so the queue fails instead of waiting forever.
+    failEnter = true;
+    TEST_CHECK(BF_GetBlockAsync(queue, fileDesc, 0, completed.blocks[0], checkBlock, &completed) == BF_OK);
+    TEST_CHECK(BF_AsyncComplete(queue, 1) == -1);
+    TEST_CHECK(BF_AsyncComplete(queue, 0) == -1);
+    TEST_CHECK(BF_GetBlockAsync(queue, fileDesc, 1, completed.blocks[1], checkBlock, &completed) == BF_ERROR);
+    BF_AsyncDestroy(queue);
+    failEnter = false;
+    TEST_CHECK(completed.numOfCompleted == 0);
+
+    BF_Block_Destroy(&completed.blocks[0]);
+    BF_Block_Destroy(&completed.blocks[1]);
+    TEST_CHECK(BF_CloseFileWithPrefetch(fileDesc) == BF_OK);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "BF_AsyncCreate", test_BF_AsyncCreate },
+	{ "BF_GetBlockAsync threads", test_BF_AsyncThreads },
+	{ "BF_GetBlockAsync io_uring", test_BF_AsyncIoUring },
+	{ "BF_AsyncComplete of a failed io_uring", test_BF_AsyncFailure },
+	{ NULL, NULL } // end the test list with a NULL
+};
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/bp_table.h"
+#include "../include/record.h"
+
+#define RECORDS_NUM 600
+#define FILE_NAME "tree.db"
+#define LOADED_NAME "loaded.db"
+#define DUPLICATES_NAME "duplicates.db"
+
+void test_BP_CreateFile(void) {
+	BF_Init(LRU);
+	BP_CreateFile(FILE_NAME);
+    // Check if the file is created.
+    TEST_CHECK((access(FILE_NAME, F_OK) == 0));
+    // Open the file to get the struct with the metadata.
+    BP_info* info = BP_OpenFile(FILE_NAME);
+    // Check if the file we created is a B+-tree file with an empty leaf as root.
+    TEST_CHECK(info->isBPlusTree);
+    TEST_CHECK(info->height == 1);
+    TEST_CHECK(!strcmp(info->fileName, FILE_NAME));
+    TEST_CHECK(BP_GetAllEntries(info, 0) == -1);
+
+	BP_CloseFile(info);
+    BF_Close();
+}
+
+void test_BP_Insert_BP_Get(void) {
+	BF_Init(LRU);
+    BP_info* info = BP_OpenFile(FILE_NAME);
+
+    // Insert the ids 0 .. RECORDS_NUM - 1 in a shuffled order.
+    int ids[RECORDS_NUM];
+    for(int i = 0; i < RECORDS_NUM; i++)
+        ids[i] = i;
+    srand(12569874);
+    for(int i = RECORDS_NUM - 1; i > 0; i--){
+        int j = rand() % (i + 1);
+        int temp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = temp;
+    }
+    for(int i = 0; i < RECORDS_NUM; i++)
+        TEST_CHECK(BP_InsertEntry(info, randomRecord_WithSpecificID(ids[i])) > 0);
+    // 600 records do not fit into one leaf, nor into the children of one internal node.
+    TEST_CHECK(info->height == 3);
+
+    // Every id is found, from the root down to its leaf.
+    bool allFound = true;
+    for(int id = 0; id < RECORDS_NUM; id++)
+        if(BP_GetAllEntries(info, id) < info->height)
+            allFound = false;
+    TEST_CHECK(allFound);
+    TEST_CHECK(BP_GetAllEntries(info, RECORDS_NUM) == -1);
+    TEST_CHECK(BP_GetAllEntries(info, -1) == -1);
+
+    // Every record with the same id is printed, even when they fill more than one leaf.
+    for(int i = 0; i < 10; i++)
+        BP_InsertEntry(info, randomRecord_WithSpecificID(42));
+    TEST_CHECK(BP_GetAllEntries(info, 42) >= info->height + 1);
+
+    // Ranges and next ids.
+    TEST_CHECK(BP_GetRangeEntries(info, 100, 120) > 0);
+    TEST_CHECK(BP_GetRangeEntries(info, 120, 100) == -1);
+    TEST_CHECK(BP_GetRangeEntries(info, RECORDS_NUM, RECORDS_NUM + 100) == -1);
+    TEST_CHECK(BP_GetNextEntries(info, 300, 5) > 0);
+    TEST_CHECK(BP_GetNextEntries(info, RECORDS_NUM - 1, 5) == -1);
+
+	BP_CloseFile(info);
+    BF_Close();
+}
+
+void test_BP_BulkLoad(void) {
+	BF_Init(LRU);
+    BP_loader* loader = BP_BulkLoadBegin(LOADED_NAME);
+    TEST_CHECK(loader != NULL);
+    for(int id = 0; id < RECORDS_NUM; id++)
+        TEST_CHECK(BP_BulkLoadAdd(loader, randomRecord_WithSpecificID(id)) == 0);
+    // The records must come in id order.
+    TEST_CHECK(BP_BulkLoadAdd(loader, randomRecord_WithSpecificID(0)) == -1);
+    TEST_CHECK(BP_BulkLoadEnd(loader) == 0);
+
+    BP_info* info = BP_OpenFile(LOADED_NAME);
+    // 100 full leaves of 6 records, two internal nodes above them and the root,
+    // plus the block of the BP_info.
+    int numOfBlocks;
+    BF_GetBlockCounter(info->fileDesc, &numOfBlocks);
+    TEST_CHECK(numOfBlocks == 104);
+    TEST_CHECK(info->height == 3);
+
+    // The root, one internal node and the leaves of 0-5, 6-11, 12-17 and 18-23.
+    TEST_CHECK(BP_GetRangeEntries(info, 0, 20) == 2 + 4);
+    // The leaf of 594-599 is the last one, the scan ends with it.
+    TEST_CHECK(BP_GetRangeEntries(info, 590, 1000) == 2 + 2);
+    // The 3 next ids are inside the leaf of 6-11.
+    TEST_CHECK(BP_GetNextEntries(info, 6, 3) == 2 + 1);
+    TEST_CHECK(BP_GetAllEntries(info, 599) == 3);
+
+	BP_CloseFile(info);
+    BF_Close();
+}
+
+void test_BP_DuplicatesOrder(void) {
+	BF_Init(LRU);
+    BP_CreateFile(DUPLICATES_NAME);
+    BP_info* info = BP_OpenFile(DUPLICATES_NAME);
+    for(int id = 0; id < 40; id++)
+        BP_InsertEntry(info, randomRecord_WithSpecificID(id));
+    // More records of the id 20 than a leaf holds, so the leaves that hold them split.
+    for(int i = 0; i < 12; i++){
+        Record record = randomRecord_WithSpecificID(20);
+        sprintf(record.name, "dup%02d", i);
+        BP_InsertEntry(info, record);
+    }
+
+    // The leaves, read through their next links, hold the records of the id 20 in insertion order.
+    char names[13][15];
+    int numOfNames = 0;
+    BF_Block* block;
+    BF_Block_Init(&block);
+    for(int blockId = info->firstLeaf; blockId != -1; ){
+        BF_GetBlock(info->fileDesc, blockId, block);
+        char* data = BF_Block_GetData(block);
+        BP_block_info blockInfo;
+        memcpy(&blockInfo, data + BF_BLOCK_SIZE - sizeof(blockInfo), sizeof(blockInfo));
+        for(int r = 0; r < blockInfo.numOfRecords; r++){
+            Record record;
+            memcpy(&record, data + r * sizeof(Record), sizeof(Record));
+            if(record.id == 20 && numOfNames < 13)
+                strcpy(names[numOfNames++], record.name);
+        }
+        BF_UnpinBlock(block);
+        blockId = blockInfo.next;
+    }
+    BF_Block_Destroy(&block);
+    TEST_CHECK(numOfNames == 13);
+    bool inOrder = true;
+    for(int i = 0; i < 12; i++){
+        char name[15];
+        sprintf(name, "dup%02d", i);
+        if(strcmp(names[i + 1], name))
+            inOrder = false;
+    }
+    TEST_CHECK(inOrder);
+    TEST_CHECK(BP_GetAllEntries(info, 20) >= info->height + 1);
+
+	BP_CloseFile(info);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "BP_CreateFile", test_BP_CreateFile },
+	{ "BP_InsertEntry\n     BP_GetAllEntries", test_BP_Insert_BP_Get },
+	{ "BP_InsertEntry of duplicates", test_BP_DuplicatesOrder },
+	{ "BP_BulkLoad", test_BP_BulkLoad },
+	{ NULL, NULL } // end the test list with a NULL
+};
@@ -5,12 +5,21 @@
 
 #include "../include/acutest.h" // A simple library for unit testing
 #include "../include/bf.h"
+#include "../include/bf_ext.h"
 #include "../include/ht_table.h"
 #include "../include/record.h"
+#include "../include/scan_kernel.h"
+#include "wrappers.h"
 
 #define RECORDS_NUM 100 
 #define FILE_NAME "data.db"
 #define INDEX_FILE_NAME "index.db"
+#define ZONES_FILE_NAME "zones.db"
+#define NO_ZONES_FILE_NAME "no_zones.db"
+#define PAX_FILE_NAME "pax.db"
+#define ALLOCATIONS_FILE_NAME "allocations.db"
+#define OTHER_FILE_NAME "other.db"
+#define EXTENTS_FILE_NAME "extents.db"
 
 void test_HT_CreateFile(void) {
 	BF_Init(LRU);
@@ -82,8 +91,8 @@ void test_HT_Insert_HT_Get(void) {
  
     BF_GetBlockCounter(info->fileDesc, numberOfBlocks);
     // We must have overflowed blocks
-    // A new block must been created.
-    TEST_CHECK(*numberOfBlocks == 4);
+    // A new extent must been created, and block 3 is its first block.
+    TEST_CHECK(*numberOfBlocks == 3 + HT_MIN_EXTENT);
 
     BF_Block *block;
 	BF_Block_Init(&block);
@@ -121,11 +130,487 @@ void test_HT_Insert_HT_Get(void) {
 }
 
 
+void test_HT_ZoneMaps(void) {
+	BF_Init(LRU);
+	HT_CreateFile(ZONES_FILE_NAME, 10);
+    // Check if the zone map file is created too.
+    TEST_CHECK((access(ZONES_FILE_NAME ".zm", F_OK) == 0));
+    HT_info* info = HT_OpenFile(ZONES_FILE_NAME);
+
+    // Bucket k gets the ids k, k + 10, ..., so its block j holds k + 60j .. k + 60j + 50.
+    for(int id = 0; id < 600; id++)
+        HT_InsertEntry(info, randomRecord_WithSpecificID(id));
+
+    // A range over every id reads every block with records, 10 for every bucket,
+    // and none of the reserved blocks of the extents.
+    TEST_CHECK(HT_GetRangeEntries(info, 0, 599) == 100);
+    // Only the second block of every bucket overlaps 100 .. 110.
+    TEST_CHECK(HT_GetRangeEntries(info, 100, 110) == 10);
+    // No zone overlaps these ranges, so no block is read.
+    TEST_CHECK(HT_GetRangeEntries(info, 1000, 2000) == -1);
+    TEST_CHECK(HT_GetRangeEntries(info, 110, 100) == -1);
+
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_Extents(void) {
+	BF_Init(LRU);
+    HT_info* info = HT_OpenFile(ZONES_FILE_NAME);
+
+    // Every bucket has 10 blocks: its first block, an extent of 8 blocks
+    // and the first block of an extent of 9 blocks, as long as the chain was.
+    int numberOfBlocks;
+    BF_GetBlockCounter(info->fileDesc, &numberOfBlocks);
+    TEST_CHECK(numberOfBlocks == 2 + 10 * (1 + HT_MIN_EXTENT + 9));
+
+    // The chains jump only from the first block to the first extent and from that to the second.
+    BF_Block* block;
+    BF_Block_Init(&block);
+    BF_GetBlock(info->fileDesc, 1, block);
+    int buckets[10];
+    memcpy(buckets, BF_Block_GetData(block), sizeof(buckets));
+    BF_UnpinBlock(block);
+    bool contiguous = true;
+    for(int bucket = 0; bucket < 10; bucket++){
+        int numOfBlocks = 0;
+        int numOfJumps = 0;
+        for(int blockId = buckets[bucket]; blockId != -1; numOfBlocks++){
+            BF_GetBlock(info->fileDesc, blockId, block);
+            HT_block_info blockInfo;
+            memcpy(&blockInfo, BF_Block_GetData(block) + BF_BLOCK_SIZE - sizeof(blockInfo), sizeof(blockInfo));
+            BF_UnpinBlock(block);
+            if(blockInfo.blockIndex != blockId)
+                contiguous = false;
+            if(blockInfo.next != -1 && blockInfo.next != blockId + 1)
+                numOfJumps++;
+            blockId = blockInfo.next;
+        }
+        if(numOfBlocks != 10 || numOfJumps != 2)
+            contiguous = false;
+    }
+    TEST_CHECK(contiguous);
+
+    BF_Block_Destroy(&block);
+	HT_CloseFile(info);
+
+    // The extents grow with the chain, up to HT_MAX_EXTENT blocks.
+    // A chain of 110 blocks takes extents of 8, 9, 18, 36 and 64 blocks after its first block.
+    HT_CreateFile(EXTENTS_FILE_NAME, 1);
+    info = HT_OpenFile(EXTENTS_FILE_NAME);
+    // An insert reads the block of the buckets, the blocks of the chain and its last block again.
+    // The block after the first one starts a new extent, which is allocated pinned and not read,
+    // while the block after that one is the next block of the extent and is read once.
+    int blockReads[2];
+    for(int id = 0; id < 6 * 110; id++){
+        numOfBlockReads[info->fileDesc] = 0;
+        HT_InsertEntry(info, randomRecord_WithSpecificID(id));
+        if(id == 6 || id == 12)
+            blockReads[id / 6 - 1] = numOfBlockReads[info->fileDesc];
+    }
+    TEST_CHECK(blockReads[0] == 1 + 1 + 1);
+    TEST_CHECK(blockReads[1] == 1 + 2 + 1 + 1);
+    BF_GetBlockCounter(info->fileDesc, &numberOfBlocks);
+    TEST_CHECK(numberOfBlocks == 2 + 1 + HT_MIN_EXTENT + 9 + 18 + 36 + HT_MAX_EXTENT);
+    // One bucket only, so the whole chain is consecutive.
+    TEST_CHECK(HT_GetAllEntries(info, 6 * 110 - 1) == 110);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+// Counts the records, and stops the scan when the count reaches the limit.
+typedef struct {
+    int count;
+    int limit;
+    int yannis;
+} Counter;
+
+int countRecords(const Record* record, void* argument){
+    Counter* counter = argument;
+    counter->count++;
+    if(!strcmp(record->name, "Yannis"))
+        counter->yannis++;
+    return counter->count == counter->limit;
+}
+
+void test_HT_Scan(void) {
+	BF_Init(LRU);
+    // The file of the previous test with the ids 0 .. 599.
+    HT_info* info = HT_OpenFile(ZONES_FILE_NAME);
+
+    Counter counter = { 0, -1, 0 };
+    TEST_CHECK(HT_Scan(info, NULL, countRecords, &counter) == 600);
+    TEST_CHECK(counter.count == 600);
+
+    // The name is compared inside the scan.
+    int yannis = counter.yannis;
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.name = "Yannis";
+    counter.count = 0;
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == yannis);
+
+    // Id bounds go through the zone map.
+    predicate = HT_AllRecords();
+    predicate.minId = 100;
+    predicate.maxId = 199;
+    counter.count = 0;
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == 100);
+
+    // The callback stops the scan.
+    counter.count = 0;
+    counter.limit = 5;
+    TEST_CHECK(HT_Scan(info, NULL, countRecords, &counter) == 5);
+
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_MissingZoneMap(void) {
+	BF_Init(LRU);
+	HT_CreateFile(NO_ZONES_FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(NO_ZONES_FILE_NAME);
+    for(int id = 0; id < 600; id++)
+        HT_InsertEntry(info, randomRecord_WithSpecificID(id));
+    HT_CloseFile(info);
+
+    // The zone map file of the hash file is deleted.
+    TEST_CHECK(remove(NO_ZONES_FILE_NAME ".zm") == 0);
+    info = HT_OpenFile(NO_ZONES_FILE_NAME);
+    TEST_CHECK(info != NULL && !info->hasZoneMap);
+
+    // Without zones every block with records is read.
+    TEST_CHECK(HT_GetRangeEntries(info, 100, 110) == 100);
+    TEST_CHECK(HT_GetRangeEntries(info, 1000, 2000) == -1);
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = 100;
+    predicate.maxId = 110;
+    Counter counter = { 0, -1, 0 };
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == 11);
+
+    // The inserts still work, without making a zone map.
+    TEST_CHECK(HT_InsertEntry(info, randomRecord_WithSpecificID(1000)) >= 0);
+    TEST_CHECK(HT_GetRangeEntries(info, 1000, 2000) > 0);
+	HT_CloseFile(info);
+    TEST_CHECK(access(NO_ZONES_FILE_NAME ".zm", F_OK) == -1);
+
+    info = HT_OpenFileReadOnly(NO_ZONES_FILE_NAME);
+    TEST_CHECK(info != NULL && HT_GetRangeEntries(info, 100, 110) == 101);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_ParallelScan(void) {
+	BF_Init(LRU);
+    // The file of the previous tests with the ids 0 .. 599.
+    HT_info* info = HT_OpenFile(ZONES_FILE_NAME);
+
+    // Every thread counts into its own counter.
+    Counter counters[4] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, -1, 0 }, { 0, -1, 0 } };
+    void* arguments[4] = { &counters[0], &counters[1], &counters[2], &counters[3] };
+    TEST_CHECK(HT_ParallelScan(info, NULL, countRecords, arguments, 4) == 600);
+    int count = 0;
+    int yannis = 0;
+    for(int t = 0; t < 4; t++){
+        count += counters[t].count;
+        yannis += counters[t].yannis;
+    }
+    TEST_CHECK(count == 600);
+
+    // Same records as the sequential scan.
+    Counter counter = { 0, -1, 0 };
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.name = "Yannis";
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == yannis);
+    for(int t = 0; t < 4; t++)
+        counters[t].count = 0;
+    TEST_CHECK(HT_ParallelScan(info, &predicate, countRecords, arguments, 4) == yannis);
+
+    // A callback stops every thread.
+    for(int t = 0; t < 4; t++){
+        counters[t].count = 0;
+        counters[t].limit = 5;
+    }
+    int passed = HT_ParallelScan(info, NULL, countRecords, arguments, 4);
+    TEST_CHECK(passed >= 5 && passed < 600);
+
+    // The statistics do not depend on the number of threads.
+    HT_statistics statistics;
+    int bucketRecords[10];
+    TEST_CHECK(HT_GetStatistics(info, 4, &statistics, bucketRecords) == 0);
+    TEST_CHECK(statistics.numOfRecords == 600);
+    TEST_CHECK(statistics.minId == 0);
+    TEST_CHECK(statistics.maxId == 599);
+    TEST_CHECK(statistics.minRecords == 60 && statistics.maxRecords == 60);
+    TEST_CHECK(statistics.minRecordsBucket == 0 && statistics.maxRecordsBucket == 0);
+    TEST_CHECK(statistics.numOfBucketsOverflowed == 10);
+    for(int i = 0; i < 10; i++)
+        TEST_CHECK(bucketRecords[i] == 60);
+    // 10 blocks for every bucket, without the reserved blocks of their extents.
+    TEST_CHECK(statistics.numOfBucketBlocks == 100);
+    TEST_CHECK(statistics.numOfBlocks == 2 + 100);
+    HT_statistics sequential;
+    TEST_CHECK(HT_GetStatistics(info, 1, &sequential, NULL) == 0);
+    TEST_CHECK(!memcmp(&statistics, &sequential, sizeof(statistics)));
+
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_PaxLayout(void) {
+	BF_Init(LRU);
+    TEST_CHECK(HT_CreateFileWithLayout(PAX_FILE_NAME, 10, HT_PAX) == 0);
+    HT_info* info = HT_OpenFile(PAX_FILE_NAME);
+    TEST_CHECK(info->layout == HT_PAX);
+    HT_info* rowInfo = HT_OpenFile(ZONES_FILE_NAME);
+    TEST_CHECK(rowInfo->layout == HT_ROW);
+
+    // The same ids as the file of the previous tests.
+    srand(12569874);
+    Record records[600];
+    for(int id = 0; id < 600; id++){
+        records[id] = randomRecord_WithSpecificID(id);
+        HT_InsertEntry(info, records[id]);
+    }
+
+    // The ids of a block are stored one after the other at its start.
+    BF_Block *block;
+	BF_Block_Init(&block);
+    BF_GetBlock(info->fileDesc, 2, block);
+    char* data = BF_Block_GetData(block);
+    int ids[2];
+    memcpy(ids, data, sizeof(ids));
+    TEST_CHECK(ids[0] == 0 && ids[1] == 10);
+    Record record;
+    HT_ReadRecord(HT_PAX, data, 1, &record);
+    TEST_CHECK(record.id == 10 && !strcmp(record.name, records[10].name) && !strcmp(record.city, records[10].city));
+    BF_UnpinBlock(block);
+    BF_Block_Destroy(&block);
+
+    // Point lookups and scans find the same records with both layouts.
+    TEST_CHECK(HT_GetAllEntries(info, 123) == HT_GetAllEntries(rowInfo, 123));
+    TEST_CHECK(HT_GetAllEntries(info, 600) == -1);
+    TEST_CHECK(HT_GetRangeEntries(info, 100, 110) == 10);
+    Counter counter = { 0, -1, 0 };
+    TEST_CHECK(HT_Scan(info, NULL, countRecords, &counter) == 600);
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.city = records[7].city;
+    predicate.minId = 5;
+    predicate.maxId = 500;
+    int expected = 0;
+    for(int id = 5; id <= 500; id++)
+        if(!strcmp(records[id].city, records[7].city))
+            expected++;
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == expected);
+
+	HT_CloseFile(rowInfo);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_ScanKernel(void) {
+    // Records with garbage after the '\0' of their fields, which strncmp ignores.
+    Record records[MAX_FILTERED_RECORDS];
+    memset(records, 'x', sizeof(records));
+    srand(12569874);
+    for(int r = 0; r < MAX_FILTERED_RECORDS; r++){
+        Record record = randomRecord_WithSpecificID(r % 7);
+        strcpy(records[r].name, record.name);
+        strcpy(records[r].surname, record.surname);
+        strcpy(records[r].city, record.city);
+        records[r].id = record.id;
+    }
+    // Fields that fill their whole array, without a '\0'.
+    memcpy(records[3].name, "Konstantinaaaaa", 15);
+    memcpy(records[4].city, "Konstantinoupolisaaa", 20);
+
+    char* names[] = { NULL, "Yannis", "Konstantinaaaaa", "Konstantinaaaaaa", "Konstantina", "" };
+    char* cities[] = { NULL, "Athens", "Konstantinoupolisaaa", "Konstantinoupolis" };
+    bool allEqual = true;
+    for(int n = 0; n < 6; n++)
+        for(int c = 0; c < 4; c++)
+            for(int numOfRecords = 1; numOfRecords <= MAX_FILTERED_RECORDS; numOfRecords += 5){
+                HT_Predicate predicate = HT_AllRecords();
+                predicate.minId = 2;
+                predicate.maxId = 5;
+                predicate.name = names[n];
+                predicate.city = cities[c];
+                if(filterRecords(records, numOfRecords, &predicate) != filterRecordsScalar(records, numOfRecords, &predicate))
+                    allEqual = false;
+                // The same records stored with the HT_PAX layout, six records per block.
+                char block[BF_BLOCK_SIZE];
+                memset(block, 'x', sizeof(block));
+                int paxRecords = numOfRecords < 6 ? numOfRecords : 6;
+                for(int r = 0; r < paxRecords; r++)
+                    HT_WriteRecord(HT_PAX, block, r, &records[r]);
+                uint paxPassed = filterBlock(block, HT_PAX, paxRecords, &predicate);
+                if(paxPassed != filterBlockScalar(block, HT_PAX, paxRecords, &predicate))
+                    allEqual = false;
+                if(paxPassed != filterRecordsScalar(records, paxRecords, &predicate))
+                    allEqual = false;
+            }
+    // The kernel that is used finds the same records as the scalar loop.
+    TEST_CHECK(allEqual);
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.name = "Konstantinaaaaa";
+    TEST_CHECK(filterRecords(records, MAX_FILTERED_RECORDS, &predicate) & (1u << 3));
+
+    // The kernel is the AVX2 one exactly when the CPU has AVX2.
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    TEST_CHECK(!strcmp(filterKernelName(), __builtin_cpu_supports("avx2") ? "avx2" : "scalar"));
+#else
+    TEST_CHECK(!strcmp(filterKernelName(), "scalar"));
+#endif
+}
+
+void test_HT_AllocationFree(void) {
+	BF_Init(LRU);
+    HT_CreateFile(ALLOCATIONS_FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(ALLOCATIONS_FILE_NAME);
+    Record records[RECORDS_NUM];
+    for(int id = 0; id < RECORDS_NUM; id++)
+        records[id] = randomRecord_WithSpecificID(id);
+
+    // The inserts allocate the first block of every bucket and many more blocks after it,
+    // and the lookups read every bucket, with the handles of the HT_info only.
+    // The allocations of libbf itself are not counted.
+    long allocations = numOfAllocations;
+    for(int id = 0; id < RECORDS_NUM; id++)
+        HT_InsertEntry(info, records[id]);
+    TEST_CHECK(HT_GetAllEntries(info, 0) == 1);
+    TEST_CHECK(HT_GetAllEntries(info, RECORDS_NUM - 1) == 2);
+    TEST_CHECK(HT_GetAllEntries(info, RECORDS_NUM + 5) == -1);
+    TEST_CHECK(numOfAllocations == allocations);
+
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_OpenOtherFile(void) {
+	BF_Init(LRU);
+    // A file whose first block is zeroed, like a file of another kind.
+    TEST_CHECK(BF_CreateFile(OTHER_FILE_NAME) == BF_OK);
+    int fileDesc;
+    TEST_CHECK(BF_OpenFile(OTHER_FILE_NAME, &fileDesc) == BF_OK);
+    BF_Block* block;
+    BF_Block_Init(&block);
+    int blockId;
+    TEST_CHECK(BF_AllocateBlockId(fileDesc, block, &blockId) == BF_OK && blockId == 0);
+    TEST_CHECK(BF_UnpinBlock(block) == BF_OK);
+
+    // Three more blocks at once, with the same data.
+    char data[BF_BLOCK_SIZE];
+    memset(data, 7, sizeof(data));
+    TEST_CHECK(BF_AllocateBlocks(fileDesc, 3, block, data, &blockId) == BF_OK && blockId == 1);
+    int blocksNum;
+    TEST_CHECK(BF_GetBlockCounter(fileDesc, &blocksNum) == BF_OK && blocksNum == 4);
+    TEST_CHECK(BF_GetBlock(fileDesc, 3, block) == BF_OK);
+    TEST_CHECK(BF_Block_GetData(block)[BF_BLOCK_SIZE - 1] == 7);
+    TEST_CHECK(BF_UnpinBlock(block) == BF_OK);
+    BF_Block_Destroy(&block);
+    TEST_CHECK(BF_CloseFile(fileDesc) == BF_OK);
+
+    // All of them pinned at once, with read-ahead hints.
+    TEST_CHECK(BF_OpenFileWithPrefetch(OTHER_FILE_NAME, &fileDesc) == BF_OK);
+    BF_Block* blocks[4];
+    for(int b = 0; b < 4; b++)
+        BF_Block_Init(&blocks[b]);
+    int blockIds[4] = { 1, 2, 3, 0 };
+    TEST_CHECK(BF_GetBlocks(fileDesc, 4, blockIds, blocks) == BF_OK);
+    for(int b = 0; b < 4; b++){
+        TEST_CHECK(BF_Block_GetData(blocks[b])[0] == (blockIds[b] == 0 ? 0 : 7));
+        BF_UnpinBlock(blocks[b]);
+        BF_Block_Destroy(&blocks[b]);
+    }
+    TEST_CHECK(BF_CloseFileWithPrefetch(fileDesc) == BF_OK);
+
+    // The open is rejected and leaves nothing open behind, many times over.
+    for(int i = 0; i < 2 * BF_MAX_OPEN_FILES; i++)
+        TEST_CHECK(HT_OpenFile(OTHER_FILE_NAME) == NULL);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    TEST_CHECK(info != NULL);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_HT_OpenFileReadOnly(void) {
+	BF_Init(LRU);
+    // The file of the previous tests with the ids 0 .. 599, read through the BF level first.
+    HT_info* info = HT_OpenFile(ZONES_FILE_NAME);
+    int blocksRead[3] = { HT_GetAllEntries(info, 0), HT_GetAllEntries(info, 599), HT_GetAllEntries(info, 600) };
+    HT_statistics statistics;
+    TEST_CHECK(HT_GetStatistics(info, 4, &statistics, NULL) == 0);
+    int numOfBlocks;
+    BF_GetBlockCounter(info->fileDesc, &numOfBlocks);
+	HT_CloseFile(info);
+
+    info = HT_OpenFileReadOnly(ZONES_FILE_NAME);
+    TEST_CHECK(info != NULL && info->readOnly);
+
+    // Every block of the mapping is the block that the BF level reads.
+    BF_Block* block;
+    BF_Block_Init(&block);
+    bool same = true;
+    for(int blockId = 0; blockId < numOfBlocks; blockId++){
+        const char* data;
+        TEST_CHECK(BF_GetBlockData(info->fileDesc, blockId, NULL, &data) == BF_OK);
+        BF_GetBlock(info->fileDesc, blockId, block);
+        if(memcmp(data, BF_Block_GetData(block), BF_BLOCK_SIZE))
+            same = false;
+        BF_UnpinBlock(block);
+        TEST_CHECK(BF_ReleaseBlock(info->fileDesc, NULL) == BF_OK);
+    }
+    TEST_CHECK(same);
+    const char* data;
+    TEST_CHECK(BF_GetBlockData(info->fileDesc, numOfBlocks, NULL, &data) == BF_INVALID_BLOCK_NUMBER_ERROR);
+    BF_Block_Destroy(&block);
+
+    // The lookups and the scans find the same records inside the mapping.
+    TEST_CHECK(HT_GetAllEntries(info, 0) == blocksRead[0]);
+    TEST_CHECK(HT_GetAllEntries(info, 599) == blocksRead[1]);
+    TEST_CHECK(HT_GetAllEntries(info, 600) == blocksRead[2]);
+    Counter counter = { 0, -1, 0 };
+    TEST_CHECK(HT_Scan(info, NULL, countRecords, &counter) == 600);
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.minId = 100;
+    predicate.maxId = 199;
+    counter.count = 0;
+    TEST_CHECK(HT_Scan(info, &predicate, countRecords, &counter) == 100);
+    Counter counters[4] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, -1, 0 }, { 0, -1, 0 } };
+    void* arguments[4] = { &counters[0], &counters[1], &counters[2], &counters[3] };
+    TEST_CHECK(HT_ParallelScan(info, NULL, countRecords, arguments, 4) == 600);
+    HT_statistics mapped;
+    TEST_CHECK(HT_GetStatistics(info, 4, &mapped, NULL) == 0);
+    TEST_CHECK(!memcmp(&statistics, &mapped, sizeof(statistics)));
+
+    // The file can not be changed.
+    TEST_CHECK(HT_InsertEntry(info, randomRecord_WithSpecificID(600)) == -1);
+    TEST_CHECK(HT_GetAllEntries(info, 600) == blocksRead[2]);
+	HT_CloseFile(info);
+
+    // A file of another kind is rejected and leaves nothing open or mapped behind.
+    for(int i = 0; i < 2 * BF_MAX_OPEN_FILES; i++)
+        TEST_CHECK(HT_OpenFileReadOnly(OTHER_FILE_NAME) == NULL);
+    info = HT_OpenFileReadOnly(FILE_NAME);
+    TEST_CHECK(info != NULL);
+	HT_CloseFile(info);
+    BF_Close();
+}
 
 // List of all the tests
 TEST_LIST = {
 	{ "HT_CreateFile", test_HT_CreateFile },
 	{ "HT_OpenFile", test_HT_OpenFile },
 	{ "HT_InsertEntry\n     HT_GetAllEntries", test_HT_Insert_HT_Get},
+	{ "HT_GetRangeEntries", test_HT_ZoneMaps},
+	{ "HT extent allocation", test_HT_Extents},
+	{ "HT_Scan", test_HT_Scan},
+	{ "HT file without a zone map", test_HT_MissingZoneMap},
+	{ "HT_ParallelScan\n     HT_GetStatistics", test_HT_ParallelScan},
+	{ "HT_PAX layout", test_HT_PaxLayout},
+	{ "Scan kernel", test_HT_ScanKernel},
+	{ "Insert and lookup without allocations outside libbf", test_HT_AllocationFree},
+	{ "HT_OpenFile of another file", test_HT_OpenOtherFile},
+	{ "HT_OpenFileReadOnly", test_HT_OpenFileReadOnly},
 	{ NULL, NULL } // end the test list with a NULL
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glob.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/ht_table.h"
+#include "../include/join.h"
+#include "../include/record.h"
+
+#define LEFT_NAME "left.db"
+#define RIGHT_NAME "right.db"
+#define OTHER_NAME "other.db"
+
+// The pairs that a join passed to the callback.
+typedef struct {
+    int numOfPairs;
+    long sumOfIds;                  // Sum of the ids of the pairs.
+    bool sameIds;                   // False if a pair has different ids.
+    int limit;                      // Stop after limit pairs, -1 for no limit.
+} Pairs;
+
+int collectPair(const Record* left, const Record* right, void* argument){
+    Pairs* pairs = argument;
+    pairs->numOfPairs++;
+    pairs->sumOfIds += left->id;
+    if(left->id != right->id)
+        pairs->sameIds = false;
+    return pairs->numOfPairs == pairs->limit;
+}
+
+// Returns the number of temporary files that exist.
+int temporaryFiles(void){
+    glob_t files;
+    int numOfFiles = glob("tmp_*.tmp", 0, NULL, &files) == 0 ? files.gl_pathc : 0;
+    globfree(&files);
+    return numOfFiles;
+}
+
+// The pairs of a join and the most temporary files that existed while a pair was passed.
+typedef struct {
+    Pairs pairs;
+    int maxTemporaryFiles;
+} TrackedPairs;
+
+int trackPair(const Record* left, const Record* right, void* argument){
+    TrackedPairs* tracked = argument;
+    int numOfFiles = temporaryFiles();
+    if(numOfFiles > tracked->maxTemporaryFiles)
+        tracked->maxTemporaryFiles = numOfFiles;
+    return collectPair(left, right, &tracked->pairs);
+}
+
+void test_JOIN_HashJoin(void) {
+	BF_Init(LRU);
+    // left has the ids 0 .. 299 once, right and other the even ids 0 .. 598 twice.
+    HT_CreateFile(LEFT_NAME, 10);
+    HT_CreateFileWithLayout(RIGHT_NAME, 10, HT_PAX);
+    HT_CreateFile(OTHER_NAME, 7);
+    HT_info* left = HT_OpenFile(LEFT_NAME);
+    HT_info* right = HT_OpenFile(RIGHT_NAME);
+    HT_info* other = HT_OpenFile(OTHER_NAME);
+    for(int id = 0; id < 300; id++)
+        HT_InsertEntry(left, randomRecord_WithSpecificID(id));
+    for(int id = 0; id < 600; id += 2)
+        for(int copy = 0; copy < 2; copy++){
+            Record record = randomRecord_WithSpecificID(id);
+            HT_InsertEntry(right, record);
+            HT_InsertEntry(other, record);
+        }
+    // The even ids 0 .. 298 match, twice every one.
+    long sumOfIds = 0;
+    for(int id = 0; id < 300; id += 2)
+        sumOfIds += 2 * id;
+
+    // Same number of buckets: the buckets are joined one after the other.
+    Pairs pairs = { 0, 0, true, -1 };
+    TEST_CHECK(JOIN_HashJoin(left, right, collectPair, &pairs) == 300);
+    TEST_CHECK(pairs.numOfPairs == 300 && pairs.sumOfIds == sumOfIds && pairs.sameIds);
+
+    // Different number of buckets: grace hash join, with the same pairs.
+    Pairs gracePairs = { 0, 0, true, -1 };
+    TEST_CHECK(JOIN_HashJoin(left, other, collectPair, &gracePairs) == 300);
+    TEST_CHECK(gracePairs.sumOfIds == sumOfIds && gracePairs.sameIds);
+    Pairs reversePairs = { 0, 0, true, -1 };
+    TEST_CHECK(JOIN_HashJoin(other, left, collectPair, &reversePairs) == 300);
+    TEST_CHECK(reversePairs.sumOfIds == sumOfIds && reversePairs.sameIds);
+
+    // The callback stops both joins.
+    Pairs limited = { 0, 0, true, 5 };
+    TEST_CHECK(JOIN_HashJoin(left, right, collectPair, &limited) == 5);
+    limited.numOfPairs = 0;
+    TEST_CHECK(JOIN_HashJoin(left, other, collectPair, &limited) == 5);
+
+	HT_CloseFile(left);
+	HT_CloseFile(right);
+	HT_CloseFile(other);
+    BF_Close();
+}
+
+void test_JOIN_GraceBudget(void) {
+	BF_Init(LRU);
+    // The files of the previous test.
+    HT_info* left = HT_OpenFile(LEFT_NAME);
+    HT_info* other = HT_OpenFile(OTHER_NAME);
+    long sumOfIds = 0;
+    for(int id = 0; id < 300; id += 2)
+        sumOfIds += 2 * id;
+
+    // The whole files fit inside the default budget, so only the partitions of level 0 exist.
+    TrackedPairs tracked = { { 0, 0, true, -1 }, 0 };
+    TEST_CHECK(JOIN_HashJoin(left, other, trackPair, &tracked) == 300);
+    TEST_CHECK(tracked.maxTemporaryFiles <= 2 * JOIN_GRACE_PARTITIONS);
+
+    // About 19 left records for every partition of level 0 do not fit inside a budget of 4,
+    // so the partitions are split, and the files of the next level exist next to the others.
+    TrackedPairs split = { { 0, 0, true, -1 }, 0 };
+    TEST_CHECK(JOIN_HashJoinWithBudget(left, other, 4 * sizeof(Record), trackPair, &split) == 300);
+    TEST_CHECK(split.pairs.sumOfIds == sumOfIds && split.pairs.sameIds);
+    TEST_CHECK(split.maxTemporaryFiles > 2 * JOIN_GRACE_PARTITIONS);
+    // With 600 left records two ids can stay inside a partition of level 1, so it is split again.
+    Pairs reversePairs = { 0, 0, true, -1 };
+    TEST_CHECK(JOIN_HashJoinWithBudget(other, left, 2 * sizeof(Record), collectPair, &reversePairs) == 300);
+    TEST_CHECK(reversePairs.sumOfIds == sumOfIds && reversePairs.sameIds);
+    Pairs limited = { 0, 0, true, 5 };
+    TEST_CHECK(JOIN_HashJoinWithBudget(left, other, 4 * sizeof(Record), collectPair, &limited) == 5);
+    TEST_CHECK(JOIN_HashJoinWithBudget(left, other, sizeof(Record) - 1, collectPair, &limited) == -1);
+    TEST_CHECK(temporaryFiles() == 0);
+
+	HT_CloseFile(left);
+	HT_CloseFile(other);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "JOIN_HashJoin", test_JOIN_HashJoin },
+	{ "JOIN_HashJoinWithBudget", test_JOIN_GraceBudget },
+	{ NULL, NULL } // end the test list with a NULL
+};
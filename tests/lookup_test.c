@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/ht_table.h"
+#include "../include/bf_async.h"
+#include "../include/lookup.h"
+#include "../include/record.h"
+
+#define RECORDS_NUM 600
+#define IDS_NUM 700
+#define FILE_NAME "lookups.db"
+#define EMPTY_FILE_NAME "empty.db"
+#define BROKEN_FILE_NAME "broken.db"
+
+// The results that LOOKUP_GetAllEntries passed to the callback.
+typedef struct {
+    int numOfResults;
+    int numOfWrong;                 // Results of the wrong record or with the wrong number of blocks.
+    bool seen[IDS_NUM];
+    const int* ids;
+    Record* records;
+    int limit;                      // Stop after limit results, -1 for no limit.
+} Results;
+
+// Bucket id % 10 holds its ids in insertion order, 6 per block, inside a chain of 10 blocks.
+int checkResult(int index, const Record* record, int blocksRead, void* argument){
+    Results* results = argument;
+    results->numOfResults++;
+    int id = results->ids[index];
+    if(results->seen[index])
+        results->numOfWrong++;
+    results->seen[index] = true;
+    if(id < RECORDS_NUM){
+        if(record == NULL || record->id != id || strcmp(record->name, results->records[id].name) ||
+           blocksRead != id / 10 / 6 + 1)
+            results->numOfWrong++;
+    }
+    else if(record != NULL || blocksRead != 10)
+        results->numOfWrong++;
+    return results->numOfResults == results->limit;
+}
+
+// Looks up the ids with a queue of the backend and the depth, and checks every result.
+void lookupAll(HT_info* info, const int* ids, Record* records, BF_AsyncBackend backend, int depth){
+    BF_AsyncQueue* queue = BF_AsyncCreate(depth, backend);
+    TEST_CHECK(queue != NULL);
+    Results* results = calloc(1, sizeof(Results));
+    results->ids = ids;
+    results->records = records;
+    results->limit = -1;
+    TEST_CHECK(LOOKUP_GetAllEntries(info, ids, IDS_NUM, queue, checkResult, results) == RECORDS_NUM);
+    TEST_CHECK(results->numOfResults == IDS_NUM);
+    TEST_CHECK(results->numOfWrong == 0);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0);
+
+    // The callback stops the lookups, the ones in flight finish without a result.
+    memset(results, 0, sizeof(Results));
+    results->ids = ids;
+    results->records = records;
+    results->limit = 5;
+    TEST_CHECK(LOOKUP_GetAllEntries(info, ids, IDS_NUM, queue, checkResult, results) <= 5);
+    TEST_CHECK(results->numOfResults == 5);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0);
+
+    free(results);
+    BF_AsyncDestroy(queue);
+}
+
+void test_LOOKUP_GetAllEntries(void) {
+	BF_Init(LRU);
+    HT_CreateFile(FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    Record* records = malloc(RECORDS_NUM * sizeof(Record));
+    for(int id = 0; id < RECORDS_NUM; id++){
+        records[id] = randomRecord_WithSpecificID(id);
+        HT_InsertEntry(info, records[id]);
+    }
+    // Every id once, out of order, and 100 ids that are not inside the file.
+    int* ids = malloc(IDS_NUM * sizeof(int));
+    for(int i = 0; i < IDS_NUM; i++)
+        ids[i] = (i * 37) % IDS_NUM;
+
+    lookupAll(info, ids, records, BF_ASYNC_AUTO, 1);
+    lookupAll(info, ids, records, BF_ASYNC_AUTO, 32);
+    lookupAll(info, ids, records, BF_ASYNC_THREADS, 32);
+
+    free(ids);
+    free(records);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_LOOKUP_EmptyBuckets(void) {
+	BF_Init(LRU);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    BF_AsyncQueue* queue = BF_AsyncCreate(4, BF_ASYNC_AUTO);
+    // No read is needed for an id whose bucket is empty, nor for no id.
+    HT_CreateFile(EMPTY_FILE_NAME, 10);
+    HT_info* empty = HT_OpenFile(EMPTY_FILE_NAME);
+    int ids[3] = { 1, 2, 3 };
+    Results* results = calloc(1, sizeof(Results));
+    results->ids = ids;
+    results->limit = -1;
+    TEST_CHECK(LOOKUP_GetAllEntries(empty, ids, 3, queue, checkResult, results) == 0);
+    TEST_CHECK(results->numOfResults == 3);
+    TEST_CHECK(LOOKUP_GetAllEntries(info, ids, 0, queue, checkResult, results) == 0);
+    TEST_CHECK(results->numOfResults == 3);
+
+    free(results);
+    BF_AsyncDestroy(queue);
+	HT_CloseFile(empty);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+// Only marks the ids that finished.
+int markResult(int index, const Record* record, int blocksRead, void* argument){
+    (void)record;
+    (void)blocksRead;
+    Results* results = argument;
+    results->numOfResults++;
+    results->seen[index] = true;
+    return 0;
+}
+
+// Points the bucket id % 10 of the file, or the next block of its first block if next is true,
+// to the block after the end of the file.
+void breakChain(HT_info* info, int id, bool next){
+    int numOfBlocks;
+    BF_GetBlockCounter(info->fileDesc, &numOfBlocks);
+    BF_Block* block;
+    BF_Block_Init(&block);
+    BF_GetBlock(info->fileDesc, 1, block);
+    int* buckets = (int*)BF_Block_GetData(block);
+    int blockId = buckets[id % 10];
+    if(!next){
+        buckets[id % 10] = numOfBlocks;
+        BF_Block_SetDirty(block);
+    }
+    BF_UnpinBlock(block);
+    if(next){
+        BF_GetBlock(info->fileDesc, blockId, block);
+        HT_block_info* blockInfo = (HT_block_info*)(BF_Block_GetData(block) + BF_BLOCK_SIZE - sizeof(HT_block_info));
+        blockInfo->next = numOfBlocks;
+        BF_Block_SetDirty(block);
+        BF_UnpinBlock(block);
+    }
+    BF_Block_Destroy(&block);
+}
+
+void test_LOOKUP_MissingBlock(void) {
+	BF_Init(LRU);
+    // One block for every bucket, with the ids 0 .. 59.
+    HT_CreateFile(BROKEN_FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(BROKEN_FILE_NAME);
+    for(int id = 0; id < 60; id++)
+        HT_InsertEntry(info, randomRecord_WithSpecificID(id));
+    breakChain(info, 3, false);
+    breakChain(info, 5, true);
+    BF_AsyncQueue* queue = BF_AsyncCreate(4, BF_ASYNC_AUTO);
+    Results* results = calloc(1, sizeof(Results));
+
+    // The bucket of 3 starts after the end of the file, so its lookup fails and stops the others.
+    int ids[2][4] = { { 3, 0, 1, 2 }, { 65, 0, 1, 2 } };
+    TEST_CHECK(LOOKUP_GetAllEntries(info, ids[0], 4, queue, markResult, results) == -1);
+    TEST_CHECK(!results->seen[0]);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0);
+
+    // 65 is not inside its first block, whose next block is after the end of the file.
+    memset(results, 0, sizeof(Results));
+    TEST_CHECK(LOOKUP_GetAllEntries(info, ids[1], 4, queue, markResult, results) == -1);
+    TEST_CHECK(!results->seen[0]);
+    TEST_CHECK(BF_AsyncInFlight(queue) == 0);
+
+    // The ids of the other buckets are still found.
+    memset(results, 0, sizeof(Results));
+    TEST_CHECK(LOOKUP_GetAllEntries(info, &ids[0][1], 3, queue, markResult, results) == 3);
+    TEST_CHECK(results->numOfResults == 3);
+
+    free(results);
+    BF_AsyncDestroy(queue);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "LOOKUP_GetAllEntries", test_LOOKUP_GetAllEntries },
+	{ "LOOKUP_GetAllEntries of empty buckets", test_LOOKUP_EmptyBuckets },
+	{ "LOOKUP_GetAllEntries of a block after the end of the file", test_LOOKUP_MissingBlock },
+	{ NULL, NULL } // end the test list with a NULL
+};
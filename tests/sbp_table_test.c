@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/ht_table.h"
+#include "../include/sbp_table.h"
+#include "../include/record.h"
+
+#define RECORDS_NUM 500
+#define FILE_NAME  "data.db"
+#define INDEX_NAME "sbp_index.db"
+
+void test_SBP_CreateSecondaryIndex(void) {
+	BF_Init(LRU);
+    HT_CreateFile(FILE_NAME, 10);
+    // Only string attributes can be ordered.
+    TEST_CHECK(SBP_CreateSecondaryIndex(INDEX_NAME, FILE_NAME, ID) == -1);
+    TEST_CHECK(SBP_CreateSecondaryIndex(INDEX_NAME, FILE_NAME, NAME) == 0);
+    // Check if the file is created.
+    TEST_CHECK((access(INDEX_NAME, F_OK) == 0));
+    SBP_info* info = SBP_OpenSecondaryIndex(INDEX_NAME);
+    TEST_CHECK(info->isSecondaryBPlusTree);
+    TEST_CHECK(info->keyAttribute == NAME);
+    TEST_CHECK(info->height == 1);
+
+	SBP_CloseSecondaryIndex(info);
+    BF_Close();
+}
+
+void test_SBP_Insert_SBP_Get(void) {
+	BF_Init(LRU);
+    HT_info* ht_info = HT_OpenFile(FILE_NAME);
+    SBP_info* info = SBP_OpenSecondaryIndex(INDEX_NAME);
+
+    // Remember the HT blocks of every "Konstantina" record.
+    // Every HT block holds at least one record, so there are less than RECORDS_NUM + 2 blocks.
+    bool isKonstantinaBlock[RECORDS_NUM + 2] = { false };
+    srand(12569874);
+    for(int i = 0; i < RECORDS_NUM; i++){
+        Record record = randomRecord();
+        int blockId = HT_InsertEntry(ht_info, record);
+        TEST_CHECK(SBP_SecondaryInsertEntry(info, record, blockId) == 0);
+        if(!strcmp(record.name, "Konstantina"))
+            isKonstantinaBlock[blockId] = true;
+    }
+    // The records are spread over the HT blocks, so the index needs more than one leaf.
+    TEST_CHECK(info->height > 1);
+
+    // The blocks come sorted and every block once, even if it holds many "Konstantina".
+    int blocks[RECORDS_NUM + 2];
+    int numOfUnique = 0;
+    for(int i = 0; i < RECORDS_NUM + 2; i++)
+        if(isKonstantinaBlock[i])
+            blocks[numOfUnique++] = i;
+    int* blockIds;
+    TEST_CHECK(SBP_SecondaryGetBlockIds(info, "Konstantina", "Konstantina", &blockIds) == numOfUnique);
+    TEST_CHECK(!memcmp(blockIds, blocks, numOfUnique * sizeof(int)));
+    free(blockIds);
+
+    // Equality, prefix and range lookups.
+    TEST_CHECK(SBP_SecondaryGetAllEntries(ht_info, info, "Konstantina") > 0);
+    TEST_CHECK(SBP_SecondaryGetAllEntries(ht_info, info, "Kon") == -1);
+    TEST_CHECK(SBP_SecondaryGetPrefixEntries(ht_info, info, "Kon") > 0);
+    TEST_CHECK(SBP_SecondaryGetPrefixEntries(ht_info, info, "Zed") == -1);
+    TEST_CHECK(SBP_SecondaryGetRangeEntries(ht_info, info, "A", "B") == -1);
+    // "Dimitris" and "Dionisis" are the only names from "D" to "E".
+    int* dBlockIds;
+    int numOfD = SBP_SecondaryGetBlockIds(info, "D", "E", &dBlockIds);
+    int* dimitrisBlockIds;
+    int* dionisisBlockIds;
+    int numOfDimitris = SBP_SecondaryGetBlockIds(info, "Dimitris", "Dimitris", &dimitrisBlockIds);
+    int numOfDionisis = SBP_SecondaryGetBlockIds(info, "Dionisis", "Dionisis", &dionisisBlockIds);
+    TEST_CHECK(numOfD >= numOfDimitris && numOfD >= numOfDionisis);
+    TEST_CHECK(numOfD <= numOfDimitris + numOfDionisis);
+    free(dBlockIds);
+    free(dimitrisBlockIds);
+    free(dionisisBlockIds);
+
+    // The scan stops at the first key after the range, so a range
+    // at the start reads fewer blocks than a range over every name.
+    int firstNames = SBP_SecondaryGetRangeEntries(ht_info, info, "A", "Christofos");
+    int allNames = SBP_SecondaryGetRangeEntries(ht_info, info, "A", "Z");
+    TEST_CHECK(firstNames > 0);
+    TEST_CHECK(firstNames < allNames);
+
+	HT_CloseFile(ht_info);
+    SBP_CloseSecondaryIndex(info);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "SBP_CreateSecondaryIndex", test_SBP_CreateSecondaryIndex },
+	{ "SBP_SecondaryInsertEntry\n     SBP_SecondaryGetAllEntries", test_SBP_Insert_SBP_Get },
+	{ NULL, NULL } // end the test list with a NULL
+};
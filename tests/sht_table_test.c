@@ -2,16 +2,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <glob.h>
 
 #include "../include/acutest.h" // A simple library for unit testing
 #include "../include/bf.h"
 #include "../include/ht_table.h"
 #include "../include/sht_table.h"
 #include "../include/record.h"
+#include "wrappers.h"
 
 #define RECORDS_NUM 100 
 #define FILE_NAME  "data.db"
 #define INDEX_NAME "index.db"
+#define POSTINGS_NAME "postings.db"
+#define BUILT_NAME "built.db"
+#define BUILT_POSTINGS_NAME "built_postings.db"
+#define SPILLED_NAME "spilled.db"
+#define SPILLED_POSTINGS_NAME "spilled_postings.db"
+#define COVERING_NAME "covering.db"
+#define CITY_NAME "city.db"
+#define ID_NAME "id.db"
+#define COMPOSITE_NAME "composite.db"
+#define ALLOCATIONS_FILE_NAME "allocations.db"
+#define ALLOCATIONS_INDEX_NAME "allocations_index.db"
+#define ALLOCATIONS_POSTINGS_NAME "allocations_postings.db"
 
 void test_SHT_CreateSecondaryIndex(void) {
 	BF_Init(LRU);
@@ -79,7 +93,7 @@ void test_SHT_Insert_SHT_Get(void) {
     // We must have overflowed blocks
     // Number of buckets is 10.
     // The new block must be block with name = "a".
-    int maxSHT_Entries = 25; // Max entries that a shtBlock can hold are 24
+    int maxSHT_Entries = 25; // Max entries that a shtBlock can hold are 20
     for(int i = 0; i < maxSHT_Entries; i++){
         record = randomRecord_WithSpecificName("a");
         int block_id = HT_InsertEntry(info, record);
@@ -94,6 +108,35 @@ void test_SHT_Insert_SHT_Get(void) {
     // hashed into the same bucket as the name "a".
     TEST_CHECK(*numberOfBlocks == 5); 
 
+    // Every "a" record is printed, even the ones that share a HT block.
+    // The bucket of "a" has two SHT blocks.
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, index_info, "a") == 2);
+    // Both names share one block schedule. We read the single block of "Feb"
+    // and the two blocks of "a".
+    void* names[] = { "Feb", "a", "Alexx" };
+    TEST_CHECK(SHT_SecondaryGetAllEntriesMulti(info, index_info, names, 3) == 3);
+
+    // Every HT block that holds "a" records is fetched once, however many of them it holds.
+    int* aBlockIds;
+    int numOfABlockIds = SHT_SecondaryGetBlockIds(index_info, "a", &aBlockIds);
+    TEST_CHECK(numOfABlockIds > 0 && numOfABlockIds < maxSHT_Entries);
+    numOfBlockReads[info->fileDesc] = 0;
+    SHT_SecondaryGetAllEntries(info, index_info, "a");
+    TEST_CHECK(numOfBlockReads[info->fileDesc] == numOfABlockIds);
+    // A block of both names is fetched once for both of them.
+    int* febBlockIds;
+    int numOfFebBlockIds = SHT_SecondaryGetBlockIds(index_info, "Feb", &febBlockIds);
+    int numOfShared = 0;
+    for(int i = 0; i < numOfABlockIds; i++)
+        if(aBlockIds[i] == febBlockIds[0])
+            numOfShared++;
+    TEST_CHECK(numOfFebBlockIds == 1);
+    numOfBlockReads[info->fileDesc] = 0;
+    SHT_SecondaryGetAllEntriesMulti(info, index_info, names, 3);
+    TEST_CHECK(numOfBlockReads[info->fileDesc] == numOfABlockIds + 1 - numOfShared);
+    free(aBlockIds);
+    free(febBlockIds);
+
     BF_Block *block;
 	BF_Block_Init(&block);
 
@@ -107,6 +150,8 @@ void test_SHT_Insert_SHT_Get(void) {
 	char *data = BF_Block_GetData(block);
     memcpy(&shtRecord, data, sizeof(shtRecord));
     TEST_CHECK(!strcmp("Feb", shtRecord.name));  
+    // The entry carries the hash of its name.
+    TEST_CHECK(shtRecord.hash == hash_string("Feb"));
 
     free(numberOfBlocks);
     free(name);
@@ -119,10 +164,493 @@ void test_SHT_Insert_SHT_Get(void) {
 
 
 
+void test_SHT_Postings(void) {
+	BF_Init(LRU);
+    // The HT file and the SHT_ENTRIES index of the previous test.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    SHT_info* index_info = SHT_OpenSecondaryIndex(INDEX_NAME);
+
+    SHT_options options = SHT_DefaultOptions();
+    options.format = SHT_POSTINGS;
+    TEST_CHECK(SHT_CreateSecondaryIndexWithOptions(POSTINGS_NAME, 10, FILE_NAME, options) == 0);
+    SHT_info* postings_info = SHT_OpenSecondaryIndex(POSTINGS_NAME);
+    TEST_CHECK(postings_info->format == SHT_POSTINGS);
+
+    // Insert the same records into both indexes.
+    Record record;
+    for(int i = 0; i < 25; i++){
+        record = randomRecord_WithSpecificName("b");
+        int block_id = HT_InsertEntry(info, record);
+        SHT_SecondaryInsertEntry(index_info, record, block_id);
+        SHT_SecondaryInsertEntry(postings_info, record, block_id);
+    }
+
+    // Both indexes must find the same blocks.
+    int* entriesIds;
+    int* postingsIds;
+    int numOfEntriesIds = SHT_SecondaryGetBlockIds(index_info, "b", &entriesIds);
+    int numOfPostingsIds = SHT_SecondaryGetBlockIds(postings_info, "b", &postingsIds);
+    TEST_CHECK(numOfEntriesIds > 0);
+    TEST_CHECK(numOfEntriesIds == numOfPostingsIds);
+    TEST_CHECK(!memcmp(entriesIds, postingsIds, numOfEntriesIds * sizeof(int)));
+    free(entriesIds);
+    free(postingsIds);
+
+    // The name is stored once, so we read one SHT_Key block and one postings block.
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, postings_info, "b") == 2);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, postings_info, "Alexx") == -1);
+
+    // Postings that arrive out of order, with duplicates, and span many blocks.
+    record = randomRecord_WithSpecificName("c");
+    for(int i = 0; i < 3000; i++)
+        SHT_SecondaryInsertEntry(postings_info, record, (i * 7919) % 2000);
+    int numOfIds = SHT_SecondaryGetBlockIds(postings_info, "c", &postingsIds);
+    TEST_CHECK(numOfIds == 2000);
+    for(int i = 0; i < numOfIds; i++)
+        TEST_CHECK(postingsIds[i] == i);
+    free(postingsIds);
+
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(index_info);
+    SHT_CloseSecondaryIndex(postings_info);
+    BF_Close();
+}
+
+// Returns the number of temporary files that exist.
+int temporaryFiles(void){
+    glob_t files;
+    int numOfFiles = glob("tmp_*.tmp", 0, NULL, &files) == 0 ? files.gl_pathc : 0;
+    globfree(&files);
+    return numOfFiles;
+}
+
+void test_SHT_BuildFromPrimary(void) {
+	BF_Init(LRU);
+    // Index the HT file of the previous tests in one scan, in both formats.
+    TEST_CHECK(SHT_BuildFromPrimary(BUILT_NAME, 10, FILE_NAME) == 0);
+    SHT_options options = SHT_DefaultOptions();
+    options.format = SHT_POSTINGS;
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(BUILT_POSTINGS_NAME, 10, FILE_NAME, options) == 0);
+
+    // Sorting one pair at a time writes a run for every record, more runs than
+    // BF_MAX_OPEN_FILES, which take more than one pass of the merge.
+    options.buildMemoryBudget = 1;
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(SPILLED_POSTINGS_NAME, 10, FILE_NAME, options) == 0);
+    options.format = SHT_ENTRIES;
+    options.includedColumns = ATTRIBUTE_BIT(CITY);
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(SPILLED_NAME, 10, FILE_NAME, options) == 0);
+    TEST_CHECK(temporaryFiles() == 0);
+
+    SHT_info* index_info = SHT_OpenSecondaryIndex(INDEX_NAME);
+    SHT_info* built_info = SHT_OpenSecondaryIndex(BUILT_NAME);
+    SHT_info* built_postings_info = SHT_OpenSecondaryIndex(BUILT_POSTINGS_NAME);
+    SHT_info* spilled_info = SHT_OpenSecondaryIndex(SPILLED_NAME);
+    SHT_info* spilled_postings_info = SHT_OpenSecondaryIndex(SPILLED_POSTINGS_NAME);
+
+    // Every record of the HT file was also inserted into INDEX_NAME one by one,
+    // so the built indexes must find the same blocks.
+    char* names[] = { "Feb", "a", "b" };
+    for(int i = 0; i < 3; i++){
+        int* expected;
+        int* built;
+        int* builtPostings;
+        int* spilled;
+        int* spilledPostings;
+        int numOfExpected = SHT_SecondaryGetBlockIds(index_info, names[i], &expected);
+        TEST_CHECK(numOfExpected > 0);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(built_info, names[i], &built) == numOfExpected);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(built_postings_info, names[i], &builtPostings) == numOfExpected);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(spilled_info, names[i], &spilled) == numOfExpected);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(spilled_postings_info, names[i], &spilledPostings) == numOfExpected);
+        TEST_CHECK(!memcmp(expected, built, numOfExpected * sizeof(int)));
+        TEST_CHECK(!memcmp(expected, builtPostings, numOfExpected * sizeof(int)));
+        TEST_CHECK(!memcmp(expected, spilled, numOfExpected * sizeof(int)));
+        TEST_CHECK(!memcmp(expected, spilledPostings, numOfExpected * sizeof(int)));
+        free(expected);
+        free(built);
+        free(builtPostings);
+        free(spilled);
+        free(spilledPostings);
+    }
+
+    // The 25 "a" entries are packed into two full blocks, like the ones inserted one by one.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, built_info, "a") == 2);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, built_info, "Alexx") == -1);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, spilled_info, "Feb", ATTRIBUTE_BIT(CITY)) == 1);
+
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(index_info);
+    SHT_CloseSecondaryIndex(built_info);
+    SHT_CloseSecondaryIndex(built_postings_info);
+    SHT_CloseSecondaryIndex(spilled_info);
+    SHT_CloseSecondaryIndex(spilled_postings_info);
+    BF_Close();
+}
+
+void test_SHT_Covering(void) {
+	BF_Init(LRU);
+    // Postings hold only blockIds, they can not include columns.
+    SHT_options options = SHT_DefaultOptions();
+    options.format = SHT_POSTINGS;
+    options.includedColumns = ATTRIBUTE_BIT(CITY);
+    TEST_CHECK(SHT_CreateSecondaryIndexWithOptions(COVERING_NAME, 10, FILE_NAME, options) == -1);
+
+    // Index the HT file of the previous tests with the surname and the city inside the entries.
+    options.format = SHT_ENTRIES;
+    options.includedColumns = ATTRIBUTE_BIT(SURNAME) | ATTRIBUTE_BIT(CITY);
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(COVERING_NAME, 10, FILE_NAME, options) == 0);
+    SHT_info* covering_info = SHT_OpenSecondaryIndex(COVERING_NAME);
+    TEST_CHECK(covering_info->includedColumns == options.includedColumns);
+    TEST_CHECK(covering_info->entrySize == sizeof(SHT_Record) + 2 * 20);
+
+    // Covered projections never need the HT file.
+    int projection = ATTRIBUTE_BIT(NAME) | ATTRIBUTE_BIT(SURNAME) | ATTRIBUTE_BIT(CITY);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, covering_info, "Feb", projection) == 1);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, covering_info, "a", ATTRIBUTE_BIT(CITY)) > 0);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, covering_info, "Alexx", projection) == -1);
+
+    // The id is not included, so it is read from the HT file.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(info, covering_info, "Feb", ATTRIBUTE_BIT(ID)) == 1);
+
+    // Inserted entries carry their included columns too.
+    Record record = randomRecord_WithSpecificName("Covered");
+    int blockId = HT_InsertEntry(info, record);
+    TEST_CHECK(SHT_SecondaryInsertEntry(covering_info, record, blockId) == 0);
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, covering_info, "Covered", projection) > 0);
+
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(covering_info);
+    BF_Close();
+}
+
+void test_SHT_KeyAttribute(void) {
+	BF_Init(LRU);
+    // A record with a city and an id that no other record has.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    Record record = randomRecord_WithSpecificName("Keyed");
+    record.id = 123456;
+    strcpy(record.city, "Keytown");
+    int blockId = HT_InsertEntry(info, record);
+	HT_CloseFile(info);
+
+    // Index the HT file on the city and on the id.
+    SHT_options options = SHT_DefaultOptions();
+    options.keyAttributes[0] = CITY;
+    options.format = SHT_POSTINGS;
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(CITY_NAME, 10, FILE_NAME, options) == 0);
+    options.keyAttributes[0] = ID;
+    options.format = SHT_ENTRIES;
+    options.includedColumns = ATTRIBUTE_BIT(NAME);
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(ID_NAME, 10, FILE_NAME, options) == 0);
+    SHT_info* city_info = SHT_OpenSecondaryIndex(CITY_NAME);
+    SHT_info* id_info = SHT_OpenSecondaryIndex(ID_NAME);
+    TEST_CHECK(city_info->keyAttributes[0] == CITY);
+    TEST_CHECK(id_info->keyAttributes[0] == ID);
+    // The int key slot, the blockId, the hash and the name.
+    TEST_CHECK(id_info->entrySize == 3 * sizeof(int) + 15);
+
+    int* blockIds;
+    TEST_CHECK(SHT_SecondaryGetBlockIds(city_info, "Keytown", &blockIds) == 1);
+    TEST_CHECK(blockIds[0] == blockId);
+    free(blockIds);
+    int id = 123456;
+    TEST_CHECK(SHT_SecondaryGetBlockIds(id_info, &id, &blockIds) == 1);
+    TEST_CHECK(blockIds[0] == blockId);
+    free(blockIds);
+    id = -1;
+    TEST_CHECK(SHT_SecondaryGetBlockIds(id_info, &id, &blockIds) == 0);
+    free(blockIds);
+
+    // The name is included, so the id index answers it on its own.
+    id = 123456;
+    TEST_CHECK(SHT_SecondaryGetAllEntriesProjected(NULL, id_info, &id, ATTRIBUTE_BIT(ID) | ATTRIBUTE_BIT(NAME)) == 1);
+
+    // Inserted records are found by their city too.
+    info = HT_OpenFile(FILE_NAME);
+    strcpy(record.name, "Keyed2");
+    record.id = 123457;
+    int secondBlockId = HT_InsertEntry(info, record);
+    TEST_CHECK(SHT_SecondaryInsertEntry(city_info, record, secondBlockId) == 0);
+    int numOfBlockIds = SHT_SecondaryGetBlockIds(city_info, "Keytown", &blockIds);
+    TEST_CHECK(numOfBlockIds == (secondBlockId == blockId ? 1 : 2));
+    free(blockIds);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, city_info, "Keytown") > 0);
+
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(city_info);
+    SHT_CloseSecondaryIndex(id_info);
+    BF_Close();
+}
+
+void test_SHT_CompositeKey(void) {
+	BF_Init(LRU);
+    // Two records with the same city but different surnames.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    Record first = randomRecord_WithSpecificName("Composite");
+    strcpy(first.surname, "Surname1");
+    strcpy(first.city, "Bigtown");
+    Record second = first;
+    strcpy(second.surname, "Surname2");
+    int firstBlockId = HT_InsertEntry(info, first);
+	HT_CloseFile(info);
+
+    SHT_options options = SHT_DefaultOptions();
+    options.format = SHT_POSTINGS;
+    options.keyAttributes[0] = CITY;
+    options.keyAttributes[1] = CITY;
+    options.numOfKeyAttributes = 2;
+    // A key can not repeat an attribute.
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(COMPOSITE_NAME, 10, FILE_NAME, options) == -1);
+    options.keyAttributes[1] = SURNAME;
+    TEST_CHECK(SHT_BuildFromPrimaryWithOptions(COMPOSITE_NAME, 10, FILE_NAME, options) == 0);
+    SHT_info* composite_info = SHT_OpenSecondaryIndex(COMPOSITE_NAME);
+    TEST_CHECK(composite_info->numOfKeyAttributes == 2);
+    TEST_CHECK(composite_info->keySize == 40);
+
+    // The lookup takes the whole (city, surname) tuple.
+    int* blockIds;
+    TEST_CHECK(SHT_SecondaryGetBlockIds(composite_info, &first, &blockIds) == 1);
+    TEST_CHECK(blockIds[0] == firstBlockId);
+    free(blockIds);
+    TEST_CHECK(SHT_SecondaryGetBlockIds(composite_info, &second, &blockIds) == 0);
+    free(blockIds);
+
+    // Inserted records are found by their tuple and only by it.
+    info = HT_OpenFile(FILE_NAME);
+    int secondBlockId = HT_InsertEntry(info, second);
+    TEST_CHECK(SHT_SecondaryInsertEntry(composite_info, second, secondBlockId) == 0);
+    TEST_CHECK(SHT_SecondaryGetBlockIds(composite_info, &second, &blockIds) == 1);
+    TEST_CHECK(blockIds[0] == secondBlockId);
+    free(blockIds);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, composite_info, &second) > 0);
+
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(composite_info);
+    BF_Close();
+}
+
+// The records of the primary file, collected by HT_Scan.
+typedef struct {
+    Record* records;
+    int numOfRecords;
+} Collected;
+
+int collectRecord(const Record* record, void* argument){
+    Collected* collected = argument;
+    collected->records = realloc(collected->records, (collected->numOfRecords + 1) * sizeof(Record));
+    collected->records[collected->numOfRecords++] = *record;
+    return 0;
+}
+
+// The pairs that SHT_IndexJoin passed to the callback.
+typedef struct {
+    int numOfPairs;
+    long sumOfIds;                  // Sum of the ids of the inner records.
+    bool sameNames;                 // False if a pair has different names.
+    int limit;                      // Stop after limit pairs, -1 for no limit.
+} JoinPairs;
+
+int collectJoinPair(const Record* outer, const Record* inner, void* argument){
+    JoinPairs* pairs = argument;
+    pairs->numOfPairs++;
+    pairs->sumOfIds += inner->id;
+    if(strcmp(outer->name, inner->name))
+        pairs->sameNames = false;
+    return pairs->numOfPairs == pairs->limit;
+}
+
+// Returns the primary blocks that SHT_IndexJoin must fetch for the outer records:
+// the distinct blocks of the keys of every batch, summed over the batches.
+int blocksOfBatches(HT_info* info, SHT_info* index_info, Record* outer, int numOfOuter){
+    int numOfBlocks;
+    BF_GetBlockCounter(info->fileDesc, &numOfBlocks);
+    bool* fetched = malloc(numOfBlocks * sizeof(bool));
+    int blocks = 0;
+    for(int first = 0; first < numOfOuter; first += SHT_JOIN_BATCH){
+        memset(fetched, 0, numOfBlocks * sizeof(bool));
+        for(int r = first; r < numOfOuter && r < first + SHT_JOIN_BATCH; r++){
+            int* blockIds;
+            int numOfBlockIds = SHT_SecondaryGetBlockIds(index_info, outer[r].name, &blockIds);
+            for(int i = 0; i < numOfBlockIds; i++){
+                blocks += !fetched[blockIds[i]];
+                fetched[blockIds[i]] = true;
+            }
+            free(blockIds);
+        }
+    }
+    free(fetched);
+    return blocks;
+}
+
+void test_SHT_IndexJoin(void) {
+	BF_Init(LRU);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    SHT_info* built_info = SHT_OpenSecondaryIndex(BUILT_NAME);
+    SHT_info* built_postings_info = SHT_OpenSecondaryIndex(BUILT_POSTINGS_NAME);
+    Collected collected = { NULL, 0 };
+    HT_Scan(info, NULL, collectRecord, &collected);
+
+    // More outer records than one batch, with repeated names and names that are not inside the file.
+    int numOfOuter = SHT_JOIN_BATCH + 100;
+    Record* outer = malloc(numOfOuter * sizeof(Record));
+    char* names[] = { "Feb", "a", "b", "a", "Alexx" };
+    for(int r = 0; r < numOfOuter; r++)
+        outer[r] = r < 5 ? randomRecord_WithSpecificName(names[r]) : randomRecord();
+    int expected = 0;
+    long expectedSum = 0;
+    for(int r = 0; r < numOfOuter; r++)
+        for(int i = 0; i < collected.numOfRecords; i++)
+            if(!strcmp(outer[r].name, collected.records[i].name)){
+                expected++;
+                expectedSum += collected.records[i].id;
+            }
+
+    // Both formats find every pair once, and fetch every primary block once for every batch.
+    int expectedBlocks = blocksOfBatches(info, built_info, outer, numOfOuter);
+    TEST_CHECK(expectedBlocks > 0);
+    numOfBlockReads[info->fileDesc] = 0;
+    JoinPairs pairs = { 0, 0, true, -1 };
+    TEST_CHECK(SHT_IndexJoin(info, built_info, outer, numOfOuter, collectJoinPair, &pairs) == expected);
+    TEST_CHECK(pairs.sumOfIds == expectedSum && pairs.sameNames);
+    TEST_CHECK(numOfBlockReads[info->fileDesc] == expectedBlocks);
+    TEST_MSG("%d primary blocks read, %d expected", numOfBlockReads[info->fileDesc], expectedBlocks);
+    numOfBlockReads[info->fileDesc] = 0;
+    JoinPairs postingsPairs = { 0, 0, true, -1 };
+    TEST_CHECK(SHT_IndexJoin(info, built_postings_info, outer, numOfOuter, collectJoinPair, &postingsPairs) == expected);
+    TEST_CHECK(postingsPairs.sumOfIds == expectedSum && postingsPairs.sameNames);
+    TEST_CHECK(numOfBlockReads[info->fileDesc] == expectedBlocks);
+
+    // The callback stops the join.
+    JoinPairs limited = { 0, 0, true, 3 };
+    TEST_CHECK(SHT_IndexJoin(info, built_info, outer, numOfOuter, collectJoinPair, &limited) == 3);
+
+    free(outer);
+    free(collected.records);
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(built_info);
+    SHT_CloseSecondaryIndex(built_postings_info);
+    BF_Close();
+}
+
+void test_SHT_AllocationFree(void) {
+	BF_Init(LRU);
+    HT_CreateFile(ALLOCATIONS_FILE_NAME, 10);
+    SHT_CreateSecondaryIndex(ALLOCATIONS_INDEX_NAME, 10, ALLOCATIONS_FILE_NAME);
+    SHT_options options = SHT_DefaultOptions();
+    options.format = SHT_POSTINGS;
+    SHT_CreateSecondaryIndexWithOptions(ALLOCATIONS_POSTINGS_NAME, 10, ALLOCATIONS_FILE_NAME, options);
+    HT_info* info = HT_OpenFile(ALLOCATIONS_FILE_NAME);
+    SHT_info* index_info = SHT_OpenSecondaryIndex(ALLOCATIONS_INDEX_NAME);
+    SHT_info* postings_info = SHT_OpenSecondaryIndex(ALLOCATIONS_POSTINGS_NAME);
+    int numOfRecords = 3 * RECORDS_NUM;
+    Record* records = malloc(numOfRecords * sizeof(Record));
+    for(int r = 0; r < numOfRecords; r++)
+        records[r] = randomRecord();
+
+    // The inserts allocate new buckets, entry blocks, SHT_Key blocks and postings blocks,
+    // with the handles of the infos only. The allocations of libbf itself are not counted.
+    long allocations = numOfAllocations;
+    for(int r = 0; r < numOfRecords; r++){
+        int blockId = HT_InsertEntry(info, records[r]);
+        SHT_SecondaryInsertEntry(index_info, records[r], blockId);
+        SHT_SecondaryInsertEntry(postings_info, records[r], blockId);
+    }
+    TEST_CHECK(numOfAllocations == allocations);
+
+    // The first lookups make room for the blockIds inside the infos, the next ones reuse it.
+    for(int r = 0; r < 3; r++){
+        SHT_SecondaryGetAllEntries(info, index_info, records[r].name);
+        SHT_SecondaryGetAllEntries(info, postings_info, records[r].name);
+    }
+    allocations = numOfAllocations;
+    for(int r = 0; r < 3; r++){
+        TEST_CHECK(SHT_SecondaryGetAllEntries(info, index_info, records[r].name) != -1);
+        TEST_CHECK(SHT_SecondaryGetAllEntries(info, postings_info, records[r].name) != -1);
+    }
+    TEST_CHECK(numOfAllocations == allocations);
+
+    free(records);
+	HT_CloseFile(info);
+    SHT_CloseSecondaryIndex(index_info);
+    SHT_CloseSecondaryIndex(postings_info);
+    BF_Close();
+}
+
+void test_SHT_OpenSecondaryIndexReadOnly(void) {
+	BF_Init(LRU);
+    // The files of the previous tests, opened for the lookups of the BF level and read-only.
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    SHT_info* built_info = SHT_OpenSecondaryIndex(BUILT_NAME);
+    HT_info* mapped_info = HT_OpenFileReadOnly(FILE_NAME);
+    SHT_info* mapped_built_info = SHT_OpenSecondaryIndexReadOnly(BUILT_NAME);
+    SHT_info* mapped_postings_info = SHT_OpenSecondaryIndexReadOnly(BUILT_POSTINGS_NAME);
+    TEST_CHECK(mapped_info != NULL && mapped_built_info != NULL && mapped_postings_info != NULL);
+    TEST_CHECK(mapped_built_info->readOnly && !built_info->readOnly);
+
+    // Both formats find the same blocks inside their mappings.
+    char* names[] = { "Feb", "a", "b", "Alexx" };
+    for(int i = 0; i < 4; i++){
+        int* expected;
+        int* mapped;
+        int* mappedPostings;
+        int numOfExpected = SHT_SecondaryGetBlockIds(built_info, names[i], &expected);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(mapped_built_info, names[i], &mapped) == numOfExpected);
+        TEST_CHECK(SHT_SecondaryGetBlockIds(mapped_postings_info, names[i], &mappedPostings) == numOfExpected);
+        TEST_CHECK(!memcmp(expected, mapped, numOfExpected * sizeof(int)));
+        TEST_CHECK(!memcmp(expected, mappedPostings, numOfExpected * sizeof(int)));
+        free(expected);
+        free(mapped);
+        free(mappedPostings);
+    }
+
+    // The lookups read the primary file from its mapping too, or through the BF level.
+    TEST_CHECK(SHT_SecondaryGetAllEntries(mapped_info, mapped_built_info, "a") == 2);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(info, mapped_built_info, "a") == 2);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(mapped_info, built_info, "a") == 2);
+    TEST_CHECK(SHT_SecondaryGetAllEntries(mapped_info, mapped_built_info, "Alexx") == -1);
+
+    // The joins find the same pairs.
+    int numOfOuter = SHT_JOIN_BATCH + 100;
+    Record* outer = malloc(numOfOuter * sizeof(Record));
+    for(int r = 0; r < numOfOuter; r++)
+        outer[r] = r < 4 ? randomRecord_WithSpecificName(names[r]) : randomRecord();
+    JoinPairs pairs = { 0, 0, true, -1 };
+    int expected = SHT_IndexJoin(info, built_info, outer, numOfOuter, collectJoinPair, &pairs);
+    JoinPairs mappedPairs = { 0, 0, true, -1 };
+    TEST_CHECK(SHT_IndexJoin(mapped_info, mapped_built_info, outer, numOfOuter, collectJoinPair, &mappedPairs) == expected);
+    TEST_CHECK(mappedPairs.sumOfIds == pairs.sumOfIds && mappedPairs.sameNames);
+    JoinPairs postingsPairs = { 0, 0, true, -1 };
+    TEST_CHECK(SHT_IndexJoin(mapped_info, mapped_postings_info, outer, numOfOuter, collectJoinPair, &postingsPairs) == expected);
+    TEST_CHECK(postingsPairs.sumOfIds == pairs.sumOfIds && postingsPairs.sameNames);
+
+    // The indexes can not be changed.
+    Record record = randomRecord_WithSpecificName("a");
+    TEST_CHECK(SHT_SecondaryInsertEntry(mapped_built_info, record, 2) == -1);
+    TEST_CHECK(SHT_SecondaryInsertEntry(mapped_postings_info, record, 2) == -1);
+
+    free(outer);
+	HT_CloseFile(info);
+	HT_CloseFile(mapped_info);
+    SHT_CloseSecondaryIndex(built_info);
+    SHT_CloseSecondaryIndex(mapped_built_info);
+    SHT_CloseSecondaryIndex(mapped_postings_info);
+    BF_Close();
+}
+
 // List of all the tests
 TEST_LIST = {
 	{ "SHT_CreateSecondaryIndex", test_SHT_CreateSecondaryIndex },
 	{ "SHT_OpenSecondaryIndex", test_SHT_OpenSecondaryIndex },
 	{ "SHT_InsertEntry\n     SHT_GetAllEntries", test_SHT_Insert_SHT_Get},
+	{ "SHT_POSTINGS", test_SHT_Postings},
+	{ "SHT_BuildFromPrimary", test_SHT_BuildFromPrimary},
+	{ "SHT included columns", test_SHT_Covering},
+	{ "SHT key attribute", test_SHT_KeyAttribute},
+	{ "SHT composite key", test_SHT_CompositeKey},
+	{ "SHT_IndexJoin", test_SHT_IndexJoin},
+	{ "Insert and lookup without allocations outside libbf", test_SHT_AllocationFree},
+	{ "SHT_OpenSecondaryIndexReadOnly", test_SHT_OpenSecondaryIndexReadOnly},
 	{ NULL, NULL } // end the test list with a NULL
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glob.h>
+
+#include "../include/acutest.h" // A simple library for unit testing
+#include "../include/bf.h"
+#include "../include/ht_table.h"
+#include "../include/bp_table.h"
+#include "../include/sort.h"
+#include "../include/record.h"
+
+#define RECORDS_NUM 500
+#define FILE_NAME "data.db"
+#define TREE_NAME "sorted.db"
+
+// The records that SORT_Records passed to the callback.
+typedef struct {
+    Record records[RECORDS_NUM];
+    int numOfRecords;
+    int limit;                      // Stop after limit records, -1 for no limit.
+} Sorted;
+
+int collectRecord(const Record* record, void* argument){
+    Sorted* sorted = argument;
+    sorted->records[sorted->numOfRecords++] = *record;
+    return sorted->numOfRecords == sorted->limit;
+}
+
+// Returns true if the records are in order of the city, and of the id for the same city.
+bool inCityOrder(Sorted* sorted){
+    for(int r = 1; r < sorted->numOfRecords; r++){
+        int result = strcmp(sorted->records[r - 1].city, sorted->records[r].city);
+        if(result > 0 || (result == 0 && sorted->records[r - 1].id >= sorted->records[r].id))
+            return false;
+    }
+    return true;
+}
+
+// Returns the number of temporary files that exist.
+int temporaryFiles(void){
+    glob_t files;
+    int numOfFiles = glob("tmp_*.tmp", 0, NULL, &files) == 0 ? files.gl_pathc : 0;
+    globfree(&files);
+    return numOfFiles;
+}
+
+void test_SORT_Records(void) {
+	BF_Init(LRU);
+    HT_CreateFile(FILE_NAME, 10);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    srand(12569874);
+    // The ids are inserted out of order, 7 apart modulo RECORDS_NUM.
+    Record records[RECORDS_NUM];
+    for(int r = 0; r < RECORDS_NUM; r++){
+        int id = (r * 7) % RECORDS_NUM;
+        records[id] = randomRecord_WithSpecificID(id);
+        HT_InsertEntry(info, records[id]);
+    }
+
+    // Everything fits inside the default budget.
+    Sorted* sorted = malloc(sizeof(Sorted));
+    sorted->numOfRecords = 0;
+    sorted->limit = -1;
+    SORT_options options = SORT_DefaultOptions(ID);
+    TEST_CHECK(SORT_Records(info, NULL, &options, collectRecord, sorted) == RECORDS_NUM);
+    bool allInOrder = true;
+    for(int r = 0; r < RECORDS_NUM; r++)
+        if(sorted->records[r].id != r || strcmp(sorted->records[r].city, records[r].city))
+            allInOrder = false;
+    TEST_CHECK(allInOrder);
+
+    // Runs of 7 records, 72 of them, need two passes of the merge.
+    sorted->numOfRecords = 0;
+    options = SORT_DefaultOptions(CITY);
+    options.memoryBudget = 7 * sizeof(Record);
+    TEST_CHECK(SORT_Records(info, NULL, &options, collectRecord, sorted) == RECORDS_NUM);
+    TEST_CHECK(inCityOrder(sorted));
+    long sumOfIds = 0;
+    for(int r = 0; r < RECORDS_NUM; r++)
+        sumOfIds += sorted->records[r].id;
+    TEST_CHECK(sumOfIds == (long)RECORDS_NUM * (RECORDS_NUM - 1) / 2);
+    TEST_CHECK(temporaryFiles() == 0);
+
+    // Runs of 2 records, 250 of them, more than BF_MAX_OPEN_FILES.
+    sorted->numOfRecords = 0;
+    options.memoryBudget = 2 * sizeof(Record);
+    TEST_CHECK(SORT_Records(info, NULL, &options, collectRecord, sorted) == RECORDS_NUM);
+    TEST_CHECK(inCityOrder(sorted));
+    TEST_CHECK(temporaryFiles() == 0);
+
+    // Only the people of a city, with a run of one record each.
+    sorted->numOfRecords = 0;
+    HT_Predicate predicate = HT_AllRecords();
+    predicate.city = records[0].city;
+    options.memoryBudget = sizeof(Record);
+    int count = 0;
+    for(int id = 0; id < RECORDS_NUM; id++)
+        if(!strcmp(records[id].city, records[0].city))
+            count++;
+    TEST_CHECK(SORT_Records(info, &predicate, &options, collectRecord, sorted) == count);
+    TEST_CHECK(inCityOrder(sorted) && sorted->records[0].id == 0);
+
+    // The callback stops the sort, and the runs are deleted.
+    sorted->numOfRecords = 0;
+    sorted->limit = 10;
+    options.memoryBudget = 50 * sizeof(Record);
+    TEST_CHECK(SORT_Records(info, NULL, &options, collectRecord, sorted) == 10);
+    TEST_CHECK(temporaryFiles() == 0);
+
+    // The budget must hold at least one record.
+    options.memoryBudget = sizeof(Record) - 1;
+    TEST_CHECK(SORT_Records(info, NULL, &options, collectRecord, sorted) == -1);
+
+    free(sorted);
+	HT_CloseFile(info);
+    BF_Close();
+}
+
+void test_SORT_BulkLoad(void) {
+	BF_Init(LRU);
+    HT_info* info = HT_OpenFile(FILE_NAME);
+    TEST_CHECK(SORT_BulkLoad(info, TREE_NAME, 20 * sizeof(Record)) == RECORDS_NUM);
+	HT_CloseFile(info);
+
+    // 84 leaves, 83 of them full, two internal nodes above them and the root.
+    BP_info* tree = BP_OpenFile(TREE_NAME);
+    TEST_CHECK(tree != NULL);
+    TEST_CHECK(tree->height == 3);
+    // The root, one internal node and the leaves of 0-5, 6-11, 12-17 and 18-23.
+    TEST_CHECK(BP_GetRangeEntries(tree, 0, 20) == 2 + 4);
+    TEST_CHECK(BP_GetAllEntries(tree, RECORDS_NUM - 1) == 3);
+	BP_CloseFile(tree);
+    BF_Close();
+}
+
+// List of all the tests
+TEST_LIST = {
+	{ "SORT_Records", test_SORT_Records },
+	{ "SORT_BulkLoad", test_SORT_BulkLoad },
+	{ NULL, NULL } // end the test list with a NULL
+};
@@ -0,0 +1,44 @@
+#ifndef WRAPPERS_H
+#define WRAPPERS_H
+#include <stdlib.h>
+#include "../include/bf.h"
+
+// Wrappers that the Makefile links into a test with -Wl,--wrap, so the calls of the test
+// and of the src files go through them. libbf.so is linked dynamically and calls the real
+// functions, so its own calls are not counted.
+
+// Number of calls of malloc, calloc and realloc by the test and the src files, not by libbf.
+static long numOfAllocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t number, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size){
+    numOfAllocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t number, size_t size){
+    numOfAllocations++;
+    return __real_calloc(number, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size){
+    numOfAllocations++;
+    return __real_realloc(pointer, size);
+}
+
+// Number of blocks that BF_GetBlock pinned for every file descriptor, for the test and the src files.
+// A test sets it to zero before the calls that it checks.
+static int numOfBlockReads[BF_MAX_OPEN_FILES];
+
+BF_ErrorCode __real_BF_GetBlock(const int file_desc, const int block_num, BF_Block *block);
+
+BF_ErrorCode __wrap_BF_GetBlock(const int file_desc, const int block_num, BF_Block *block){
+    if(file_desc >= 0 && file_desc < BF_MAX_OPEN_FILES)
+        numOfBlockReads[file_desc]++;
+    return __real_BF_GetBlock(file_desc, block_num, block);
+}
+
+#endif // WRAPPERS_H